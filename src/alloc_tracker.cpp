@@ -0,0 +1,102 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "alloc_tracker.h"
+
+namespace {
+    constexpr int kNumTags = static_cast<int>(AllocTag::kNumTags);
+
+    std::atomic<uint64_t> allocCount[kNumTags];
+    std::atomic<uint64_t> allocBytes[kNumTags];
+    std::atomic<bool> traceAllocs{false};
+
+#ifdef TRACK_ALLOCATIONS
+    thread_local AllocTag currentTag = AllocTag::kOther;
+    thread_local bool inTrace = false;
+#endif
+}
+
+namespace AllocTracker {
+
+bool Enabled()
+{
+#ifdef TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocCounts Snapshot()
+{
+    AllocCounts counts;
+    for(int i = 0; i < kNumTags; ++i) {
+        counts.count[i] = allocCount[i].load(std::memory_order_relaxed);
+        counts.bytes[i] = allocBytes[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+void SetTrace(bool trace)
+{
+    traceAllocs.store(trace, std::memory_order_relaxed);
+}
+
+const char* TagName(AllocTag tag)
+{
+    switch(tag) {
+        case AllocTag::kOther:
+            return "other";
+        case AllocTag::kInput:
+            return "input";
+        case AllocTag::kUpdate:
+            return "update";
+        case AllocTag::kRender:
+            return "render";
+        default:
+            return "unknown";
+    }
+}
+
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+AllocScope::AllocScope(AllocTag tag) :
+    _prevTag(currentTag)
+{
+    currentTag = tag;
+}
+
+AllocScope::~AllocScope()
+{
+    currentTag = _prevTag;
+}
+
+static void* TrackedAlloc(std::size_t size)
+{
+    int tag = static_cast<int>(currentTag);
+    allocCount[tag].fetch_add(1, std::memory_order_relaxed);
+    allocBytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+    // fprintf doesn't come back through operator new, but guard against it anyway
+    if(traceAllocs.load(std::memory_order_relaxed) && !inTrace) {
+        inTrace = true;
+        std::fprintf(stderr, "[alloc] %s: %zu bytes\n", AllocTracker::TagName(currentTag), size);
+        inTrace = false;
+    }
+
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return TrackedAlloc(size); }
+void* operator new[](std::size_t size) { return TrackedAlloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+    file: alloc_tracker.h - optional heap allocation counting. When built with TRACK_ALLOCATIONS the global
+    operator new/delete are replaced with versions that count allocations against the tag of the current
+    AllocScope, so the game loop can report allocations per frame for each subsystem. Without the flag
+    AllocScope is empty and the counters read as zero.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+enum class AllocTag {
+    kOther,
+    kInput,
+    kUpdate,
+    kRender,
+    kNumTags
+};
+
+struct AllocCounts {
+    uint64_t count[static_cast<int>(AllocTag::kNumTags)]{};
+    uint64_t bytes[static_cast<int>(AllocTag::kNumTags)]{};
+};
+
+namespace AllocTracker {
+    // true when the build replaced operator new/delete
+    bool Enabled();
+
+    // totals since the program started
+    AllocCounts Snapshot();
+
+    // print every allocation (tag and size) to stderr while on
+    void SetTrace(bool trace);
+
+    const char* TagName(AllocTag tag);
+}
+
+// tags every allocation made on this thread while the scope is alive
+class AllocScope {
+ public:
+#ifdef TRACK_ALLOCATIONS
+    explicit AllocScope(AllocTag tag);
+    ~AllocScope();
+
+ private:
+    AllocTag _prevTag;
+#else
+    explicit AllocScope(AllocTag) { }
+#endif
+};
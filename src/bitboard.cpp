@@ -0,0 +1,40 @@
+#include <algorithm>
+#include "bitboard.h"
+
+BitBoard::BitBoard() { }
+
+BitBoard::BitBoard(int width, int height)
+{
+    Resize(width, height);
+}
+
+void BitBoard::Resize(int width, int height)
+{
+    _width = width;
+    _height = height;
+    _wordsPerRow = (width + 63) / 64;
+    _words.assign(static_cast<std::size_t>(_wordsPerRow) * height, 0);
+}
+
+void BitBoard::Clear()
+{
+    std::fill(_words.begin(), _words.end(), 0);
+}
+
+void BitBoard::ResetRange(int y, int x0, int x1)
+{
+    if(x0 < 0) x0 = 0;
+    if(x1 > _width) x1 = _width;
+    if(x0 >= x1) return;
+
+    uint64_t *row = Row(y);
+    const int firstWord = x0 >> 6;
+    const int lastWord = (x1 - 1) >> 6;
+
+    for(int w = firstWord; w <= lastWord; ++w) {
+        uint64_t mask = ~uint64_t{0};
+        if(w == firstWord) mask &= (~uint64_t{0} << (x0 & 63));
+        if(w == lastWord) mask &= (~uint64_t{0} >> (63 - ((x1 - 1) & 63)));
+        row[w] &= ~mask;
+    }
+}
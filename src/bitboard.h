@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+    file: bitboard.h - contains class BitBoard, a packed grid holding one bit per board cell.
+    Rows are stored back to back as 64-bit words, so a row (or part of one) can be scanned
+    a word at a time instead of a cell at a time.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BitBoard {
+ public:
+    BitBoard();
+    BitBoard(int width, int height);
+
+    void Resize(int width, int height);
+    void Clear();
+
+    int Width() const { return _width; }
+    int Height() const { return _height; }
+    int WordsPerRow() const { return _wordsPerRow; }
+
+    bool InBounds(int x, int y) const { return (x >= 0) && (x < _width) && (y >= 0) && (y < _height); }
+
+    bool Test(int x, int y) const { return (Row(y)[x >> 6] >> (x & 63)) & 1; }
+    void Set(int x, int y) { Row(y)[x >> 6] |= (uint64_t{1} << (x & 63)); }
+    void Reset(int x, int y) { Row(y)[x >> 6] &= ~(uint64_t{1} << (x & 63)); }
+
+    // clear every bit in row y where x0 <= x < x1
+    void ResetRange(int y, int x0, int x1);
+
+    // all the words, row after row, for copying the whole board out in one go
+    const uint64_t* Data() const { return _words.data(); }
+    std::size_t WordCount() const { return _words.size(); }
+
+    uint64_t* Row(int y) { return &_words[y * _wordsPerRow]; }
+    const uint64_t* Row(int y) const { return &_words[y * _wordsPerRow]; }
+
+    // call fn(x) for every set bit in row y where x0 <= x < x1
+    template <typename Fn>
+    void ForEachSetInRow(int y, int x0, int x1, Fn fn) const
+    {
+        if(x0 < 0) x0 = 0;
+        if(x1 > _width) x1 = _width;
+        if(x0 >= x1) return;
+
+        const uint64_t *row = Row(y);
+        const int firstWord = x0 >> 6;
+        const int lastWord = (x1 - 1) >> 6;
+
+        for(int w = firstWord; w <= lastWord; ++w) {
+            uint64_t bits = row[w];
+            if(w == firstWord) bits &= (~uint64_t{0} << (x0 & 63));
+            if(w == lastWord) bits &= (~uint64_t{0} >> (63 - ((x1 - 1) & 63)));
+
+            while(bits) {
+                fn((w << 6) + __builtin_ctzll(bits));
+                bits &= bits - 1;   // clear the lowest set bit
+            }
+        }
+    }
+
+ private:
+    int _width{0};
+    int _height{0};
+    int _wordsPerRow{0};
+    std::vector<uint64_t> _words;
+};
@@ -0,0 +1,24 @@
+#include <cstdlib>
+#include "blast.h"
+
+BlastPattern::BlastPattern(int radius, BlastShape shape) :
+    _radius(radius < 0 ? 0 : radius),
+    _shape(shape),
+    _halfWidths(2 * _radius + 1, 0)
+{
+    for(int dy = -_radius; dy <= _radius; ++dy) {
+        int w = 0;
+        switch(_shape) {
+            case BlastShape::kSquare:
+                w = _radius;
+                break;
+            case BlastShape::kDiamond:
+                w = _radius - std::abs(dy);
+                break;
+            case BlastShape::kCross:
+                w = (dy == 0) ? _radius : 0;
+                break;
+        }
+        _halfWidths[dy + _radius] = w;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+/*
+    file: blast.h - contains class BlastPattern, the precomputed shape of a bomb's blast. Each row of the
+    blast is stored as a span around the bomb's column, which is turned into word masks and AND'ed against
+    a row of the board, so a blast costs a few word operations per row no matter how many elements exist.
+*/
+
+#include <vector>
+
+enum class BlastShape { kSquare, kDiamond, kCross };
+
+class BlastPattern {
+ public:
+    BlastPattern(int radius, BlastShape shape);
+
+    int Radius() const { return _radius; }
+    BlastShape Shape() const { return _shape; }
+
+    // how far the blast reaches left and right on the row dy rows from the bomb, -1 if it misses the row
+    int HalfWidth(int dy) const { return _halfWidths[dy + _radius]; }
+
+ private:
+    int _radius;
+    BlastShape _shape;
+    std::vector<int> _halfWidths;
+};
@@ -0,0 +1,103 @@
+#include "board_kernels.h"
+#include <algorithm>
+#include "distance_field.h"
+
+// each cell is queued as its x and y packed together, so nothing has to be divided
+static void GenericDistances(const BitBoard &blocked, int32_t source, int32_t *dist, int32_t *queue)
+{
+    const int width = blocked.Width();
+    const int height = blocked.Height();
+    std::fill(dist, dist + static_cast<std::size_t>(width) * height, DISTANCE_UNREACHABLE);
+    dist[source] = 0;
+    queue[0] = ((source / width) << 16) | (source % width);
+    std::size_t head = 0;
+    std::size_t reached = 1;
+    while(head < reached) {
+        const int32_t packed = queue[head++];
+        const int x = packed & 0xffff;
+        const int y = packed >> 16;
+        const int32_t next = dist[y * width + x] + 1;
+        const int nx[4] = {x + 1 < width ? x + 1 : 0, x > 0 ? x - 1 : width - 1, x, x};
+        const int ny[4] = {y, y, y + 1 < height ? y + 1 : 0, y > 0 ? y - 1 : height - 1};
+        for(int d = 0; d < 4; ++d) {
+            int32_t &to = dist[ny[d] * width + nx[d]];
+            if(to == DISTANCE_UNREACHABLE && !blocked.Test(nx[d], ny[d])) {
+                to = next;
+                queue[reached++] = (ny[d] << 16) | nx[d];
+            }
+        }
+    }
+}
+
+template <int W, int H>
+struct FixedBoard {
+    static constexpr int kWordsPerRow = (W + 63) / 64;
+    static constexpr int32_t kCells = W * H;
+    static_assert((W & (W - 1)) == 0 && (H & (H - 1)) == 0, "the wraps are masks, so both sides are powers of two");
+
+    static bool Blocked(const uint64_t *words, int32_t cell)
+    {
+        if(W % 64 == 0) return (words[cell >> 6] >> (cell & 63)) & 1;
+        const int x = cell & (W - 1);
+        return (words[(cell / W) * kWordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    static void Distances(const BitBoard &blocked, int32_t source, int32_t *dist, int32_t *queue)
+    {
+        const uint64_t *words = blocked.Data();
+        std::fill(dist, dist + kCells, DISTANCE_UNREACHABLE);
+        dist[source] = 0;
+        queue[0] = source;
+        int32_t head = 0;
+        int32_t reached = 1;
+        while(head < reached) {
+            const int32_t cell = queue[head++];
+            const int32_t next = dist[cell] + 1;
+            const int32_t row = cell & ~(W - 1);
+            const int32_t around[4] = {row | ((cell + 1) & (W - 1)), row | ((cell - 1) & (W - 1)),
+                                       (cell + W) & (kCells - 1), (cell - W) & (kCells - 1)};
+            for(int d = 0; d < 4; ++d) {
+                const int32_t to = around[d];
+                if(dist[to] == DISTANCE_UNREACHABLE && !Blocked(words, to)) {
+                    dist[to] = next;
+                    queue[reached++] = to;
+                }
+            }
+        }
+    }
+
+    static constexpr BoardKernels Kernels(const char *name)
+    {
+        return {W, H, name, &Distances};
+    }
+};
+
+// the dispatch table, one entry per specialized board size
+static const BoardKernels kSpecialized[] = {
+    FixedBoard<32, 32>::Kernels("32x32"),
+    FixedBoard<64, 64>::Kernels("64x64"),
+    FixedBoard<128, 128>::Kernels("128x128"),
+    FixedBoard<256, 256>::Kernels("256x256"),
+    FixedBoard<1024, 1024>::Kernels("1024x1024"),
+};
+
+static const BoardKernels kGeneric = {0, 0, "generic", &GenericDistances};
+
+const BoardKernels& SelectBoardKernels(int width, int height)
+{
+    for(const BoardKernels &kernels : kSpecialized) {
+        if(kernels.width == width && kernels.height == height) return kernels;
+    }
+    return kGeneric;
+}
+
+const BoardKernels& GenericBoardKernels()
+{
+    return kGeneric;
+}
+
+const BoardKernels* SpecializedBoardKernels(int &count)
+{
+    count = static_cast<int>(sizeof(kSpecialized) / sizeof(kSpecialized[0]));
+    return kSpecialized;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/*
+    file: board_kernels.h - the per-cell loops over the whole board that run on the simulation thread, compiled
+    once for each common square board size with the dimensions as constants, plus a generic version for any
+    other size. DistanceField picks the set for its board once, at construction, from a dispatch table.
+
+    For now that is the distance field's BFS from the head, the one loop that visits every reachable cell
+    each time the head moves. With a power of two width and height the specialized BFS keeps each cell as
+    one index: a step left or right is a mask within the row, a step up or down wraps with a mask over the
+    board, and when the width is a whole number of words the cell's index is also its bit in the plane.
+    The generic BFS has to keep x and y apart and test both edges at every step. The plane copies are
+    left to memcpy, a fixed-size loop was never faster.
+*/
+
+#include <cstdint>
+#include "bitboard.h"
+
+struct BoardKernels {
+    int width;          // the board these are specialized for, 0 for the generic set
+    int height;
+    const char *name;
+
+    // the number of moves from source (a cell index, y * width + x) to every cell not set in blocked,
+    // wrapping at the edges like the snake. Every cell of dist is written, DISTANCE_UNREACHABLE for the
+    // blocked and the unreachable ones, and queue is scratch. Both hold a cell each.
+    void (*distances)(const BitBoard &blocked, int32_t source, int32_t *dist, int32_t *queue);
+};
+
+// the specialized set for this board if there is one, the generic set otherwise
+const BoardKernels& SelectBoardKernels(int width, int height);
+
+// the generic set, which works for any board, for comparing against the specialized ones
+const BoardKernels& GenericBoardKernels();
+
+// every specialized set, for benchmarks
+const BoardKernels* SpecializedBoardKernels(int &count);
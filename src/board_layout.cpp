@@ -0,0 +1,376 @@
+#include "board_layout.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "flood_fill.h"
+#include "random.h"
+
+#define LAYOUT_ROOM_MIN 4         // smallest side of a room
+#define LAYOUT_ROOM_MAX 12        // largest side of a room
+#define LAYOUT_ROOM_TRIES 64      // cells of a band per attempt at placing a room
+
+// splitmix64 of the seed and a salt, so neighbouring bands and cells get unrelated values
+static uint64_t MixSeed(uint64_t seed, uint64_t salt)
+{
+    uint64_t z = seed + (salt + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int Wrap(int v, int n) { return ((v % n) + n) % n; }
+
+// every cell of rows y0 <= y < y1 becomes wall, leaving the bits past the width clear
+static void FillRows(BitBoard &walls, int y0, int y1)
+{
+    const int words = walls.WordsPerRow();
+    const int tail = walls.Width() & 63;
+    const uint64_t lastMask = tail ? ((uint64_t{1} << tail) - 1) : ~uint64_t{0};
+
+    for(int y = y0; y < y1; ++y) {
+        uint64_t *row = walls.Row(y);
+        std::fill(row, row + words, ~uint64_t{0});
+        row[words - 1] &= lastMask;
+    }
+}
+
+// a maze over the cells at odd x and y in the band, carved by a randomized depth first search with an
+// explicit stack. Every band but the first opens a door in its top row to the band above.
+static void GenerateMazeBand(BitBoard &walls, int region, int y0, int y1, Xoshiro256 &random)
+{
+    FillRows(walls, y0, y1);
+
+    const int cols = (walls.Width() - 1) / 2;
+    const int rows = (std::min(y1, walls.Height() - 1) - y0) / 2;
+    if(cols <= 0 || rows <= 0) return;
+
+    auto cellX = [](int c) { return 1 + 2 * c; };
+    auto cellY = [y0](int r) { return y0 + 1 + 2 * r; };
+
+    std::vector<char> visited(static_cast<std::size_t>(cols) * rows, 0);
+    std::vector<int> stack;
+    stack.reserve(visited.size());
+
+    int first = static_cast<int>(random.Below(cols * rows));
+    visited[first] = 1;
+    walls.Reset(cellX(first % cols), cellY(first / cols));
+    stack.push_back(first);
+
+    static const int kStepX[4] = {1, -1, 0, 0};
+    static const int kStepY[4] = {0, 0, 1, -1};
+    while(!stack.empty()) {
+        int cell = stack.back();
+        int c = cell % cols;
+        int r = cell / cols;
+
+        int choices[4];
+        int count = 0;
+        for(int d = 0; d < 4; ++d) {
+            int nc = c + kStepX[d];
+            int nr = r + kStepY[d];
+            if(nc >= 0 && nc < cols && nr >= 0 && nr < rows && !visited[nr * cols + nc]) {
+                choices[count++] = d;
+            }
+        }
+        if(count == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        int d = choices[random.Below(count)];
+        int next = (r + kStepY[d]) * cols + (c + kStepX[d]);
+        visited[next] = 1;
+        walls.Reset(cellX(c) + kStepX[d], cellY(r) + kStepY[d]);    // the wall between them
+        walls.Reset(cellX(c + kStepX[d]), cellY(r + kStepY[d]));
+        stack.push_back(next);
+    }
+
+    // the row above this band's first cells is the wall under the last cells of the band above
+    if(region > 0) {
+        walls.Reset(cellX(static_cast<int>(random.Below(cols))), y0);
+    }
+}
+
+// the row with every cell moved one to the right (so it holds its left neighbour's bit) and one to the left,
+// wrapping at the row's ends like the snake does
+static void ShiftRow(const uint64_t *row, uint64_t *fromLeft, uint64_t *fromRight, int words, int width)
+{
+    const int last = words - 1;
+    const int tail = width & 63;
+    const uint64_t lastMask = tail ? ((uint64_t{1} << tail) - 1) : ~uint64_t{0};
+    const uint64_t firstBit = row[0] & 1;
+    const uint64_t lastBit = (row[last] >> ((width - 1) & 63)) & 1;
+
+    for(int w = 0; w < words; ++w) {
+        fromLeft[w] = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : lastBit);
+        fromRight[w] = (row[w] >> 1) | (w < last ? row[w + 1] << 63 : 0);
+    }
+    fromLeft[last] &= lastMask;
+    fromRight[last] |= firstBit << ((width - 1) & 63);
+}
+
+// one automaton step for a row, 64 cells at a time: a cell is wall if at least five of the nine cells
+// around and including it are, counted with bitwise adders
+static void CaveStepRow(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out,
+                        int words, int width, uint64_t *scratch)
+{
+    const uint64_t *rows[3] = {up, mid, down};
+    uint64_t *left = scratch;
+    uint64_t *right = scratch + words;
+    uint64_t *ones[3] = {scratch + 2 * words, scratch + 3 * words, scratch + 4 * words};
+    uint64_t *twos[3] = {scratch + 5 * words, scratch + 6 * words, scratch + 7 * words};
+
+    // each row's three cells across as a two bit count
+    for(int r = 0; r < 3; ++r) {
+        ShiftRow(rows[r], left, right, words, width);
+        for(int w = 0; w < words; ++w) {
+            uint64_t a = left[w], b = rows[r][w], c = right[w];
+            ones[r][w] = a ^ b ^ c;
+            twos[r][w] = (a & b) | (c & (a ^ b));
+        }
+    }
+
+    // and the three rows added up, count = t0 + 2 * v0 + 4 * v1 + 8 * v2
+    for(int w = 0; w < words; ++w) {
+        uint64_t a = ones[0][w], b = ones[1][w], c = ones[2][w];
+        uint64_t t0 = a ^ b ^ c;
+        uint64_t carry = (a & b) | (c & (a ^ b));
+
+        a = twos[0][w]; b = twos[1][w]; c = twos[2][w];
+        uint64_t u0 = a ^ b ^ c;
+        uint64_t u1 = (a & b) | (c & (a ^ b));
+
+        uint64_t v0 = u0 ^ carry;
+        uint64_t v1 = u1 ^ (u0 & carry);
+        uint64_t v2 = u1 & u0 & carry;
+        out[w] = v2 | (v1 & (v0 | t0));
+    }
+}
+
+// caves from random noise smoothed by LAYOUT_CAVE_STEPS automaton steps. The noise is a hash of the cell,
+// and the band is worked with LAYOUT_CAVE_STEPS extra rows above and below it, so each band comes out
+// exactly as it would if the whole board were worked at once and there are no seams between them.
+static void GenerateCaveBand(BitBoard &walls, uint64_t seed, int y0, int y1)
+{
+    const int width = walls.Width();
+    const int height = walls.Height();
+    const int words = walls.WordsPerRow();
+    const int halo = LAYOUT_CAVE_STEPS;
+    const int rows = (y1 - y0) + 2 * halo;
+
+    std::vector<uint64_t> cur(static_cast<std::size_t>(rows) * words, 0);
+    std::vector<uint64_t> next(cur.size(), 0);
+    std::vector<uint64_t> scratch(8 * static_cast<std::size_t>(words));
+
+    for(int i = 0; i < rows; ++i) {
+        int y = Wrap(y0 - halo + i, height);
+        uint64_t *row = &cur[static_cast<std::size_t>(i) * words];
+        for(int x = 0; x < width; ++x) {
+            if(MixSeed(seed, static_cast<uint64_t>(y) * width + x) % 100 < LAYOUT_CAVE_FILL) {
+                row[x >> 6] |= uint64_t{1} << (x & 63);
+            }
+        }
+    }
+
+    // the outermost rows go stale by one more row each step, the halo covers them
+    for(int step = 0; step < LAYOUT_CAVE_STEPS; ++step) {
+        for(int i = 0; i < rows; ++i) {
+            uint64_t *out = &next[static_cast<std::size_t>(i) * words];
+            const uint64_t *mid = &cur[static_cast<std::size_t>(i) * words];
+            if(i == 0 || i == rows - 1) {
+                std::copy(mid, mid + words, out);
+            } else {
+                CaveStepRow(mid - words, mid, mid + words, out, words, width, scratch.data());
+            }
+        }
+        cur.swap(next);
+    }
+
+    for(int y = y0; y < y1; ++y) {
+        const uint64_t *src = &cur[static_cast<std::size_t>(y - y0 + halo) * words];
+        std::copy(src, src + words, walls.Row(y));
+    }
+}
+
+// rooms scattered through the band where they fit with a wall around them, each joined to the nearest room
+// placed before it by an L shaped corridor. Bands are joined to each other by the connect pass.
+static void GenerateRoomsBand(BitBoard &walls, int y0, int y1, Xoshiro256 &random)
+{
+    FillRows(walls, y0, y1);
+
+    const int width = walls.Width();
+    const int maxW = std::min(LAYOUT_ROOM_MAX, width - 2);
+    const int maxH = std::min(LAYOUT_ROOM_MAX, (y1 - y0) - 2);
+    if(maxW < LAYOUT_ROOM_MIN || maxH < LAYOUT_ROOM_MIN) return;
+
+    std::vector<SDL_Rect> rooms;
+
+    const int tries = std::max(1, (y1 - y0) * width / LAYOUT_ROOM_TRIES);
+    for(int t = 0; t < tries; ++t) {
+        SDL_Rect room;
+        room.w = random.Between(LAYOUT_ROOM_MIN, maxW);
+        room.h = random.Between(LAYOUT_ROOM_MIN, maxH);
+        room.x = random.Between(1, width - 1 - room.w);
+        room.y = random.Between(y0 + 1, y1 - 1 - room.h);
+
+        // only where it and the wall around it are still solid
+        bool solid = true;
+        for(int y = room.y - 1; y <= room.y + room.h && solid; ++y) {
+            for(int x = room.x - 1; x <= room.x + room.w; ++x) {
+                if(!walls.Test(x, y)) {
+                    solid = false;
+                    break;
+                }
+            }
+        }
+        if(!solid) continue;
+
+        for(int y = room.y; y < room.y + room.h; ++y) {
+            walls.ResetRange(y, room.x, room.x + room.w);
+        }
+
+        int cx = room.x + room.w / 2;
+        int cy = room.y + room.h / 2;
+        const SDL_Rect *nearest = nullptr;
+        int best = 0;
+        for(const SDL_Rect &other : rooms) {
+            int d = std::abs(other.x + other.w / 2 - cx) + std::abs(other.y + other.h / 2 - cy);
+            if(!nearest || d < best) {
+                nearest = &other;
+                best = d;
+            }
+        }
+        if(nearest) {
+            int ox = nearest->x + nearest->w / 2;
+            int oy = nearest->y + nearest->h / 2;
+            walls.ResetRange(oy, std::min(ox, cx), std::max(ox, cx) + 1);
+            for(int y = std::min(oy, cy); y <= std::max(oy, cy); ++y) {
+                walls.Reset(cx, y);
+            }
+        }
+        rooms.push_back(room);
+    }
+}
+
+static void GenerateRegion(BoardLayout layout, uint64_t seed, int region, BitBoard &walls)
+{
+    const int y0 = region * LAYOUT_REGION_ROWS;
+    const int y1 = std::min(y0 + LAYOUT_REGION_ROWS, walls.Height());
+    Xoshiro256 random(MixSeed(seed, region));
+
+    switch(layout) {
+        case BoardLayout::kMaze:
+            GenerateMazeBand(walls, region, y0, y1, random);
+            break;
+        case BoardLayout::kCave:
+            GenerateCaveBand(walls, seed, y0, y1);
+            break;
+        case BoardLayout::kRooms:
+            GenerateRoomsBand(walls, y0, y1, random);
+            break;
+        case BoardLayout::kPerimeter:
+            break;
+    }
+}
+
+// clear the snake's start and the cells it is about to run into, then flood fill from there and dig a
+// straight tunnel (across, then up or down) from every pocket left over until it meets the filled cells
+static int ConnectToStart(BitBoard &walls, SDL_Point start)
+{
+    const int width = walls.Width();
+    const int height = walls.Height();
+
+    for(int dy = -LAYOUT_START_CLEARANCE; dy <= LAYOUT_START_CLEARANCE; ++dy) {
+        for(int dx = -LAYOUT_START_CLEARANCE; dx <= LAYOUT_START_CLEARANCE; ++dx) {
+            walls.Reset(Wrap(start.x + dx, width), Wrap(start.y + dy, height));
+        }
+    }
+    for(int i = 1; i <= LAYOUT_START_RUNWAY; ++i) {
+        walls.Reset(start.x, Wrap(start.y - i, height));
+    }
+
+    BitBoard open;
+    InvertBoard(walls, open);
+    BitBoard reached(width, height);
+    reached.Set(start.x, start.y);
+    FloodFill(open, reached, true);
+
+    int tunnels = 0;
+    const int words = open.WordsPerRow();
+    for(int y = 0; y < height; ++y) {
+        for(int w = 0; w < words; ++w) {
+            uint64_t pocket;
+            while((pocket = open.Row(y)[w] & ~reached.Row(y)[w]) != 0) {
+                const int x = (w << 6) + __builtin_ctzll(pocket);
+
+                int cx = x, cy = y;
+                while(!reached.Test(cx, cy)) {
+                    if(walls.Test(cx, cy)) {
+                        walls.Reset(cx, cy);
+                        open.Set(cx, cy);
+                    }
+                    if(cx != start.x) {
+                        cx += (start.x > cx) ? 1 : -1;
+                    } else {
+                        cy += (start.y > cy) ? 1 : -1;
+                    }
+                }
+                FloodFillFrom(open, reached, x, y, true);
+                ++tunnels;
+            }
+        }
+    }
+    return tunnels;
+}
+
+const char* LayoutName(BoardLayout layout)
+{
+    switch(layout) {
+        case BoardLayout::kPerimeter: return "perimeter";
+        case BoardLayout::kMaze: return "maze";
+        case BoardLayout::kCave: return "cave";
+        case BoardLayout::kRooms: return "rooms";
+    }
+    return "unknown";
+}
+
+LayoutStats GenerateLayout(BoardLayout layout, uint64_t seed, SDL_Point start, BitBoard &walls, int threads)
+{
+    using Clock = std::chrono::steady_clock;
+    LayoutStats stats;
+    walls.Clear();
+    if(layout == BoardLayout::kPerimeter || walls.Width() <= 0 || walls.Height() <= 0) return stats;
+
+    // the bands are a fixed size, the threads only decide who works on which
+    stats.regions = (walls.Height() + LAYOUT_REGION_ROWS - 1) / LAYOUT_REGION_ROWS;
+    if(threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    stats.threads = std::max(1, std::min(threads, stats.regions));
+
+    // every band writes only its own rows, so the workers never share a word
+    Clock::time_point begin = Clock::now();
+    std::atomic<int> nextRegion{0};
+    auto work = [&]() {
+        int region;
+        while((region = nextRegion.fetch_add(1)) < stats.regions) {
+            GenerateRegion(layout, seed, region, walls);
+        }
+    };
+    std::vector<std::thread> workers;
+    for(int t = 1; t < stats.threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+    Clock::time_point generated = Clock::now();
+
+    stats.tunnels = ConnectToStart(walls, start);
+    Clock::time_point connected = Clock::now();
+
+    stats.generateMs = std::chrono::duration<double, std::milli>(generated - begin).count();
+    stats.connectMs = std::chrono::duration<double, std::milli>(connected - generated).count();
+    return stats;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+    file: board_layout.h - seeded procedural board layouts: a maze, caves grown by a cellular automaton, and
+    rooms joined by corridors. The board is cut into fixed bands of rows that are generated independently,
+    on as many threads as there are cores, each band from its own seed so the layout only depends on the
+    seed and never on the number of threads. A sequential pass then flood fills the open cells from the
+    snake's start and tunnels every pocket it didn't reach back to it, so the whole board can be traveled.
+*/
+
+#include <cstdint>
+#include "SDL.h"
+#include "bitboard.h"
+
+#define LAYOUT_REGION_ROWS 128       // rows per independently generated band, even so maze cells line up
+#define LAYOUT_CAVE_FILL 45          // percent of cells a cave starts out as wall
+#define LAYOUT_CAVE_STEPS 4          // cellular automaton steps smoothing the caves
+#define LAYOUT_START_CLEARANCE 2     // cells kept open on every side of the snake's start
+#define LAYOUT_START_RUNWAY 8        // cells kept open ahead of the snake, which starts moving up
+
+enum class BoardLayout { kPerimeter, kMaze, kCave, kRooms };
+
+const char* LayoutName(BoardLayout layout);
+
+struct LayoutStats {
+    int regions{0};
+    int threads{0};
+    int tunnels{0};             // passages dug to join pockets the generator left cut off
+    double generateMs{0.0};     // the bands, in parallel
+    double connectMs{0.0};      // the flood fill and tunnels, on the calling thread
+};
+
+// fill walls (already sized to the board) with the layout's walls. Every open cell is left reachable from
+// start, with the board's edges joined the way the snake wraps. Threads of 0 uses every core.
+// kPerimeter isn't generated here, Game builds it as it always has.
+LayoutStats GenerateLayout(BoardLayout layout, uint64_t seed, SDL_Point start, BitBoard &walls, int threads = 0);
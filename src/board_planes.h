@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+    file: board_planes.h - the bitplanes Game::WriteBitplanes produces for the training environment and the
+    shared memory export. Each plane has one bit per cell in the BitBoard layout: bit (x & 63) of word
+    y * wordsPerRow + (x >> 6).
+*/
+
+enum BoardPlane {
+  kPlaneBody,         // snake body (not the head)
+  kPlaneHead,
+  kPlaneFood,
+  kPlaneBoard,        // every cell the game considers occupied (board_bits)
+  kPlaneWall,
+  kPlanePotion,
+  kPlaneBomb,
+  kPlaneShrinkPill,
+  kPlaneSlowPill,
+  NUM_BOARD_PLANES
+};
@@ -0,0 +1,59 @@
+#include "camera.h"
+#include <algorithm>
+
+Camera::Camera(std::size_t screen_width, std::size_t screen_height,
+               std::size_t grid_width, std::size_t grid_height, std::size_t view_cells)
+    : screen_width(static_cast<int>(screen_width)),
+      screen_height(static_cast<int>(screen_height)),
+      grid_width(static_cast<int>(grid_width)),
+      grid_height(static_cast<int>(grid_height)),
+      _maxViewCells(std::max(1, std::min(this->grid_width, this->screen_width / MIN_BLOCK_SIZE)))
+{
+  SetViewCells(view_cells > 0 ? static_cast<int>(view_cells) : _maxViewCells);
+  Follow(this->grid_width / 2, this->grid_height / 2);
+}
+
+void Camera::SetViewCells(int cells)
+{
+  int min_cells = std::min(MIN_VIEW_CELLS, _maxViewCells);
+  cells = std::max(min_cells, std::min(cells, _maxViewCells));
+
+  // keep the blocks square, then fit as many rows as the screen (and board) allow
+  _viewport.w = cells;
+  _blockWidth = std::max(1, screen_width / cells);
+  _viewport.h = RowsFor(cells);
+  _blockHeight = std::max(1, screen_height / _viewport.h);
+}
+
+// fewer cells across means bigger blocks, so never more rows
+int Camera::RowsFor(int cells) const
+{
+  return std::max(1, std::min(grid_height, screen_height / std::max(1, screen_width / cells)));
+}
+
+SDL_Rect Camera::Centered(int x, int y, int w, int h) const
+{
+  // center on the given cell, but don't scroll past the edges of the board
+  return SDL_Rect{std::max(0, std::min(x - (w / 2), grid_width - w)),
+                  std::max(0, std::min(y - (h / 2), grid_height - h)), w, h};
+}
+
+void Camera::Follow(int x, int y)
+{
+  _viewport = Centered(x, y, _viewport.w, _viewport.h);
+}
+
+SDL_Rect Camera::LargestViewport(int x, int y) const
+{
+  return Centered(x, y, _maxViewCells, RowsFor(_maxViewCells));
+}
+
+void Camera::ZoomIn()
+{
+  SetViewCells(_viewport.w / 2);
+}
+
+void Camera::ZoomOut()
+{
+  SetViewCells(_viewport.w * 2);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/*
+    file: camera.h - contains class Camera, which keeps a viewport (in grid cells) centered on the snake's head.
+    The viewport size is bounded by the screen size, so the amount of drawing per frame does not grow with the board.
+*/
+
+#include <cstddef>
+#include "SDL.h"
+
+#define MIN_BLOCK_SIZE 4    // smallest cell size in pixels, limits how far the camera can zoom out
+#define MIN_VIEW_CELLS 8    // fewest cells across the screen, limits how far the camera can zoom in
+
+class Camera {
+ public:
+  // view_cells is the number of cells visible across the screen, 0 fits as much of the board as possible
+  Camera(std::size_t screen_width, std::size_t screen_height,
+         std::size_t grid_width, std::size_t grid_height, std::size_t view_cells = 0);
+
+  void Follow(int x, int y);
+  void ZoomIn();
+  void ZoomOut();
+
+  // visible area of the board in grid cells
+  SDL_Rect GetViewport() const { return _viewport; }
+
+  // the viewport zoomed all the way out and centered on (x, y), any viewport centered there lies inside it
+  SDL_Rect LargestViewport(int x, int y) const;
+
+  // size of one cell on screen in pixels
+  int GetBlockWidth() const { return _blockWidth; }
+  int GetBlockHeight() const { return _blockHeight; }
+
+ private:
+  void SetViewCells(int cells);
+  int RowsFor(int cells) const;
+  SDL_Rect Centered(int x, int y, int w, int h) const;
+
+  const int screen_width;
+  const int screen_height;
+  const int grid_width;
+  const int grid_height;
+
+  int _maxViewCells;
+  int _blockWidth{1};
+  int _blockHeight{1};
+  SDL_Rect _viewport{0, 0, 0, 0};
+};
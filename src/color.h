@@ -19,6 +19,8 @@ class Color {
    void blue(Uint8 b) { _blue = b; }
    void alpha(Uint8 a) { _alpha = a; }
 
+   SDL_Color toSDLColor() const { return {_red, _green, _blue, _alpha}; }
+
    void addRed(Uint8 val);
    void addGreen(Uint8 val);
    void addBlue(Uint8 val);
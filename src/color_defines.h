@@ -21,6 +21,10 @@ const Color invincibleSnakeBodyColor{0xC8, 0xE1, 0x19, 0xFF};
 const Color slowSnakeHeadColor{0x00, 0x30, 0x19, 0xFF};
 const Color slowSnakeBodyColor{0x00, 0x7B, 0x19, 0xFF};
 
+// the other players' snakes in a networked game
+const Color otherSnakeHeadColor{0x19, 0x30, 0x80, 0xFF};
+const Color otherSnakeBodyColor{0x40, 0x80, 0xE1, 0xFF};
+
 // GameElement colors
 const Color foodColor{0xFF, 0x00, 0x00, 0xFF};
 const Color wallColor{0x73, 0x73, 0x73, 0xFF};
@@ -2,15 +2,14 @@
 #include <iostream>
 #include "SDL.h"
 #include "snake.h"
-#include "game.h"
+#include "rewind.h"
+#include "trace.h"
 
-void Controller::ChangeDirection(Snake &snake, Snake::Direction input,
-                                 Snake::Direction opposite) const {
-  if (snake.direction != opposite || snake.GetData()->size == 1) snake.direction = input;
-  return;
+void Controller::Turn(EventQueue &input, Snake::Direction direction) const {
+  input.Push(GameEventType::kInputTurn, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE, static_cast<int>(direction));
 }
 
-void Controller::HandleInput(bool &running, Snake &snake, Game *game) const {
+void Controller::HandleInput(bool &running, EventQueue &input, Camera &camera) const {
   SDL_Event e;
   while (SDL_PollEvent(&e)) {
     if (e.type == SDL_QUIT) {
@@ -18,44 +17,56 @@ void Controller::HandleInput(bool &running, Snake &snake, Game *game) const {
     } else if (e.type == SDL_KEYDOWN) {
       switch (e.key.keysym.sym) {
         case SDLK_UP:
-          ChangeDirection(snake, Snake::Direction::kUp,
-                          Snake::Direction::kDown);
+          Turn(input, Snake::Direction::kUp);
           break;
 
         case SDLK_DOWN:
-          ChangeDirection(snake, Snake::Direction::kDown,
-                          Snake::Direction::kUp);
+          Turn(input, Snake::Direction::kDown);
           break;
 
         case SDLK_LEFT:
-          ChangeDirection(snake, Snake::Direction::kLeft,
-                          Snake::Direction::kRight);
+          Turn(input, Snake::Direction::kLeft);
           break;
 
         case SDLK_RIGHT:
-          ChangeDirection(snake, Snake::Direction::kRight,
-                          Snake::Direction::kLeft);
+          Turn(input, Snake::Direction::kRight);
           break;
         case SDLK_KP_1:
-          if(snake.HasPotion()) snake.UsePotion();
+          input.Push(GameEventType::kInputUseItem, {0, 0}, nullptr, GameElement::POTION);
           break;
         case SDLK_KP_2:
-          if(snake.HasBomb()) snake.UseBomb();
+          input.Push(GameEventType::kInputUseItem, {0, 0}, nullptr, GameElement::BOMB);
           break;
         case SDLK_KP_3:
-          if(snake.HasShrinkPill()) snake.UseShrinkPill();
+          input.Push(GameEventType::kInputUseItem, {0, 0}, nullptr, GameElement::SHRINK_PILL);
           break;
         case SDLK_KP_4:
-          if(snake.HasSlowPill()) snake.UseSlowPill();
+          input.Push(GameEventType::kInputUseItem, {0, 0}, nullptr, GameElement::SLOW_PILL);
           break;
         case SDLK_q:
-          game->DebugPrint();
+          input.Push(GameEventType::kInputDebug, {0, 0});
+          break;
+        case SDLK_r:
+          input.Push(GameEventType::kInputRestart, {0, 0});
+          break;
+        case SDLK_BACKSPACE:
+          input.Push(GameEventType::kInputRewind, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE, REWIND_STEP_SECONDS);
           break;
         case SDLK_PLUS:
-          snake.speed += 0.01;
+          input.Push(GameEventType::kInputSpeed, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE, 1);
           break;
         case SDLK_MINUS:
-          snake.speed -= 0.01;
+          input.Push(GameEventType::kInputSpeed, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE, -1);
+          break;
+        case SDLK_PAGEUP:
+          camera.ZoomIn();
+          break;
+        case SDLK_PAGEDOWN:
+          camera.ZoomOut();
+          break;
+        case SDLK_F12:
+          // start a trace, or write out the one running
+          Trace::Toggle();
           break;
       }
     }
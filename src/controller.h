@@ -2,16 +2,16 @@
 #define CONTROLLER_H
 
 #include "snake.h"
-
-class Game;
+#include "camera.h"
+#include "event_queue.h"
 
 class Controller {
  public:
-  void HandleInput(bool &running, Snake &snake, Game *game) const;
+  // game input is pushed to the queue for the simulation thread, the camera is changed directly
+  void HandleInput(bool &running, EventQueue &input, Camera &camera) const;
 
  private:
-  void ChangeDirection(Snake &snake, Snake::Direction input,
-                       Snake::Direction opposite) const;
+  void Turn(EventQueue &input, Snake::Direction direction) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+    file: debug_log.h - DEBUG_LOG, the game's running commentary (elements placed, items picked up and
+    used, bombs going off). It can be switched off at run time, which the training environment does since
+    formatting and flushing a line per event costs far more than the game update itself.
+*/
+
+#include <atomic>
+#include <iostream>
+
+namespace DebugLog {
+    inline std::atomic<bool> enabled{true};
+
+    inline bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+    inline void SetEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+}
+
+#define DEBUG_LOG(msg) do { if(DebugLog::Enabled()) { std::cout << msg << std::endl; } } while(0)
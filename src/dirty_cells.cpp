@@ -0,0 +1,51 @@
+#include "dirty_cells.h"
+
+DirtyCells::DirtyCells(int width, int height) :
+    _marked(width, height),
+    _cells()
+{
+    _cells.reserve(DIRTY_CELLS_RESERVE);
+}
+
+void DirtyCells::Mark(int x, int y)
+{
+    if(!_marked.InBounds(x, y) || _marked.Test(x, y)) return;
+
+    _marked.Set(x, y);
+    _cells.push_back({x, y});
+}
+
+void DirtyCells::Clear()
+{
+    // only reset the bits we set rather than the whole board
+    for(const SDL_Point &cell : _cells) {
+        _marked.Reset(cell.x, cell.y);
+    }
+    _cells.clear();
+    _snakeRecolored = false;
+    _all = false;
+}
+
+DirtyHistory::DirtyHistory(int width, int height) :
+    _ticks(DIRTY_HISTORY_TICKS),
+    _seen(width, height)
+{
+    for(Tick &slot : _ticks) {
+        slot.cells.reserve(DIRTY_CELLS_RESERVE);
+    }
+}
+
+void DirtyHistory::Record(const DirtyCells &dirty, uint64_t tick)
+{
+    Tick &slot = _ticks[tick % DIRTY_HISTORY_TICKS];
+    slot.cells.clear();
+    _lastTick = tick;
+    if(dirty.SnakeRecolored()) _recolorTick = tick;
+
+    // a repaint covers its own cells, nothing from before it is needed again
+    if(dirty.All()) {
+        _allTick = tick;
+        return;
+    }
+    slot.cells.assign(dirty.Cells().begin(), dirty.Cells().end());
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+    file: dirty_cells.h - contains class DirtyCells, the list of board cells whose contents changed since the
+    last frame. Game, Snake and SpatialIndex mark cells as things move, appear, disappear or change color, and
+    the incremental renderer repaints only those cells of its persistent board texture. DirtyHistory keeps the
+    lists of the last few ticks, so a snapshot can carry the changes of the ones the renderer skipped.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "bitboard.h"
+
+#define DIRTY_CELLS_RESERVE 1024
+#define DIRTY_HISTORY_TICKS 16     // ticks of changes kept for a renderer that has fallen behind
+
+class DirtyCells {
+ public:
+    DirtyCells(int width, int height);
+
+    // add a cell, each cell is only listed once per frame
+    void Mark(int x, int y);
+
+    // the snake changed color, so every snake cell needs repainting
+    void MarkSnakeRecolored() { _snakeRecolored = true; }
+
+    // throw away the board texture contents and repaint everything
+    void MarkAll() { _all = true; }
+
+    const std::vector<SDL_Point>& Cells() const { return _cells; }
+    bool SnakeRecolored() const { return _snakeRecolored; }
+    bool All() const { return _all; }
+
+    void Clear();
+
+ private:
+    BitBoard _marked;
+    std::vector<SDL_Point> _cells;
+    bool _snakeRecolored{false};
+    bool _all{true};    // nothing has been painted yet
+};
+
+// the cells changed in each of the last DIRTY_HISTORY_TICKS ticks. When the simulation publishes faster than
+// the renderer takes snapshots, the one it takes gets every cell changed since the last one it took, instead
+// of the renderer repainting the whole board.
+class DirtyHistory {
+ public:
+    DirtyHistory(int width, int height);
+
+    // keep the cells the tick changed, ticks are recorded in order
+    void Record(const DirtyCells &dirty, uint64_t tick);
+
+    // call fn(x, y) once for each cell changed after tick. Returns false, without calling fn, if the changes
+    // since then aren't all kept: the board was repainted or it's further back than the history goes.
+    template <typename Fn>
+    bool ForEachSince(uint64_t tick, Fn fn)
+    {
+        if(_allTick > tick || (tick < _lastTick && _lastTick - tick > DIRTY_HISTORY_TICKS)) return false;
+
+        for(uint64_t t = tick + 1; t <= _lastTick; ++t) {
+            for(const SDL_Point &cell : _ticks[t % DIRTY_HISTORY_TICKS].cells) {
+                if(_seen.Test(cell.x, cell.y)) continue;
+                _seen.Set(cell.x, cell.y);
+                fn(cell.x, cell.y);
+            }
+        }
+
+        // only reset the bits we set rather than the whole board
+        for(uint64_t t = tick + 1; t <= _lastTick; ++t) {
+            for(const SDL_Point &cell : _ticks[t % DIRTY_HISTORY_TICKS].cells) {
+                _seen.Reset(cell.x, cell.y);
+            }
+        }
+        return true;
+    }
+
+    bool SnakeRecoloredSince(uint64_t tick) const { return _recolorTick > tick; }
+
+ private:
+    struct Tick {
+        std::vector<SDL_Point> cells;
+    };
+
+    std::vector<Tick> _ticks;       // a ring, tick t in slot t % DIRTY_HISTORY_TICKS
+    BitBoard _seen;                 // cells already passed to fn, so each is passed once
+    uint64_t _lastTick{0};
+    uint64_t _allTick{0};           // the last tick that repainted everything
+    uint64_t _recolorTick{0};       // the last tick that recolored the snake
+};
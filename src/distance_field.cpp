@@ -0,0 +1,294 @@
+#include <algorithm>
+#include "distance_field.h"
+#include "board_kernels.h"
+#include "dirty_cells.h"
+#include "snake.h"
+
+#define MARK_LOOKED 1     // queued to see whether it kept a way back to the head
+#define MARK_AFFECTED 2   // it didn't, it needs a new distance
+
+DistanceField::DistanceField(const BitBoard &walls, const Snake &snake) :
+    _walls(walls),
+    _snake(snake),
+    _kernels(SelectBoardKernels(walls.Width(), walls.Height())),
+    _width(walls.Width()),
+    _height(walls.Height()),
+    _blocked(walls.Width(), walls.Height()),
+    _pendingBits(walls.Width(), walls.Height())
+{
+    const std::size_t cells = static_cast<std::size_t>(_width) * _height;
+    _dist.assign(cells, DISTANCE_UNREACHABLE);
+    _queue.resize(cells);
+    _mark.assign(cells, 0);
+
+    // a repair never gets bigger than this, past it the distances are worked out from scratch
+    const std::size_t limit = cells / DISTANCE_REPAIR_LIMIT + 1;
+    _pending.reserve(limit);
+    _marked.reserve(4 * limit);
+    _affected.reserve(limit);
+    _filled.reserve(limit);
+    _freed.reserve(limit);
+    _seeds.reserve(4 * limit);
+}
+
+void DistanceField::Sync(const DirtyCells &dirty)
+{
+    // the whole board changed and no cells were listed for it
+    if(dirty.All()) _stale = true;
+    if(_stale) return;
+
+    for(const SDL_Point &cell : dirty.Cells()) {
+        if(!_pendingBits.InBounds(cell.x, cell.y) || _pendingBits.Test(cell.x, cell.y)) continue;
+        if(_pending.size() == _pending.capacity()) {
+            _stale = true;
+            return;
+        }
+        _pendingBits.Set(cell.x, cell.y);
+        _pending.push_back(cell.y * _width + cell.x);
+    }
+}
+
+bool DistanceField::Blocked(int x, int y) const
+{
+    return _walls.Test(x, y) || _snake.SnakeCell(x, y);
+}
+
+int DistanceField::OpenAround(int32_t cell, int32_t around[4]) const
+{
+    // the cells next to this one that a path can go through, wrapping like the snake. The head's cell is
+    // blocked to everything else but it's where every path starts.
+    const int x = cell % _width;
+    const int y = cell / _width;
+    const int nx[4] = {x + 1 < _width ? x + 1 : 0, x > 0 ? x - 1 : _width - 1, x, x};
+    const int ny[4] = {y, y, y + 1 < _height ? y + 1 : 0, y > 0 ? y - 1 : _height - 1};
+    int count = 0;
+    for(int d = 0; d < 4; ++d) {
+        const int32_t next = ny[d] * _width + nx[d];
+        if(next == _source || !_blocked.Test(nx[d], ny[d])) around[count++] = next;
+    }
+    return count;
+}
+
+void DistanceField::Refresh()
+{
+    const int32_t head = _snake.HeadY() * _width + _snake.HeadX();
+    if(_stale || head != _source) {
+        Recompute();
+        return;
+    }
+    if(_pending.empty()) return;
+
+    if(Repair()) {
+        ++_repairs;
+        ++_version;
+    }
+}
+
+void DistanceField::Recompute()
+{
+    const int words = _blocked.WordsPerRow();
+    const int tail = _width & 63;
+    const uint64_t lastMask = tail ? ((uint64_t{1} << tail) - 1) : ~uint64_t{0};
+
+    // the blocked cells, a word at a time
+    const BitBoard &body = _snake.GetOccupancy();
+    for(int y = 0; y < _height; ++y) {
+        const uint64_t *walls = _walls.Row(y);
+        const uint64_t *snake = body.Row(y);
+        uint64_t *row = _blocked.Row(y);
+        for(int w = 0; w < words; ++w) {
+            row[w] = walls[w] | snake[w];
+        }
+        row[words - 1] &= lastMask;
+    }
+    _blocked.Set(_snake.HeadX(), _snake.HeadY());
+    _source = _snake.HeadY() * _width + _snake.HeadX();
+
+    // a plain BFS, see board_kernels.h
+    _kernels.distances(_blocked, _source, _dist.data(), _queue.data());
+
+    for(int32_t cell : _pending) {
+        _pendingBits.Reset(cell % _width, cell / _width);
+    }
+    _pending.clear();
+    _stale = false;
+    ++_recomputes;
+    ++_version;
+}
+
+bool DistanceField::Repair()
+{
+    // sort what changed into cells that filled in and cells that freed up
+    _filled.clear();
+    _freed.clear();
+    for(int32_t cell : _pending) {
+        const int x = cell % _width;
+        const int y = cell / _width;
+        _pendingBits.Reset(x, y);
+        const bool blocked = Blocked(x, y);
+        if(blocked == _blocked.Test(x, y)) continue;
+        if(blocked) {
+            _blocked.Set(x, y);
+            _filled.push_back(cell);
+        } else {
+            _blocked.Reset(x, y);
+            _freed.push_back(cell);
+        }
+    }
+    _pending.clear();
+    if(_filled.empty() && _freed.empty()) return false;
+
+    // the distances that went up are settled first, so the ones that go down only ever build on good ones.
+    // A rise too big to be worth repairing is a recompute, which counts itself.
+    if(!_filled.empty() && !Raise()) {
+        Recompute();
+        return false;
+    }
+    if(!_freed.empty()) Lower();
+    return true;
+}
+
+bool DistanceField::Raise()
+{
+    const std::size_t limit = _dist.size() / DISTANCE_REPAIR_LIMIT + 1;
+    int32_t around[4];
+
+    // the cells one further out than a cell that filled in might have been getting their distance through it
+    _seeds.clear();
+    for(int32_t cell : _filled) {
+        const int32_t old = _dist[cell];
+        _dist[cell] = DISTANCE_UNREACHABLE;
+        if(old == DISTANCE_UNREACHABLE) continue;
+        const int count = OpenAround(cell, around);
+        for(int i = 0; i < count; ++i) {
+            if(_dist[around[i]] == old + 1 && !_mark[around[i]]) {
+                _mark[around[i]] = MARK_LOOKED;
+                _marked.push_back(around[i]);
+                _seeds.emplace_back(old + 1, around[i]);
+            }
+        }
+    }
+    std::sort(_seeds.begin(), _seeds.end());
+
+    // nearest first, so whether a cell still has a way back is known before the cells further out ask it.
+    // A cell with a neighbour one closer that isn't affected keeps its distance, one without is affected and
+    // the cells one further out from it are looked at in turn.
+    _affected.clear();
+    std::size_t seed = 0;
+    std::size_t head = 0;
+    std::size_t tail = 0;
+    while(seed < _seeds.size() || head < tail) {
+        int32_t cell;
+        if(head == tail || (seed < _seeds.size() && _seeds[seed].first <= _dist[_queue[head]])) {
+            cell = _seeds[seed++].second;
+        } else {
+            cell = _queue[head++];
+        }
+
+        const int32_t dist = _dist[cell];
+        const int count = OpenAround(cell, around);
+        bool kept = false;
+        for(int i = 0; i < count && !kept; ++i) {
+            kept = _dist[around[i]] == dist - 1 && _mark[around[i]] != MARK_AFFECTED;
+        }
+        if(kept) continue;
+
+        if(_affected.size() == limit) {
+            ClearMarks();
+            return false;
+        }
+        _mark[cell] = MARK_AFFECTED;
+        _affected.push_back(cell);
+        for(int i = 0; i < count; ++i) {
+            if(_dist[around[i]] == dist + 1 && !_mark[around[i]]) {
+                _mark[around[i]] = MARK_LOOKED;
+                _marked.push_back(around[i]);
+                _queue[tail++] = around[i];
+            }
+        }
+    }
+
+    // every affected cell starts from the best of its neighbours that kept their distance, then they
+    // spread through each other
+    for(int32_t cell : _affected) {
+        _dist[cell] = DISTANCE_UNREACHABLE;
+    }
+    _seeds.clear();
+    for(int32_t cell : _affected) {
+        int32_t best = DISTANCE_UNREACHABLE;
+        const int count = OpenAround(cell, around);
+        for(int i = 0; i < count; ++i) {
+            const int32_t dist = _dist[around[i]];
+            if(dist != DISTANCE_UNREACHABLE && _mark[around[i]] != MARK_AFFECTED && (best < 0 || dist + 1 < best)) {
+                best = dist + 1;
+            }
+        }
+        if(best != DISTANCE_UNREACHABLE) _seeds.emplace_back(best, cell);
+    }
+    std::sort(_seeds.begin(), _seeds.end());
+    Spread(true);
+    ClearMarks();
+    return true;
+}
+
+void DistanceField::Lower()
+{
+    // a cell that freed up is one further than its closest neighbour, and from there it can only shorten
+    // the way to the cells around it
+    int32_t around[4];
+    _seeds.clear();
+    for(int32_t cell : _freed) {
+        _dist[cell] = DISTANCE_UNREACHABLE;
+    }
+    for(int32_t cell : _freed) {
+        int32_t best = DISTANCE_UNREACHABLE;
+        const int count = OpenAround(cell, around);
+        for(int i = 0; i < count; ++i) {
+            const int32_t dist = _dist[around[i]];
+            if(dist != DISTANCE_UNREACHABLE && (best < 0 || dist + 1 < best)) best = dist + 1;
+        }
+        if(best != DISTANCE_UNREACHABLE) _seeds.emplace_back(best, cell);
+    }
+    std::sort(_seeds.begin(), _seeds.end());
+    Spread(false);
+}
+
+void DistanceField::Spread(bool affectedOnly)
+{
+    // a BFS from seeds that start at different distances: the sorted seeds and the queue are taken in
+    // order of distance, so every cell is set once, to its shortest distance
+    int32_t around[4];
+    std::size_t seed = 0;
+    std::size_t head = 0;
+    std::size_t tail = 0;
+    while(seed < _seeds.size() || head < tail) {
+        int32_t cell;
+        if(head == tail || (seed < _seeds.size() && _seeds[seed].first <= _dist[_queue[head]])) {
+            const int32_t dist = _seeds[seed].first;
+            cell = _seeds[seed++].second;
+            if(_dist[cell] != DISTANCE_UNREACHABLE && _dist[cell] <= dist) continue;
+            _dist[cell] = dist;
+        } else {
+            cell = _queue[head++];
+        }
+
+        const int32_t next = _dist[cell] + 1;
+        const int count = OpenAround(cell, around);
+        for(int i = 0; i < count; ++i) {
+            const int32_t to = around[i];
+            if(to == _source || (affectedOnly && _mark[to] != MARK_AFFECTED)) continue;
+            if(_dist[to] == DISTANCE_UNREACHABLE || _dist[to] > next) {
+                _dist[to] = next;
+                _queue[tail++] = to;
+            }
+        }
+    }
+}
+
+void DistanceField::ClearMarks()
+{
+    for(int32_t cell : _marked) {
+        _mark[cell] = 0;
+    }
+    _marked.clear();
+}
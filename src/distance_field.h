@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+    file: distance_field.h - contains class DistanceField, the number of moves from the snake's head to
+    every cell, around walls and the body and wrapping at the edges like the snake. It follows the same
+    DirtyCells list as the renderer and is only brought up to date when it's read.
+
+    A cell that fills in only changes the cells whose every shortest path ran through it: they are found
+    level by level from the cell and given new distances from the cells around them that kept theirs. A
+    cell that frees up only lowers the cells it gives a shorter way to. Both stay within the cells that
+    change. When the head moves, every distance it can reach changes by at least one (the grid alternates
+    odd and even distances), so that is a fresh BFS, and so is a repair that would reach more than a
+    1/DISTANCE_REPAIR_LIMIT share of the board.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+
+struct BoardKernels;
+
+#define DISTANCE_UNREACHABLE -1
+#define DISTANCE_REPAIR_LIMIT 8   // a repair reaching more than 1/8 of the board is a BFS instead
+
+class DirtyCells;
+class Snake;
+
+class DistanceField {
+ public:
+    DistanceField(const BitBoard &walls, const Snake &snake);
+
+    // note the cells changed since the dirty list was last cleared, the same list can be passed again
+    void Sync(const DirtyCells &dirty);
+
+    // bring the distances up to date with everything synced so far
+    void Refresh();
+
+    // the distances row after row, DISTANCE_UNREACHABLE for cells the head can't get to (and the body)
+    const int32_t* Data() const { return _dist.data(); }
+    int32_t At(int x, int y) const { return _dist[y * _width + x]; }
+    int Width() const { return _width; }
+    int Height() const { return _height; }
+
+    // goes up every time a Refresh changes the distances
+    uint64_t Version() const { return _version; }
+
+    // throw the distances away and BFS from the head (boards up to 65536 cells a side)
+    void Recompute();
+
+    int Repairs() const { return _repairs; }
+    int Recomputes() const { return _recomputes; }
+
+ private:
+    bool Blocked(int x, int y) const;
+    int OpenAround(int32_t cell, int32_t around[4]) const;
+    bool Repair();
+    bool Raise();
+    void Lower();
+    void Spread(bool affectedOnly);
+    void ClearMarks();
+
+    const BitBoard &_walls;
+    const Snake &_snake;
+    const BoardKernels &_kernels;       // the BFS, specialized for the board's size if it's a common one
+    int _width;
+    int _height;
+    int32_t _source{-1};                // the head's cell the distances are from
+    BitBoard _blocked;                  // walls and body as the distances last saw them
+    std::vector<int32_t> _dist;
+
+    BitBoard _pendingBits;              // cells synced since the last refresh
+    std::vector<int32_t> _pending;
+    bool _stale{true};
+
+    // scratch for the repairs and the BFS, sized once
+    std::vector<int32_t> _queue;
+    std::vector<uint8_t> _mark;         // per cell: looked at, or affected, during a repair
+    std::vector<int32_t> _marked;       // the cells to clear _mark for afterwards
+    std::vector<int32_t> _affected;
+    std::vector<int32_t> _filled;
+    std::vector<int32_t> _freed;
+    std::vector<std::pair<int32_t, int32_t>> _seeds;   // (distance, cell)
+
+    uint64_t _version{0};
+    int _repairs{0};
+    int _recomputes{0};
+};
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <new>
+#include "element_pool.h"
+#include "debug_log.h"
+
+ElementPool::ElementPool(SpatialIndex *index, EventQueue *events, std::pmr::memory_resource *arena) :
+    _index(index),
+    _events(events),
+    _arena(arena),
+    _chunks(arena)
+{
+    for(auto &head : _freeHead) {
+        head = nullptr;
+    }
+}
+
+ElementPool::~ElementPool()
+{
+    // elements are destroyed with their chunks, the arena gets the memory back
+    for(ChunkBase *chunk : _chunks) {
+        chunk->Destroy(_arena);
+    }
+}
+
+template <typename T>
+void ElementPool::Grow(GameElement::ElementType type)
+{
+    Chunk<T> *chunk = new(_arena->allocate(sizeof(Chunk<T>), alignof(Chunk<T>))) Chunk<T>();
+
+    for(T &item : chunk->items) {
+        item._pool = this;
+        item.SetEventQueue(_events);
+        item.AttachIndex(_index);
+        PushFree(&item);
+    }
+    _chunks.push_back(chunk);
+
+    DEBUG_LOG("Pool grew by " << POOL_CHUNK_SIZE << " " << GameElement::GetElementTypeString(type) << " elements");
+}
+
+void ElementPool::GrowType(GameElement::ElementType type)
+{
+    switch(type) {
+        case GameElement::POTION:
+            Grow<Potion>(type);
+            break;
+        case GameElement::BOMB:
+            Grow<Bomb>(type);
+            break;
+        case GameElement::SHRINK_PILL:
+            Grow<ShrinkPill>(type);
+            break;
+        case GameElement::SLOW_PILL:
+            Grow<SlowPill>(type);
+            break;
+        default:
+            break;
+    }
+}
+
+void ElementPool::Reserve(GameElement::ElementType type, int count)
+{
+    for(int i = 0; i < count; i += POOL_CHUNK_SIZE) {
+        GrowType(type);
+    }
+}
+
+GameElement* ElementPool::PopFree(GameElement::ElementType type)
+{
+    if(_freeHead[type] == nullptr) {
+        GrowType(type);
+    }
+
+    GameElement *element = _freeHead[type];
+    if(element != nullptr) {
+        _freeHead[type] = element->_nextFree;
+        element->_nextFree = nullptr;
+        element->_inFreeList = false;
+    }
+    return element;
+}
+
+void ElementPool::PushFree(GameElement *element)
+{
+    element->_nextFree = _freeHead[element->GetType()];
+    element->_inFreeList = true;
+    _freeHead[element->GetType()] = element;
+}
+
+GameElement* ElementPool::Acquire(GameElement::ElementType type)
+{
+    if(type < 0 || type >= GameElement::NUM_ELEMENT_TYPES || type == GameElement::WALL) return nullptr;
+
+    return PopFree(type);
+}
+
+void ElementPool::Release(GameElement *element)
+{
+    if(!element->_inFreeList) {
+        PushFree(element);
+    }
+}
+
+void ElementPool::Recycle()
+{
+    // rebuilt in the order the chunks were made, as if the pool had just grown to its size
+    for(auto &head : _freeHead) {
+        head = nullptr;
+    }
+    for(ChunkBase *chunk : _chunks) {
+        for(int i = 0; i < POOL_CHUNK_SIZE; ++i) {
+            GameElement *element = chunk->Item(i);
+            element->Recycle();
+            PushFree(element);
+        }
+    }
+}
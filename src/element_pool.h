@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+    file: element_pool.h - contains class ElementPool, which owns every power-up in the game. Elements are
+    created in chunks and threaded onto per-type intrusive free lists, so handing out a hidden element or
+    taking one back is O(1) and normal play never allocates. The chunks are carved out of the game's arena,
+    a monotonic memory resource, so they sit next to each other and go back in one piece with the game.
+    Recycle puts every element back for a new game without freeing a chunk. Walls aren't elements, they
+    live in the game's WallLayer.
+*/
+
+#include <memory_resource>
+#include <vector>
+#include "game_element.h"
+
+#define POOL_CHUNK_SIZE 32
+
+class SpatialIndex;
+class EventQueue;
+
+class ElementPool {
+ public:
+    ElementPool(SpatialIndex *index, EventQueue *events, std::pmr::memory_resource *arena);
+    ~ElementPool();
+
+    ElementPool(const ElementPool&) = delete;
+    ElementPool& operator=(const ElementPool&) = delete;
+
+    // create enough elements of the given type up front so play doesn't have to allocate
+    void Reserve(GameElement::ElementType type, int count);
+
+    // pop a hidden, available power-up of the given type, growing the pool if none are left
+    GameElement* Acquire(GameElement::ElementType type);
+
+    // give an element back to its free list
+    void Release(GameElement *element);
+
+    // stop every bomb fuse and put every element back on its free list as it was made, hidden and available
+    void Recycle();
+
+    // how many elements the pool owns, of every type
+    std::size_t Capacity() const { return _chunks.size() * POOL_CHUNK_SIZE; }
+
+    // call fn(element) for every element the pool owns, in the order they were made
+    template <typename Fn>
+    void ForEach(Fn fn) const
+    {
+        for(ChunkBase *chunk : _chunks) {
+            for(int i = 0; i < POOL_CHUNK_SIZE; ++i) {
+                fn(chunk->Item(i));
+            }
+        }
+    }
+
+ private:
+    // type-erased storage so chunks of every element subclass can live in one vector
+    struct ChunkBase {
+        virtual ~ChunkBase() { }
+        virtual GameElement* Item(int i) = 0;
+        virtual void Destroy(std::pmr::memory_resource *arena) = 0;
+    };
+
+    template <typename T>
+    struct Chunk : public ChunkBase {
+        T items[POOL_CHUNK_SIZE];
+
+        GameElement* Item(int i) override { return &items[i]; }
+        void Destroy(std::pmr::memory_resource *arena) override
+        {
+            this->~Chunk();
+            arena->deallocate(this, sizeof(Chunk<T>), alignof(Chunk<T>));
+        }
+    };
+
+    template <typename T>
+    void Grow(GameElement::ElementType type);
+    void GrowType(GameElement::ElementType type);
+
+    GameElement* PopFree(GameElement::ElementType type);
+    void PushFree(GameElement *element);
+
+    SpatialIndex *_index;
+    EventQueue *_events;
+    std::pmr::memory_resource *_arena;
+    std::pmr::vector<ChunkBase*> _chunks;       // in the arena too
+    GameElement *_freeHead[GameElement::NUM_ELEMENT_TYPES];
+};
@@ -0,0 +1,18 @@
+#include "event_queue.h"
+
+EventQueue::EventQueue() :
+    _write(&_buffers[0])
+{
+}
+
+void EventQueue::Push(GameEventType type, SDL_Point location, GameElement *element, GameElement::ElementType itemType, int value, int player)
+{
+    GameEvent event{type, itemType, location, element, value, player};
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    if(_write->count < EVENT_QUEUE_INLINE_CAPACITY) {
+        _write->events[_write->count++] = event;
+    } else {
+        _write->overflow.emplace_back(event);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+/*
+    file: event_queue.h - contains the GameEvent types and class EventQueue. Elements and the snake push
+    events as things happen, and Game handles all of them in one batch at a fixed point in Update. The
+    queue is double buffered: events pushed while a batch is being handled land in the next tick's batch.
+    Each buffer stores events inline, so the queue doesn't allocate unless a tick overflows that storage.
+*/
+
+#include <mutex>
+#include <vector>
+#include "SDL.h"
+#include "game_element.h"
+
+#define EVENT_QUEUE_INLINE_CAPACITY 64
+
+enum class GameEventType {
+    kItemUsed,
+    kBombExploded,
+    kFoodEaten,
+    kSnakeDied,
+
+    // player input, pushed by the Controller on the main thread and applied at the start of the next tick
+    kInputTurn,        // value is the Snake::Direction to turn to
+    kInputUseItem,     // itemType is the item to use
+    kInputSpeed,       // value is the number of speed steps to add (negative to slow down)
+    kInputDebug,
+    kInputRestart,     // start a new game in place
+    kInputRewind       // value is the number of seconds to wind the game back
+};
+
+struct GameEvent {
+    GameEventType type;
+    GameElement::ElementType itemType;
+    SDL_Point location;
+    GameElement *element;
+    int value;
+    int player;     // the player whose snake or input it was, 0 for the local one (see Game::AddPlayer)
+};
+
+class EventQueue {
+ public:
+    EventQueue();
+
+    // safe to call from any thread (bomb fuses push from their own thread, input from the main thread)
+    void Push(GameEventType type, SDL_Point location, GameElement *element = nullptr,
+              GameElement::ElementType itemType = GameElement::UNKNOWN_TYPE, int value = 0, int player = 0);
+
+    // swap buffers and call fn(event) for every event pushed since the last drain, in order
+    template <typename Fn>
+    void Drain(Fn fn)
+    {
+        Buffer *batch;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            batch = _write;
+            _write = (_write == &_buffers[0]) ? &_buffers[1] : &_buffers[0];
+        }
+
+        for(int i = 0; i < batch->count; ++i) {
+            fn(static_cast<const GameEvent&>(batch->events[i]));
+        }
+        for(const GameEvent &event : batch->overflow) {
+            fn(event);
+        }
+
+        batch->count = 0;
+        batch->overflow.clear();
+    }
+
+ private:
+    struct Buffer {
+        GameEvent events[EVENT_QUEUE_INLINE_CAPACITY];
+        int count{0};
+        std::vector<GameEvent> overflow;    // only used if a tick produces more events than fit inline
+    };
+
+    Buffer _buffers[2];
+    Buffer *_write;
+    std::mutex _mtx;
+};
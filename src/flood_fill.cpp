@@ -0,0 +1,325 @@
+#include "flood_fill.h"
+#include <algorithm>
+
+// spread the set bits of s towards bit 63 through the set bits of open, in six shift-and-mask steps
+static uint64_t FillUp(uint64_t s, uint64_t open)
+{
+    s &= open;
+    s |= open & (s << 1);  open &= open << 1;
+    s |= open & (s << 2);  open &= open << 2;
+    s |= open & (s << 4);  open &= open << 4;
+    s |= open & (s << 8);  open &= open << 8;
+    s |= open & (s << 16); open &= open << 16;
+    s |= open & (s << 32);
+    return s;
+}
+
+// the same towards bit 0
+static uint64_t FillDown(uint64_t s, uint64_t open)
+{
+    s &= open;
+    s |= open & (s >> 1);  open &= open >> 1;
+    s |= open & (s >> 2);  open &= open >> 2;
+    s |= open & (s >> 4);  open &= open >> 4;
+    s |= open & (s >> 8);  open &= open >> 8;
+    s |= open & (s >> 16); open &= open >> 16;
+    s |= open & (s >> 32);
+    return s;
+}
+
+static bool TestBit(const uint64_t *row, int x) { return (row[x >> 6] >> (x & 63)) & 1; }
+static void SetBit(uint64_t *row, int x) { row[x >> 6] |= uint64_t{1} << (x & 63); }
+
+// fill the runs of open cells through the words lo..hi of a row, which is already filled everywhere else, out
+// to wherever they end. Runs carry across words and, with wrap, across the row's ends. The words that gained
+// cells are added to changedLo..changedHi.
+static void FillRow(uint64_t *row, const uint64_t *open, int words, int width, bool wrap, int lo, int hi,
+                    int &changedLo, int &changedHi)
+{
+    for(;;) {
+        // towards the end of the row, past hi only as long as a word gains cells
+        uint64_t carry = 0;
+        for(int w = lo; w < words; ++w) {
+            uint64_t filled = FillUp(row[w] | carry, open[w]);
+            if(filled != row[w]) {
+                row[w] = filled;
+                hi = std::max(hi, w);
+                changedLo = std::min(changedLo, w);
+                changedHi = std::max(changedHi, w);
+            } else if(w > hi) {
+                break;
+            }
+            carry = filled >> 63;
+        }
+
+        // and back towards the start, which fills the rest of every run the first pass went up
+        carry = 0;
+        for(int w = hi; w >= 0; --w) {
+            uint64_t filled = FillDown(row[w] | (carry << 63), open[w]);
+            if(filled != row[w]) {
+                row[w] = filled;
+                lo = std::min(lo, w);
+                changedLo = std::min(changedLo, w);
+                changedHi = std::max(changedHi, w);
+            } else if(w < lo) {
+                break;
+            }
+            carry = filled & 1;
+        }
+        if(!wrap || width < 2) return;
+
+        // a run through the row's ends has only been filled on one side
+        bool first = TestBit(row, 0);
+        bool last = TestBit(row, width - 1);
+        if(first && !last && TestBit(open, width - 1)) {
+            SetBit(row, width - 1);
+            lo = hi = words - 1;
+        } else if(last && !first && TestBit(open, 0)) {
+            SetBit(row, 0);
+            lo = hi = 0;
+        } else {
+            return;
+        }
+        changedLo = std::min(changedLo, lo);
+        changedHi = std::max(changedHi, hi);
+    }
+}
+
+// put the words lo..hi of row y on the pending list, or widen the span it is already listed with
+static void List(FloodFillScratch &scratch, int y, int lo, int hi)
+{
+    if(scratch.spanLo[y] > scratch.spanHi[y]) {
+        scratch.pending.push_back(y);
+        scratch.spanLo[y] = lo;
+        scratch.spanHi[y] = hi;
+    } else {
+        scratch.spanLo[y] = std::min(scratch.spanLo[y], lo);
+        scratch.spanHi[y] = std::max(scratch.spanHi[y], hi);
+    }
+}
+
+static int RowAbove(int y, int height, bool wrap) { return (y > 0) ? y - 1 : (wrap ? height - 1 : -1); }
+static int RowBelow(int y, int height, bool wrap) { return (y + 1 < height) ? y + 1 : (wrap ? 0 : -1); }
+
+// list the words lo..hi of row y and of the rows either side, for a row whose cells there are new
+static void ListAround(FloodFillScratch &scratch, int y, int lo, int hi, int height, bool wrap)
+{
+    List(scratch, y, lo, hi);
+    int up = RowAbove(y, height, wrap);
+    int down = RowBelow(y, height, wrap);
+    if(up >= 0) List(scratch, up, lo, hi);
+    if(down >= 0) List(scratch, down, lo, hi);
+}
+
+// for every listed row take in the cells of the rows above and below through the listed words, and fill
+// along the row from there. Whatever a row gains lists the same words of the rows either side, until no
+// row gains anything. A step along a winding corridor only touches the word or two around it.
+static void FillPending(const BitBoard &open, BitBoard &reached, bool wrap, FloodFillScratch &scratch)
+{
+    const int height = open.Height();
+    const int words = open.WordsPerRow();
+
+    while(!scratch.pending.empty()) {
+        int y = scratch.pending.back();
+        scratch.pending.pop_back();
+        int lo = scratch.spanLo[y];
+        int hi = scratch.spanHi[y];
+        scratch.spanLo[y] = words;
+        scratch.spanHi[y] = -1;
+
+        int up = RowAbove(y, height, wrap);
+        int down = RowBelow(y, height, wrap);
+        const uint64_t *above = (up >= 0) ? reached.Row(up) : nullptr;
+        const uint64_t *below = (down >= 0) ? reached.Row(down) : nullptr;
+        const uint64_t *openRow = open.Row(y);
+        uint64_t *row = reached.Row(y);
+
+        int changedLo = words;
+        int changedHi = -1;
+        for(int w = lo; w <= hi; ++w) {
+            uint64_t vertical = (above ? above[w] : 0) | (below ? below[w] : 0);
+            uint64_t taken = row[w] | (vertical & openRow[w]);
+            if(taken != row[w]) {
+                row[w] = taken;
+                changedLo = std::min(changedLo, w);
+                changedHi = std::max(changedHi, w);
+            }
+        }
+        if(changedLo > changedHi) continue;
+        FillRow(row, openRow, words, open.Width(), wrap, changedLo, changedHi, changedLo, changedHi);
+
+        if(up >= 0) List(scratch, up, changedLo, changedHi);
+        if(down >= 0) List(scratch, down, changedLo, changedHi);
+    }
+}
+
+void FloodFillScratch::Reserve(int width, int height)
+{
+    reached.Resize(width, height);
+    pending.reserve(height);
+    spanLo.assign(height, (width + 63) / 64);
+    spanHi.assign(height, -1);
+}
+
+// make sure scratch's lists fit the board, without touching reached
+static void FitLists(FloodFillScratch &scratch, int width, int height)
+{
+    if(static_cast<int>(scratch.spanLo.size()) != height || scratch.reached.Width() != width) {
+        scratch.pending.reserve(height);
+        scratch.spanLo.assign(height, (width + 63) / 64);
+        scratch.spanHi.assign(height, -1);
+    }
+}
+
+void FloodFill(const BitBoard &open, BitBoard &reached, bool wrap)
+{
+    const int height = open.Height();
+    const int words = open.WordsPerRow();
+    if(height == 0 || words == 0) return;
+
+    FloodFillScratch scratch;
+    FitLists(scratch, open.Width(), height);
+
+    // the seeds are spread along their rows first, then every row holding one lists itself and the rows
+    // either side of it
+    for(int y = 0; y < height; ++y) {
+        uint64_t *row = reached.Row(y);
+        int lo = words, hi = -1;
+        for(int w = 0; w < words; ++w) {
+            row[w] &= open.Row(y)[w];
+            if(row[w]) {
+                lo = std::min(lo, w);
+                hi = w;
+            }
+        }
+        if(lo > hi) continue;
+        int changedLo = lo, changedHi = hi;
+        FillRow(row, open.Row(y), words, open.Width(), wrap, lo, hi, changedLo, changedHi);
+        ListAround(scratch, y, changedLo, changedHi, height, wrap);
+    }
+    FillPending(open, reached, wrap, scratch);
+}
+
+// FloodFillFrom with the lists in scratch, every row is off the list again once it returns
+static void FillFrom(const BitBoard &open, BitBoard &reached, int x, int y, bool wrap, FloodFillScratch &scratch)
+{
+    if(!open.InBounds(x, y) || !open.Test(x, y) || reached.Test(x, y)) return;
+
+    // reached is already filled everywhere else, so only the seed's run and the words of the rows either side
+    // it touches need a look, and then whatever they gain
+    const int words = open.WordsPerRow();
+    reached.Set(x, y);
+    int changedLo = x >> 6, changedHi = x >> 6;
+    FillRow(reached.Row(y), open.Row(y), words, open.Width(), wrap, x >> 6, x >> 6, changedLo, changedHi);
+    ListAround(scratch, y, changedLo, changedHi, open.Height(), wrap);
+    FillPending(open, reached, wrap, scratch);
+}
+
+void FloodFillFrom(const BitBoard &open, BitBoard &reached, int x, int y, bool wrap)
+{
+    FloodFillScratch scratch;
+    FitLists(scratch, open.Width(), open.Height());
+    FillFrom(open, reached, x, y, wrap, scratch);
+}
+
+void InvertBoard(const BitBoard &blocked, BitBoard &open)
+{
+    const int words = blocked.WordsPerRow();
+    const int tail = blocked.Width() & 63;
+    const uint64_t lastMask = tail ? ((uint64_t{1} << tail) - 1) : ~uint64_t{0};
+
+    open.Resize(blocked.Width(), blocked.Height());
+    for(int y = 0; y < blocked.Height(); ++y) {
+        const uint64_t *src = blocked.Row(y);
+        uint64_t *dst = open.Row(y);
+        for(int w = 0; w < words; ++w) {
+            dst[w] = ~src[w];
+        }
+        if(words > 0) dst[words - 1] &= lastMask;
+    }
+}
+
+// the eight cells around (x, y) in order round the ring, the odd ones are the corners
+static void Ring(const BitBoard &open, int x, int y, bool wrap, int ringX[8], int ringY[8], bool ringOpen[8])
+{
+    static const int kRingX[8] = { 0,  1, 1, 1, 0, -1, -1, -1};
+    static const int kRingY[8] = {-1, -1, 0, 1, 1,  1,  0, -1};
+    const int width = open.Width();
+    const int height = open.Height();
+    for(int i = 0; i < 8; ++i) {
+        int nx = x + kRingX[i];
+        int ny = y + kRingY[i];
+        if(wrap) {
+            nx = (nx + width) % width;
+            ny = (ny + height) % height;
+        }
+        ringX[i] = nx;
+        ringY[i] = ny;
+        // on a board one cell across the ring wraps round onto (x, y) itself
+        ringOpen[i] = open.InBounds(nx, ny) && open.Test(nx, ny) && !(nx == x && ny == y);
+    }
+}
+
+bool LocallyConnected(const BitBoard &open, int x, int y, bool wrap)
+{
+    // too small a board wraps the ring onto itself, the runs round it don't mean anything then
+    if(open.Width() < 3 || open.Height() < 3) return false;
+
+    int ringX[8], ringY[8];
+    bool ringOpen[8];
+    Ring(open, x, y, wrap, ringX, ringY, ringOpen);
+
+    // going round the ring, count the runs of open cells that hold one of the four direct neighbours. One
+    // run (or none) means they're joined around (x, y) anyway.
+    int start = 0;
+    while(start < 8 && ringOpen[start]) ++start;
+    if(start == 8) return true;
+
+    int runs = 0;
+    bool inRun = false;
+    bool runHasSide = false;
+    for(int k = 1; k <= 8; ++k) {
+        int i = (start + k) % 8;
+        if(ringOpen[i]) {
+            if(!inRun) { inRun = true; runHasSide = false; }
+            if(i % 2 == 0) runHasSide = true;
+        } else if(inRun) {
+            inRun = false;
+            if(runHasSide) ++runs;
+        }
+    }
+    return runs <= 1;
+}
+
+bool StaysConnected(BitBoard &open, int x, int y, bool wrap, FloodFillScratch &scratch)
+{
+    if(!open.InBounds(x, y) || !open.Test(x, y)) return true;
+    if(LocallyConnected(open, x, y, wrap)) return true;
+
+    const int width = open.Width();
+    const int height = open.Height();
+    int ringX[8], ringY[8];
+    bool ringOpen[8];
+    Ring(open, x, y, wrap, ringX, ringY, ringOpen);
+
+    // otherwise fill from one open side with (x, y) closed and see if it gets round to the others
+    open.Reset(x, y);
+    if(scratch.reached.Width() != width || scratch.reached.Height() != height) {
+        scratch.Reserve(width, height);
+    } else {
+        scratch.reached.Clear();
+    }
+    int first = -1;
+    bool connected = true;
+    for(int i = 0; i < 8 && connected; i += 2) {
+        if(!ringOpen[i]) continue;
+        if(first < 0) {
+            first = i;
+            FillFrom(open, scratch.reached, ringX[i], ringY[i], wrap, scratch);
+        } else if(!scratch.reached.Test(ringX[i], ringY[i])) {
+            connected = false;
+        }
+    }
+    open.Set(x, y);
+    return connected;
+}
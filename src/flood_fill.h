@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+    file: flood_fill.h - word-parallel flood fill over BitBoards. Within a row, every run of open cells that
+    holds a reached cell is filled 64 cells at a time with shifted masks (log2(64) shift-and-mask steps per
+    word), and a row is only revisited, and only in the words that matter, when the row above or below it
+    gains cells there, so even a board of millions of cells is checked in milliseconds. Moves are up, down, left and right, like the snake's,
+    and with wrap the board's edges join the way they do for the snake.
+*/
+
+#include <vector>
+#include "bitboard.h"
+
+// the working space of a fill, kept between fills so checking a wall during play doesn't allocate
+struct FloodFillScratch {
+    BitBoard reached;
+    std::vector<int> pending;       // rows still to look at
+    std::vector<int> spanLo;        // the words of each row to look at, none while spanLo > spanHi
+    std::vector<int> spanHi;
+
+    void Reserve(int width, int height);
+};
+
+// grow reached (which holds the seeds) over every open cell connected to it. Open must have no bits set
+// past the board's width, reached must be the same size as open.
+void FloodFill(const BitBoard &open, BitBoard &reached, bool wrap);
+
+// add the open cells connected to (x, y) to reached, nothing if (x, y) isn't open. Reached has to be the
+// result of a fill already (or empty), only the rows the new cells spread into are visited.
+void FloodFillFrom(const BitBoard &open, BitBoard &reached, int x, int y, bool wrap);
+
+// open becomes every cell of the board not set in blocked
+void InvertBoard(const BitBoard &blocked, BitBoard &open);
+
+// whether the open cells among the eight around (x, y) are joined to each other round the ring, not
+// counting (x, y) itself. If they are, closing (x, y) can't cut anything off, if not it might.
+bool LocallyConnected(const BitBoard &open, int x, int y, bool wrap);
+
+// whether the open cells around (x, y) would all still be connected to each other with (x, y) closed, so
+// closing it can't cut the open cells in two. Most cells are settled by LocallyConnected, the rest
+// with a fill in scratch, which doesn't allocate once it has been reserved for the board. (x, y) is left as
+// it was in open.
+bool StaysConnected(BitBoard &open, int x, int y, bool wrap, FloodFillScratch &scratch);
@@ -0,0 +1,79 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FramePacer::FramePacer(double hz, PacingMode mode) :
+  _mode(mode),
+  _period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz)))
+{
+  Start();
+}
+
+void FramePacer::Start()
+{
+  _last = Clock::now();
+  _next = _last + _period;
+  ResetStats();
+}
+
+void FramePacer::Wait()
+{
+  if(_mode == PacingMode::kSleepSpin) {
+    Clock::time_point now = Clock::now();
+    if(now - _next > _period * PACER_MAX_LAG_PERIODS) {
+      // too far behind (a debugger break, a window drag), don't rush through the missed frames
+      _next = now;
+    } else {
+      SleepSpinUntil(_next);
+    }
+    _next += _period;
+  }
+
+  Record(Clock::now());
+}
+
+// sleep is only accurate to about a millisecond, so stop short of the deadline and spin the rest
+void FramePacer::SleepSpinUntil(Clock::time_point deadline) const
+{
+  Clock::time_point wake = deadline - std::chrono::microseconds(PACER_SPIN_MARGIN_US);
+  if(Clock::now() < wake) {
+    std::this_thread::sleep_until(wake);
+  }
+  while(Clock::now() < deadline) {
+  }
+}
+
+void FramePacer::Record(Clock::time_point now)
+{
+  double us = std::chrono::duration<double, std::micro>(now - _last).count();
+  _last = now;
+
+  _minUs = (_count == 0) ? us : std::min(_minUs, us);
+  _maxUs = (_count == 0) ? us : std::max(_maxUs, us);
+  _sumUs += us;
+  _sumSqUs += us * us;
+  _count++;
+}
+
+PacingStats FramePacer::Stats() const
+{
+  PacingStats stats;
+  if(_count == 0) return stats;
+
+  stats.frames = static_cast<int>(_count);
+  stats.meanUs = _sumUs / _count;
+  stats.jitterUs = std::sqrt(std::max(0.0, (_sumSqUs / _count) - (stats.meanUs * stats.meanUs)));
+  stats.minUs = _minUs;
+  stats.maxUs = _maxUs;
+  return stats;
+}
+
+void FramePacer::ResetStats()
+{
+  _count = 0;
+  _sumUs = 0.0;
+  _sumSqUs = 0.0;
+  _minUs = 0.0;
+  _maxUs = 0.0;
+}
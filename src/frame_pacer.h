@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+    file: frame_pacer.h - contains class FramePacer, which holds a loop to a fixed cadence using the
+    high resolution steady clock. Deadlines are kept on an absolute schedule (start + n * period), so
+    rounding never accumulates into drift, and the measured interval between frames is kept so the
+    jitter can be reported.
+*/
+
+#include <chrono>
+#include <cstdint>
+
+#define PACER_SPIN_MARGIN_US 2000   // sleep until this close to the deadline, then spin the rest of the way
+#define PACER_MAX_LAG_PERIODS 4     // further behind than this and the schedule restarts instead of catching up
+
+enum class PacingMode {
+  kSleepSpin,   // sleep most of the period, then spin to the exact deadline
+  kVsync,       // present waits for the display, the pacer only measures
+  kUncapped     // run as fast as possible, for benchmarks
+};
+
+struct PacingStats {
+  int frames{0};
+  double meanUs{0.0};     // mean interval between frames
+  double jitterUs{0.0};   // standard deviation of the interval
+  double minUs{0.0};
+  double maxUs{0.0};
+};
+
+class FramePacer {
+ public:
+  FramePacer(double hz, PacingMode mode);
+
+  // start the schedule from now
+  void Start();
+
+  // wait for the next frame's deadline (in kSleepSpin mode) and record the interval since the last call
+  void Wait();
+
+  PacingMode Mode() const { return _mode; }
+
+  // stats since the last reset
+  PacingStats Stats() const;
+  void ResetStats();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  void SleepSpinUntil(Clock::time_point deadline) const;
+  void Record(Clock::time_point now);
+
+  PacingMode _mode;
+  Clock::duration _period;
+  Clock::time_point _next;
+  Clock::time_point _last;
+
+  int64_t _count{0};
+  double _sumUs{0.0};
+  double _sumSqUs{0.0};
+  double _minUs{0.0};
+  double _maxUs{0.0};
+};
@@ -0,0 +1,51 @@
+#include "frame_snapshot.h"
+
+void FrameSnapshot::Reserve(std::size_t bodyCells, std::size_t repaintCells, std::size_t dirtyCells, std::size_t particleCount)
+{
+    body.reserve(bodyCells);
+    repaint.reserve(repaintCells);
+    dirty.reserve(dirtyCells);
+    particles.Reserve(particleCount);
+}
+
+void FrameSnapshot::ReserveWindow(int width, int height)
+{
+    cells.reserve(static_cast<std::size_t>(width) * height);
+    rowStart.reserve(height + 1);
+}
+
+SnapshotBuffer::SnapshotBuffer()
+{
+}
+
+void SnapshotBuffer::Reserve(std::size_t bodyCells, std::size_t repaintCells, std::size_t dirtyCells, std::size_t particles)
+{
+    for(FrameSnapshot &slot : _slots) {
+        slot.Reserve(bodyCells, repaintCells, dirtyCells, particles);
+    }
+}
+
+void SnapshotBuffer::ReserveWindow(int width, int height)
+{
+    for(FrameSnapshot &slot : _slots) {
+        slot.ReserveWindow(width, height);
+    }
+}
+
+void SnapshotBuffer::Publish()
+{
+    // hand the filled slot over and take back whichever one was waiting in the middle
+    uint8_t prev = _middle.exchange(static_cast<uint8_t>(_back) | kFresh, std::memory_order_acq_rel);
+    _back = prev & kIndexMask;
+}
+
+const FrameSnapshot* SnapshotBuffer::Latest()
+{
+    if(_middle.load(std::memory_order_relaxed) & kFresh) {
+        uint8_t prev = _middle.exchange(static_cast<uint8_t>(_front), std::memory_order_acq_rel);
+        _front = prev & kIndexMask;
+        _hasFront = true;
+        _taken.store(_slots[_front].tick, std::memory_order_release);
+    }
+    return _hasFront ? &_slots[_front] : nullptr;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+    file: frame_snapshot.h - contains struct FrameSnapshot and class SnapshotBuffer. At the end of every tick the
+    simulation thread copies what the renderer needs (the cells that changed and the HUD values, and the cells
+    around the head or a band of rows when the renderer asks for them, colors already resolved) into a
+    snapshot and publishes it. What a snapshot holds is bounded by the screen and a fixed budget, never by the
+    board. The render thread only ever reads snapshots, so it never touches the game objects while the
+    simulation is changing them.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "hud.h"
+#include "particles.h"
+
+struct SnapshotCell {
+    int x;
+    int y;
+    SDL_Color color;
+};
+
+struct FrameSnapshot {
+    uint64_t tick{0};             // increases by one for every published snapshot
+
+    SDL_Point head{0, 0};
+    SDL_Color headColor{0, 0, 0, 0};
+    SDL_Color bodyColor{0, 0, 0, 0};
+    std::vector<SDL_Point> body;          // every body cell, only filled in when snakeRecolored
+
+    // the largest viewport the camera can show around the head, so any viewport centered on it falls inside.
+    // Empty unless asked for. cells holds every cell in it that isn't background, with the color on top, a
+    // row at a time: those of row window.y + r are [rowStart[r], rowStart[r + 1]), in order along the row.
+    SDL_Rect window{0, 0, 0, 0};
+    std::vector<SnapshotCell> cells;
+    std::vector<int32_t> rowStart;
+
+    // rows repaintFrom <= y < repaintTo of the whole board in the same form, so the renderer can rebuild its
+    // copy of the board a band at a time. Empty unless asked for.
+    int repaintFrom{0};
+    int repaintTo{0};
+    std::vector<SnapshotCell> repaint;
+
+    std::vector<SnapshotCell> dirty;      // cells that changed from dirtySince to this tick, with the color now on top
+    uint64_t dirtySince{0};               // the first tick the dirty list covers, after the last snapshot the reader took
+    bool repaintAll{true};                // the dirty list doesn't cover the changes, repaint everything
+    bool snakeRecolored{false};           // every snake cell changed color
+
+    ParticleSnapshot particles;           // drawn over the board, they never touch the dirty cells
+
+    HudData hud;
+
+    void Reserve(std::size_t bodyCells, std::size_t repaintCells, std::size_t dirtyCells, std::size_t particleCount = 0);
+    void ReserveWindow(int width, int height);
+};
+
+// lock-free triple buffer, one thread publishes and one thread reads. The writer always has a slot to fill,
+// the reader always has a slot to draw from, and the third slot holds the newest snapshot not yet picked up.
+// If the writer publishes twice before the reader looks, the older snapshot is skipped, so the writer asks
+// Taken() which tick the reader has and puts every change since then into the next one. The reader says
+// which of the window and the repaint band it wants with Request, and gets them in the snapshots after.
+class SnapshotBuffer {
+ public:
+    SnapshotBuffer();
+
+    void Reserve(std::size_t bodyCells, std::size_t repaintCells, std::size_t dirtyCells, std::size_t particles = 0);
+    void ReserveWindow(int width, int height);
+
+    // writer side: fill this slot, then publish it
+    FrameSnapshot& WriteSlot() { return _slots[_back]; }
+    void Publish();
+
+    // reader side: the newest published snapshot, or nullptr if nothing has been published yet.
+    // The snapshot stays valid until the next call.
+    const FrameSnapshot* Latest();
+
+    // writer side: the tick of the newest snapshot the reader has picked up, 0 if none
+    uint64_t Taken() const { return _taken.load(std::memory_order_acquire); }
+
+    // reader side: whether snapshots should carry the window, and the first row of the board the reader still
+    // needs repainted, -1 for none. Nothing is asked for until the reader first says.
+    void Request(bool window, int repaintRow)
+    {
+        _wantWindow.store(window, std::memory_order_relaxed);
+        _repaintRow.store(repaintRow, std::memory_order_relaxed);
+    }
+
+    // writer side: what the reader last asked for
+    bool WindowWanted() const { return _wantWindow.load(std::memory_order_relaxed); }
+    int RepaintRow() const { return _repaintRow.load(std::memory_order_relaxed); }
+
+ private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;     // set when the middle slot holds a snapshot the reader hasn't seen
+
+    FrameSnapshot _slots[3];
+    int _back{0};                     // only used by the writer
+    int _front{1};                    // only used by the reader
+    bool _hasFront{false};
+    std::atomic<uint8_t> _middle{2};
+    std::atomic<uint64_t> _taken{0};
+    std::atomic<bool> _wantWindow{false};
+    std::atomic<int> _repaintRow{-1};
+};
@@ -0,0 +1,88 @@
+#include <chrono>
+#include "fuse_worker.h"
+#include "game_element.h"
+#include "trace.h"
+
+FuseWorker& FuseWorker::Shared()
+{
+    static FuseWorker worker;
+    return worker;
+}
+
+FuseWorker::FuseWorker() :
+    _thread(&FuseWorker::Run, this)
+{
+}
+
+FuseWorker::~FuseWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_one();
+    _thread.join();
+}
+
+void FuseWorker::Light(Bomb *bomb)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        bomb->_actionTimer = DEFAULT_ACTION_TIMER;
+        if(bomb->_burning) return;
+
+        bomb->_burning = true;
+        bomb->_nextLit = _lit;
+        _lit = bomb;
+    }
+    _wake.notify_one();
+}
+
+void FuseWorker::Douse(Bomb *bomb)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!bomb->_burning) return;
+
+    for(Bomb **link = &_lit; *link; link = &(*link)->_nextLit) {
+        if(*link == bomb) {
+            *link = bomb->_nextLit;
+            break;
+        }
+    }
+    bomb->_nextLit = nullptr;
+    bomb->_burning = false;
+}
+
+void FuseWorker::Run()
+{
+    Trace::NameThread("bomb fuses");
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    while(!_stopping) {
+        if(!_lit) {
+            _wake.wait(lock, [this] { return _stopping || _lit; });
+            next = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        {
+            TRACE_SPAN("BurnFuses");
+            Bomb **link = &_lit;
+            while(*link) {
+                Bomb *bomb = *link;
+                if(bomb->BurnFuse()) {
+                    link = &bomb->_nextLit;
+                } else {
+                    *link = bomb->_nextLit;
+                    bomb->_nextLit = nullptr;
+                    bomb->_burning = false;
+                }
+            }
+        }
+
+        // on a fixed cadence, a step that runs late doesn't push the rest back
+        next += std::chrono::milliseconds(FUSE_STEP_MS);
+        _wake.wait_until(lock, next, [this] { return _stopping; });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+    file: fuse_worker.h - contains class FuseWorker, the one thread that burns the fuse of every lit bomb.
+    It is started with the first bomb the program makes and waits on a condition variable while no fuse is
+    burning. Lit bombs are kept on a list threaded through the bombs themselves, so lighting, putting out
+    and exploding a bomb never allocates. Every FUSE_STEP_MS it steps each lit bomb's fuse once, which
+    changes its color every eighth of the way and tells the game when it has burnt down.
+*/
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define FUSE_STEP_MS 5      // how long each of a fuse's DEFAULT_ACTION_TIMER steps takes
+
+class Bomb;
+
+class FuseWorker {
+ public:
+    // the worker every bomb burns on, started the first time it's asked for
+    static FuseWorker& Shared();
+
+    ~FuseWorker();
+
+    FuseWorker(const FuseWorker&) = delete;
+    FuseWorker& operator=(const FuseWorker&) = delete;
+
+    // start burning the bomb's fuse from the top, or start it over if it is already burning
+    void Light(Bomb *bomb);
+
+    // stop the bomb's fuse without it exploding. Once this returns the worker won't touch the bomb again.
+    void Douse(Bomb *bomb);
+
+ private:
+    FuseWorker();
+    void Run();
+
+    std::mutex _mutex;                  // held while a fuse is stepped, lit or put out
+    std::condition_variable _wake;
+    Bomb *_lit{nullptr};                // the burning bombs, linked through Bomb::_nextLit
+    bool _stopping{false};
+    std::thread _thread;
+};
@@ -1,59 +1,451 @@
 #include "game.h"
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <thread>
 #include "SDL.h"
-
-using namespace std::placeholders;
+#include "debug_log.h"
+#include "trace.h"
 
 Game::Game(std::size_t grid_width, std::size_t grid_height)
-    : snake(grid_width, grid_height),
+    : Game(grid_width, grid_height, std::random_device{}()) {
+}
+
+Game::Game(std::size_t grid_width, std::size_t grid_height, BoardLayout layout)
+    : Game(grid_width, grid_height, std::random_device{}(), layout) {
+}
+
+Game::Game(std::size_t grid_width, std::size_t grid_height, uint64_t seed, BoardLayout layout)
+    : _dirty(grid_width, grid_height),
+      _local(grid_width, grid_height),
+      snake(_local.snake),
+      _index(grid_width, grid_height),
+      _walls(grid_width, grid_height),
+      _layout(layout),
+      _reach(_walls.ShownBits(), snake),
       food(foodColor),
-      _elements(),
-      engine(dev()),
-      random_w(0, static_cast<int>(grid_width-1)),
-      random_h(0, static_cast<int>(grid_height-1)) {
+      _particles(Xoshiro256::Stream(seed, RandomStream::kEffects)),
+      _placementRandom(Xoshiro256::Stream(seed, RandomStream::kPlacement)),
+      _spawnRandom(Xoshiro256::Stream(seed, RandomStream::kSpawning)),
+      _wallRandom(Xoshiro256::Stream(seed, RandomStream::kWalls)),
+      _roundRandom(Xoshiro256::Stream(seed, RandomStream::kRounds)),
+      board_bits(grid_width, grid_height),
+      _blast(DEFAULT_BOMB_RADIUS, DEFAULT_BOMB_SHAPE),
+      _dirtyHistory(grid_width, grid_height),
+      _repaintRows(std::max(1, REPAINT_CELLS_PER_TICK / static_cast<int>(grid_width))),
+      _arena(GAME_ARENA_BYTES),
+      _pool(&_index, &_events, &_arena) {
+  snake.SetEventQueue(&_events);
+  snake.SetDirtyCells(&_dirty);
+  _players.push_back(&_local);
+  _index.SetDirtyCells(&_dirty);
+  _walls.SetDirtyCells(&_dirty);
+  food.AttachIndex(&_index);
+  _appearing.reserve(POOL_CHUNK_SIZE);
+  _litBombs.reserve(POOL_CHUNK_SIZE);
+
+  // create the power-ups up front so play doesn't allocate
+  for(int t = 0; t < GameElement::NUM_ELEMENT_TYPES; ++t) {
+    if(t != GameElement::WALL) {
+      _pool.Reserve(static_cast<GameElement::ElementType>(t), POOL_CHUNK_SIZE);
+    }
+  }
+  _openScratch.Resize(grid_width, grid_height);
+  CreateWalls();
+  _walls.Reserve();
+
+  // nothing a snapshot holds grows with the board: the band is a fixed number of cells and the window around
+  // the head is sized for the screen once Run knows it
+  _snapshots.Reserve(std::min<std::size_t>(grid_width * grid_height, MAX_BODY_RESERVE),
+                     static_cast<std::size_t>(_repaintRows) * grid_width, DIRTY_CELLS_RESERVE, PARTICLE_CAPACITY);
+  _fillScratch.Reserve(grid_width, grid_height);
+  PlaceFood();
+}
+
+void Game::Restart() {
+  Restart(_roundRandom.Next());
+}
+
+void Game::Restart(uint64_t seed) {
+  TRACE_SPAN("Restart");
+
+  // stop the bomb fuses before their events are thrown away, then put every power-up back
+  _pool.Recycle();
+  _events.Drain([](const GameEvent &) { });
+  _appearing.clear();
+  _litBombs.clear();
+
+  for (Player *player : _players) {
+    player->snake.Reset();
+    player->ResetScore();
+  }
+  food.Hide();
+  _walls.Clear();
+  board_bits.Clear();
+  _particles.Reset(Xoshiro256::Stream(seed, RandomStream::kEffects));
+  _placementRandom = Xoshiro256::Stream(seed, RandomStream::kPlacement);
+  _spawnRandom = Xoshiro256::Stream(seed, RandomStream::kSpawning);
+  _wallRandom = Xoshiro256::Stream(seed, RandomStream::kWalls);
+  _roundRandom = Xoshiro256::Stream(seed, RandomStream::kRounds);
+
   CreateWalls();
+  _walls.Reserve();
+
+  // everything changed, the regions and distances start over and the renderer repaints the whole board
+  _dirty.MarkAll();
+  _reach.Sync(_dirty);
+  if (_distances) _distances->Sync(_dirty);
+
+  // player 0 starts in the middle, where the layout left room, the others wherever there's a free cell
+  for (std::size_t id = 1; id < _players.size(); ++id) {
+    if (_players[id]->active) {
+      const SDL_Point cell = GetUnoccupiedLocation();
+      _players[id]->snake.Reset(cell.x, cell.y);
+    }
+  }
   PlaceFood();
-  std::cout << "w_min: " << random_w.min() << " w_max: " << random_w.max() << "  h_min: " << random_h.min() << " h_max: " << random_h.max() << std::endl;
+  DEBUG_LOG("Restarted");
+}
+
+void Game::EnableRewind(double seconds, double ticks_per_second) {
+  _rewind.reset(new Rewind(*this, seconds, ticks_per_second));
+}
+
+uint64_t Game::RewindBy(double seconds) {
+  if (!_rewind) return 0;
+  return _rewind->Seek(_rewind->TicksFor(seconds));
 }
 
 void Game::Run(Controller const &controller, Renderer &renderer,
-               std::size_t target_frame_duration) {
-  Uint32 title_timestamp = SDL_GetTicks();
-  Uint32 frame_start;
-  Uint32 frame_end;
-  Uint32 frame_duration;
-  int frame_count = 0;
+               double ticks_per_second, double frames_per_second, PacingMode mode) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point report_timestamp = Clock::now();
+  Clock::time_point frame_start;
+  Clock::time_point frame_end;
+  double frame_time_total = 0.0;    // microseconds spent on input and render since the last report
+  int fps = 0;
+  int frame_us = 0;
+  int jitter_us = 0;
   bool running = true;
+  HudData hud;
+
+  // publish every tick for other processes (does nothing unless built with SHM_EXPORT)
+  _exporter.Open(board_bits.Width(), board_bits.Height(), board_bits.WordsPerRow(), PlaneWords());
+
+  // the window around the head has to hold any viewport the renderer's camera can zoom to
+  _windowCamera.reset(new Camera(renderer.GetCamera()));
+  const SDL_Rect window = _windowCamera->LargestViewport(0, 0);
+  _snapshots.ReserveWindow(window.w, window.h);
+  _snapshots.Request(renderer.WantsWindow(), renderer.RepaintRow());
 
+  // update runs on its own thread so a slow present doesn't hold up the simulation
+  _running = true;
+  std::thread simulation(&Game::Simulate, this, ticks_per_second);
+  Trace::NameThread("main");
+
+  FramePacer pacer(frames_per_second, mode);
+  renderer.SetFrameTarget(1000000.0 / frames_per_second);
   while (running) {
-    frame_start = SDL_GetTicks();
+    TRACE_SPAN("frame");
+    frame_start = Clock::now();
 
-    // Input, Update, Render - the main game loop.
-    controller.HandleInput(running, snake, this);
-    Update();
-    renderer.Render(snake, food, _elements);
+    // Input and Render - the main thread's half of the game loop.
+    // Each phase is tagged so heap allocations can be counted per subsystem.
+    {
+      AllocScope scope(AllocTag::kInput);
+      TRACE_SPAN("input");
+      controller.HandleInput(running, _input, renderer.GetCamera());
+    }
+    {
+      AllocScope scope(AllocTag::kRender);
+      TRACE_SPAN("render");
+      const FrameSnapshot *snapshot = _snapshots.Latest();
+      if (snapshot) {
+        hud = snapshot->hud;
+        hud.fps = fps;
+        hud.frameUs = frame_us;
+        hud.jitterUs = jitter_us;
+        renderer.Render(*snapshot, hud);
+      }
+      _snapshots.Request(renderer.WantsWindow(), renderer.RepaintRow());
+    }
 
-    frame_end = SDL_GetTicks();
+    frame_end = Clock::now();
 
-    // Keep track of how long each loop through the input/update/render cycle
+    // Keep track of how long each loop through the input/render cycle
     // takes.
-    frame_count++;
-    frame_duration = frame_end - frame_start;
-
-    // After every second, update the window title.
-    if (frame_end - title_timestamp >= 1000) {
-      renderer.UpdateWindowTitle(score, _multiplier, _multiplierTimer/60, frame_count, snake.GetData());
-      frame_count = 0;
-      title_timestamp = frame_end;
+    frame_time_total += std::chrono::duration<double, std::micro>(frame_end - frame_start).count();
+
+    // Wait for the next frame's deadline, this also measures the interval between frames.
+    pacer.Wait();
+
+    // After every second, update the frame stats shown in the HUD.
+    PacingStats stats = pacer.Stats();
+    bool report = (frame_end - report_timestamp >= std::chrono::seconds(1));
+    TrackFrameAllocations(report, stats.frames);
+    if (report && stats.frames > 0) {
+      fps = static_cast<int>(std::lround(1000000.0 / stats.meanUs));
+      frame_us = static_cast<int>(frame_time_total / stats.frames);
+      jitter_us = static_cast<int>(stats.jitterUs);
+      _exportFps.store(fps, std::memory_order_relaxed);
+      _exportFrameUs.store(frame_us, std::memory_order_relaxed);
+      _exportJitterUs.store(jitter_us, std::memory_order_relaxed);
+      DEBUG_LOG("Frame interval over " << stats.frames << " frames: mean " << stats.meanUs << " us, jitter " << stats.jitterUs
+                << " us, min " << stats.minUs << " us, max " << stats.maxUs << " us");
+      pacer.ResetStats();
+      frame_time_total = 0.0;
+      report_timestamp = frame_end;
+    }
+  }
+
+  _running = false;
+  simulation.join();
+}
+
+// the simulation thread, one Update per tick followed by a snapshot for the renderer
+void Game::Simulate(double ticks_per_second) {
+  // the snake's speed is per tick, so the simulation always holds its rate whatever the display does
+  FramePacer pacer(ticks_per_second, PacingMode::kSleepSpin);
+  Trace::NameThread("simulation");
+
+  while (_running) {
+    {
+      AllocScope scope(AllocTag::kUpdate);
+      TRACE_SPAN("tick");
+      auto tick_start = std::chrono::steady_clock::now();
+      {
+        TRACE_SPAN("update");
+        Update();
+      }
+      {
+        TRACE_SPAN("publish");
+        PublishSnapshot();
+      }
+      if (_exporter.IsOpen()) {
+        auto tick_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tick_start);
+        ExportState(static_cast<int>(tick_us.count()));
+      }
     }
+    pacer.Wait();
+  }
+}
 
-    // If the time for this frame is too small (i.e. frame_duration is
-    // smaller than the target ms_per_frame), delay the loop to
-    // achieve the correct frame rate.
-    if (frame_duration < target_frame_duration) {
-      SDL_Delay(target_frame_duration - frame_duration);
+// copy everything the renderer needs out of the game objects, colors are resolved here so the render
+// thread never has to read an element
+void Game::PublishSnapshot()
+{
+  FrameSnapshot &snapshot = _snapshots.WriteSlot();
+  snapshot.tick = ++_tick;
+
+  snapshot.head = {snake.HeadX(), snake.HeadY()};
+  snapshot.headColor = snake.head_color.toSDLColor();
+  snapshot.bodyColor = snake.body_color.toSDLColor();
+
+  // every cell changed since the snapshot the renderer last took, so one it skips doesn't take its changes
+  // with it. The colors are the ones on top now.
+  _dirtyHistory.Record(_dirty, snapshot.tick);
+  const uint64_t taken = _snapshots.Taken();
+  snapshot.dirty.clear();
+  snapshot.dirtySince = taken + 1;
+  snapshot.repaintAll = !_dirtyHistory.ForEachSince(taken, [&](int x, int y) {
+    snapshot.dirty.push_back({x, y, CellColor(x, y)});
+  });
+  snapshot.snakeRecolored = _dirtyHistory.SnakeRecoloredSince(taken);
+  snapshot.body.clear();
+  if (snapshot.snakeRecolored) {
+    // a body that crossed itself can list a cell its tail has since left, the occupancy has the truth
+    const BitBoard &occupancy = snake.GetOccupancy();
+    for (const SDL_Point &cell : snake.body) {
+      if (occupancy.InBounds(cell.x, cell.y) && occupancy.Test(cell.x, cell.y)) snapshot.body.push_back(cell);
     }
   }
+  _dirty.Clear();
+
+  // the cells around the head for any zoom, and the next band of rows while the renderer rebuilds its copy
+  // of the board. Each is only a rectangle of the board, and only there when the renderer asked for it (or,
+  // for the window, when the dirty list can't keep its copy right).
+  snapshot.window = SDL_Rect{0, 0, 0, 0};
+  snapshot.cells.clear();
+  snapshot.rowStart.clear();
+  if (_windowCamera && (_snapshots.WindowWanted() || snapshot.repaintAll)) {
+    const SDL_Rect window = _windowCamera->LargestViewport(snake.HeadX(), snake.HeadY());
+    snapshot.window = window;
+    AppendCells(window.x, window.y, window.x + window.w, window.y + window.h, snapshot.cells, &snapshot.rowStart);
+  }
+  const int repaint_row = _snapshots.RepaintRow();
+  snapshot.repaintFrom = 0;
+  snapshot.repaintTo = 0;
+  snapshot.repaint.clear();
+  if (repaint_row >= 0 && repaint_row < board_bits.Height()) {
+    snapshot.repaintFrom = repaint_row;
+    snapshot.repaintTo = std::min(board_bits.Height(), repaint_row + _repaintRows);
+    AppendCells(0, snapshot.repaintFrom, board_bits.Width(), snapshot.repaintTo, snapshot.repaint, nullptr);
+  }
+
+  _particles.CopyTo(snapshot.particles);
+
+  UpdateHudData(snapshot.hud);
+
+  _snapshots.Publish();
+}
+
+void Game::WriteBitplanes(uint64_t *planes) const
+{
+  const std::size_t words = board_bits.WordCount();
+  auto copy = [&](BoardPlane plane, const BitBoard &bits) {
+    std::memcpy(planes + plane * words, bits.Data(), words * sizeof(uint64_t));
+  };
+  // a plane with just one cell set (or none if the cell is off the board)
+  auto single = [&](BoardPlane plane, int x, int y) {
+    uint64_t *out = planes + plane * words;
+    std::memset(out, 0, words * sizeof(uint64_t));
+    if (board_bits.InBounds(x, y)) {
+      out[y * board_bits.WordsPerRow() + (x >> 6)] |= uint64_t{1} << (x & 63);
+    }
+  };
+
+  copy(kPlaneBody, snake.GetOccupancy());
+  single(kPlaneHead, snake.HeadX(), snake.HeadY());
+  single(kPlaneFood, food.GetLocation().x, food.GetLocation().y);
+  copy(kPlaneBoard, board_bits);
+  copy(kPlaneWall, _walls.ShownBits());
+  copy(kPlanePotion, _index.TypeMask(GameElement::POTION));
+  copy(kPlaneBomb, _index.TypeMask(GameElement::BOMB));
+  copy(kPlaneShrinkPill, _index.TypeMask(GameElement::SHRINK_PILL));
+  copy(kPlaneSlowPill, _index.TypeMask(GameElement::SLOW_PILL));
+}
+
+// write this tick into the shared memory ring, readers in other processes see it once EndWrite returns
+void Game::ExportState(int tick_us)
+{
+  ShmExporter::Slot slot = _exporter.BeginWrite(_tick);
+  ShmTickInfo &info = slot.header->info;
+  info.tick = _tick;
+  info.score = _local.score;
+  info.multiplier = _local.multiplier;
+  info.multiplierTimer = _local.multiplierTimer;
+  info.size = snake.GetSize();
+  info.alive = snake.alive ? 1 : 0;
+  info.fps = _exportFps.load(std::memory_order_relaxed);
+  info.frameUs = _exportFrameUs.load(std::memory_order_relaxed);
+  info.jitterUs = _exportJitterUs.load(std::memory_order_relaxed);
+  info.tickUs = tick_us;
+
+  WriteBitplanes(slot.planes);
+
+  // head first, then the body from the neck back to the tail
+  int count = 0;
+  if (count < slot.maxCells) {
+    slot.cells[count++] = {snake.HeadX(), snake.HeadY()};
+  }
+  for (auto it = snake.body.rbegin(); it != snake.body.rend() && count < slot.maxCells; ++it) {
+    slot.cells[count++] = {it->x, it->y};
+  }
+  info.cellCount = count;
+
+  _exporter.EndWrite(slot, _tick);
+}
+
+// the color drawn in a cell, in the same order the renderer draws: head, then body, then walls, then elements
+SDL_Color Game::CellColor(int x, int y) const
+{
+  if (x == snake.HeadX() && y == snake.HeadY()) {
+    return snake.head_color.toSDLColor();
+  }
+  if (snake.GetOccupancy().InBounds(x, y) && snake.GetOccupancy().Test(x, y)) {
+    return snake.body_color.toSDLColor();
+  }
+  if (_walls.Shown(x, y)) {
+    return _walls.CellColor(x, y);
+  }
+  if (GameElement *g = _index.At(x, y)) {
+    return g->getColor().toSDLColor();
+  }
+  return screenBackgroundColor.toSDLColor();
+}
+
+// append every cell with x0 <= x < x1 in rows y0 <= y < y1 that isn't background, with the color on top,
+// a row at a time. Only the words covering those columns are read, and rowStart gets where each row begins.
+void Game::AppendCells(int x0, int y0, int x1, int y1, std::vector<SnapshotCell> &out, std::vector<int32_t> *rowStart) const
+{
+  if (x0 >= x1) return;
+  const BitBoard &body = snake.GetOccupancy();
+  const BitBoard &elements = _index.Occupied();
+  const BitBoard &walls = _walls.ShownBits();
+  const int first_word = x0 >> 6;
+  const int last_word = (x1 - 1) >> 6;
+  for (int y = y0; y < y1; ++y) {
+    if (rowStart) rowStart->push_back(static_cast<int32_t>(out.size()));
+    const uint64_t *body_row = body.Row(y);
+    const uint64_t *element_row = elements.Row(y);
+    const uint64_t *wall_row = walls.Row(y);
+    for (int w = first_word; w <= last_word; ++w) {
+      uint64_t bits = body_row[w] | element_row[w] | wall_row[w];
+      if (y == snake.HeadY() && snake.HeadX() >= 0 && (snake.HeadX() >> 6) == w) {
+        bits |= uint64_t{1} << (snake.HeadX() & 63);
+      }
+      if (w == first_word) bits &= (~uint64_t{0} << (x0 & 63));
+      if (w == last_word) bits &= (~uint64_t{0} >> (63 - ((x1 - 1) & 63)));
+      while (bits) {
+        const int x = (w << 6) + __builtin_ctzll(bits);
+        out.push_back({x, y, CellColor(x, y)});
+        bits &= bits - 1;
+      }
+    }
+  }
+  if (rowStart) rowStart->push_back(static_cast<int32_t>(out.size()));
+}
+
+// count this frame's allocations, and in steady state make sure update and render did none
+void Game::TrackFrameAllocations(bool report, int frames)
+{
+  if(!AllocTracker::Enabled()) return;
+
+  AllocCounts now = AllocTracker::Snapshot();
+
+#ifdef ALLOC_ASSERT_STEADY_STATE
+  const int update = static_cast<int>(AllocTag::kUpdate);
+  const int render = static_cast<int>(AllocTag::kRender);
+  if(_frameNumber > ALLOC_WARMUP_FRAMES) {
+    uint64_t update_allocs = now.count[update] - _frameAllocs.count[update];
+    uint64_t render_allocs = now.count[render] - _frameAllocs.count[render];
+    if(update_allocs != 0 || render_allocs != 0) {
+      std::cerr << "Frame " << _frameNumber << " allocated in steady state: update " << update_allocs << ", render " << render_allocs << std::endl;
+      std::abort();
+    }
+  }
+#endif
+  _frameAllocs = now;
+  _frameNumber++;
+
+  if(report && frames > 0) {
+    std::cout << "Allocations over the last " << frames << " frames:";
+    for(int tag = 0; tag < static_cast<int>(AllocTag::kNumTags); ++tag) {
+      uint64_t count = now.count[tag] - _reportAllocs.count[tag];
+      uint64_t bytes = now.bytes[tag] - _reportAllocs.bytes[tag];
+      std::cout << " " << AllocTracker::TagName(static_cast<AllocTag>(tag)) << " " << count << " (" << bytes << " bytes)";
+    }
+    std::cout << std::endl;
+    _reportAllocs = now;
+  }
+}
+
+// copy the game values shown in the HUD, the frame stats are filled in by Run
+void Game::UpdateHudData(HudData &hud)
+{
+  SnakeData *pData = snake.GetData();
+  hud.score = _local.score;
+  hud.multiplier = _local.multiplier;
+  hud.timer = _local.multiplierTimer / 60;
+  hud.potions = pData->potions;
+  hud.bombs = pData->bombs;
+  hud.shrinkpills = pData->shrinkpills;
+  hud.slowpills = pData->slowpills;
+  hud.alive = snake.alive;
 }
 
 void Game::DebugPrint()
@@ -63,14 +455,19 @@ void Game::DebugPrint()
 
 void Game::CreateWalls()
 {
+  if(_layout != BoardLayout::kPerimeter) {
+    CreateLayoutWalls();
+    return;
+  }
+
   // create walls around the perimiter of the board
   // but leave a 10% gap in the middle
-  int x_start = random_w.min();
-  int x_end = random_w.max();
+  int x_start = 0;
+  int x_end = board_bits.Width() - 1;
   int x_grid_count = x_end - x_start;
 
-  int y_start = random_h.min();
-  int y_end = random_h.max();
+  int y_start = 0;
+  int y_end = board_bits.Height() - 1;
   int y_grid_count =  - y_end - y_start;
 
   int x_half_gap_width = x_grid_count / 5;
@@ -78,136 +475,236 @@ void Game::CreateWalls()
 
   for(int x = x_start; x < x_end; ++x) {
     if(x < ((x_grid_count/2) - x_half_gap_width) || x > ((x_grid_count/2) + x_half_gap_width)) {
-      std::shared_ptr<GameElement> g1 = GameElement::CreateGameElement(GameElement::WALL, x, y_start);
-      std::shared_ptr<GameElement> g2 = GameElement::CreateGameElement(GameElement::WALL, x, y_end);
-      _elements.emplace_back(g1);
-      _elements.emplace_back(g2);
-      std::cout << "Wall " << g1->_id << ") placed at " << x << ", " << y_start << " (" << g1->GetLocation().x << ", " << g1->GetLocation().y << ")" << std::endl;
-      std::cout << "Wall " << g2->_id << ") placed at " << x << ", " << y_end << " (" << g2->GetLocation().x << ", " << g2->GetLocation().y << ")" << std::endl;
-      _wallCount += 2;
+      _walls.Add(x, y_start);
+      _walls.Add(x, y_end);
+      DEBUG_LOG("Wall placed at " << x << ", " << y_start);
+      DEBUG_LOG("Wall placed at " << x << ", " << y_end);
     }
   }
 
   for(int y = y_start; y < y_end; ++y) {
     if(y < ((y_grid_count/2) - y_half_gap_width) || y > ((y_grid_count/2) + y_half_gap_width)) {
-      std::shared_ptr<GameElement> g1 = GameElement::CreateGameElement(GameElement::WALL, x_start, y);
-      std::shared_ptr<GameElement> g2 = GameElement::CreateGameElement(GameElement::WALL, x_end, y);
-      _elements.emplace_back(g1);
-      _elements.emplace_back(g2);
-      std::cout << "Wall " << g1->_id << ") placed at " << x_start << ", " << y << " (" << g1->GetLocation().x << ", " << g1->GetLocation().y << ")" << std::endl;
-      std::cout << "Wall " << g2->_id << ") placed at " << x_end << ", " << y << " (" << g2->GetLocation().x << ", " << g2->GetLocation().y << ")" << std::endl;
-      _wallCount += 2;
+      _walls.Add(x_start, y);
+      _walls.Add(x_end, y);
+      DEBUG_LOG("Wall placed at " << x_start << ", " << y);
+      DEBUG_LOG("Wall placed at " << x_end << ", " << y);
     }
   }
 }
 
-// get the next non-visible wall element, if one exists
-std::shared_ptr<Wall> Game::GetNextWall()
+// a generated layout has its own seed from the game's, and its walls are solid from the start
+void Game::CreateLayoutWalls()
 {
-  // generate a random entry into the vector of walls
-  // this allows for an exploded wall to rematerialize later instead of 
-  // right away
-  int randIndex = random_w(engine) % _wallCount;
+  uint64_t layout_seed = _wallRandom.Next();
+  const int width = board_bits.Width();
+  const int height = board_bits.Height();
+  SDL_Point start{width / 2, height / 2};   // where the snake starts
+
+  // generated into the scratch board, it isn't needed until play starts
+  BitBoard &walls = _openScratch;
+  LayoutStats stats = GenerateLayout(_layout, layout_seed, start, walls);
+  for(int y = 0; y < height; ++y) {
+    walls.ForEachSetInRow(y, 0, width, [&](int x) {
+      _walls.AddSolid(x, y);
+      board_bits.Set(x, y);
+    });
+  }
 
-  // set the iterator to that element
-  auto it = _elements.begin() + randIndex;
+  DEBUG_LOG("Layout " << LayoutName(_layout) << ": " << _walls.WallCount() << " walls, " << stats.regions << " regions on "
+            << stats.threads << " threads in " << stats.generateMs << " ms, " << stats.tunnels << " tunnels dug in "
+            << stats.connectMs << " ms");
+}
 
-  while(it != _elements.end()) {
-    if((*it)->IsWall() && (*it)->IsHidden()) {
-      return std::static_pointer_cast<Wall>((*it));
-    }
-    ++it;
+void Game::TrackAppearing(GameElement *element)
+{
+  if(element->IsAppearing()) {
+    _appearing.emplace_back(element);
   }
-  return std::shared_ptr<Wall>();
 }
 
-// Get the next non-wall element that's not visible, if one exists
-std::shared_ptr<GameElement> Game::GetNextElement(GameElement::ElementType type)
+// fade in the appearing elements, even the ones that are off screen
+void Game::UpdateAppearing()
 {
-  for(auto &g : _elements) {
-    if((g->GetType() == type) && g->IsHidden() && g->IsAvailable()) {
-      return g;
+  for(std::size_t i = 0; i < _appearing.size();) {
+    _appearing[i]->UpdateColor();
+    _dirty.Mark(_appearing[i]->GetLocation().x, _appearing[i]->GetLocation().y);
+    if(!_appearing[i]->IsAppearing()) {
+      // done (or picked up/destroyed), swap it out of the list
+      _appearing[i] = _appearing.back();
+      _appearing.pop_back();
+    } else {
+      ++i;
     }
   }
-  return std::shared_ptr<GameElement>();
+}
+
+// a burning fuse changes color on the fuse thread, so its cell is repainted every frame until it explodes
+void Game::MarkLitBombs()
+{
+  for(GameElement *bomb : _litBombs) {
+    _dirty.Mark(bomb->GetLocation().x, bomb->GetLocation().y);
+  }
 }
 
 SDL_Point Game::GetUnoccupiedLocation()
 {
+  // only cells the head can get to, walls and the body can seal regions off
+  _reach.Sync(_dirty);
+
+  // keep the non-wall elements inside the walls
+  const int x_count = board_bits.Width() - 3;
+  const int y_count = board_bits.Height() - 3;
+
   int x = -1, y = -1;
   int counter = 20; // try to find a spot to place the element a number of times
-  while(counter-- > 0) {
-    // keep the non-wall elements inside the walls
-    x = (random_w(engine) % (random_w.max()-random_w.min()-2)) + 1;
-    y = (random_h(engine) % (random_h.max()-random_h.min()-2)) + 1;
+  while(counter-- > 0 && x_count > 0 && y_count > 0) {
+    x = _placementRandom.Between(1, x_count);
+    y = _placementRandom.Between(1, y_count);
 
-    // if that spot is unoccupied, break out of loop
-    if(((x >= 0) && (x < 128)) && ((y >= 0) && (y < 128)) && !board_bits[x].test(y) && !snake.SnakeCell(x, y))
+    // if that spot is unoccupied and reachable, use it
+    if(FreeCell(x, y))
     {
-      break;
+      return {x,y};
+    }
+  }
+
+  // the head's region is too small to hit at random, go through the same cells in order from the last try
+  if(x_count > 0 && y_count > 0 && x >= 1 && y >= 1) {
+    const int start = (y - 1) * x_count + (x - 1);
+    for(int i = 0; i < x_count * y_count; ++i) {
+      int cell = (start + i) % (x_count * y_count);
+      int cx = (cell % x_count) + 1;
+      int cy = (cell / x_count) + 1;
+      if(FreeCell(cx, cy)) {
+        return {cx, cy};
+      }
     }
   }
 
+  DEBUG_LOG("No free cell the head can reach");
   return {x,y};
 }
 
-void Game::PlaceNextWall()
+// nothing on the cell and no snake on it. In a game of one the head has to be able to get there too; with
+// more players there's a head in most regions, so that is left out.
+bool Game::FreeCell(int x, int y)
 {
-  std::shared_ptr<Wall> pCurElement = GetNextWall();
+  if(!board_bits.InBounds(x, y) || board_bits.Test(x, y)) return false;
+  for(const Player *player : _players) {
+    if(player->active && player->snake.SnakeCell(x, y)) return false;
+  }
+  return _players.size() > 1 || _reach.Reachable(x, y);
+}
+
+int Game::AddPlayer()
+{
+  int id = 0;
+  while(id < static_cast<int>(_players.size()) && _players[id]->active) ++id;
+  if(id == static_cast<int>(_players.size())) {
+    _guests.emplace_back(new Player(board_bits.Width(), board_bits.Height()));
+    Player *player = _guests.back().get();
+    player->snake.SetPlayer(id);
+    player->snake.SetEventQueue(&_events);
+    player->snake.SetDirtyCells(&_dirty);
+    _players.push_back(player);
+  }
+  _players[id]->active = true;
+  RespawnPlayer(id);
+  DEBUG_LOG("Player " << id << " joined at " << _players[id]->snake.HeadX() << ", " << _players[id]->snake.HeadY());
+  return id;
+}
+
+void Game::RemovePlayer(int player)
+{
+  Player *leaving = ActivePlayer(player);
+  if(!leaving) return;
+  ClearPlayer(*leaving);
+  leaving->snake.Reset();
+  leaving->active = false;
+  DEBUG_LOG("Player " << player << " left");
+}
+
+void Game::RespawnPlayer(int player)
+{
+  Player *respawning = ActivePlayer(player);
+  if(!respawning) return;
+  ClearPlayer(*respawning);
+  respawning->ResetScore();
+  const SDL_Point cell = GetUnoccupiedLocation();
+  respawning->snake.Reset(cell.x, cell.y);
+  _dirty.Mark(cell.x, cell.y);
+}
+
+// the player if there's one on the board with that id, events can outlive the player they name
+Player* Game::ActivePlayer(int player)
+{
+  if(player < 0 || player >= static_cast<int>(_players.size()) || !_players[player]->active) return nullptr;
+  return _players[player];
+}
 
-  if(pCurElement) {
-    pCurElement->SetVisibility(true);
+// the snake's cells are repainted and whatever it carries goes back in the pool, before it's reset
+void Game::ClearPlayer(Player &player)
+{
+  const Snake &leaving = player.snake;
+  _dirty.Mark(leaving.HeadX(), leaving.HeadY());
+  for(const SDL_Point &cell : leaving.body) {
+    _dirty.Mark(cell.x, cell.y);
+  }
+  player.snake.ReleaseItems();
+}
 
+void Game::PlaceNextWall()
+{
+  // pick any of the hidden walls, this allows for an exploded wall to
+  // rematerialize later instead of right away
+  SDL_Point cell;
+  if(_walls.TakeRandomHidden(_wallRandom, cell)) {
+    // a wall that would cut the open cells in two stays hidden, the snake could be shut off from the rest of
+    // the board. The snake wraps at the edges, so the check does too.
+    InvertBoard(_walls.ShownBits(), _openScratch);
+    if(!StaysConnected(_openScratch, cell.x, cell.y, true, _fillScratch)) {
+      _walls.PutBackHidden(cell.x, cell.y);
+      DEBUG_LOG("Wall at " << cell.x << ", " << cell.y << " would cut the board in two, left hidden");
+      return;
+    }
+
+    _walls.Show(cell.x, cell.y);
     // set the bits
-    board_bits[pCurElement->GetLocation().x].set(pCurElement->GetLocation().y);
+    board_bits.Set(cell.x, cell.y);
 
-    std::cout << "Placed " << pCurElement->GetElementTypeString() << " (" << pCurElement->_id << ") at " << pCurElement->GetLocation().x << ", " << pCurElement->GetLocation().y << std::endl;
+    DEBUG_LOG("Placed Wall at " << cell.x << ", " << cell.y);
   }
 }
 
 void Game::PlaceNextElement()
 {
-  std::cout << "PlaceNextElement" << std::endl;
-
-  int choice = random_w(engine);
-  int chance = random_h(engine);
+  TRACE_SPAN("PlaceNextElement");
+  DEBUG_LOG("PlaceNextElement");
 
   // only place something half the time
-  if(chance % 2 == 0) return;
+  if(_spawnRandom.Below(2) == 0) return;
 
-  GameElement::ElementType eType = static_cast<GameElement::ElementType>(choice % GameElement::NUM_ELEMENT_TYPES);
+  GameElement::ElementType eType = static_cast<GameElement::ElementType>(_spawnRandom.Below(GameElement::NUM_ELEMENT_TYPES));
 
   if(eType == GameElement::WALL) {
     PlaceNextWall();
   } else {
-    std::shared_ptr<GameElement> pCurElement = GetNextElement(eType);
-
-    std::cout << "GetNextElement returned item " << pCurElement.get() << std::endl;
+    GameElement *pCurElement = _pool.Acquire(eType);
 
-    if(!pCurElement) {
-      pCurElement = GameElement::CreateGameElement(eType);
-
-      // if this is a bomb, add the callback here
-      if(eType == GameElement::BOMB) {
-        pCurElement->SetUseCallbackFn(std::bind(&Game::ExplodeBomb, this, _1));
-      }
-
-      if(pCurElement) {
-        _elements.emplace_back(pCurElement);
-      }
-    }
+    DEBUG_LOG("Pool returned item " << pCurElement);
 
     if(pCurElement) {
       SDL_Point pt = GetUnoccupiedLocation();
-      std::cout << "New Loc: x: " << pt.x << "  y: " << pt.y << std::endl;
+      DEBUG_LOG("New Loc: x: " << pt.x << "  y: " << pt.y);
       if(pt.x >= 0) {
         pCurElement->SetLocation(pt.x, pt.y);
         pCurElement->SetVisibility(true);
+        TrackAppearing(pCurElement);
 
         // set the bits - duplicates are ok for now
-        board_bits[pCurElement->GetLocation().x].set(pCurElement->GetLocation().y);
+        board_bits.Set(pCurElement->GetLocation().x, pCurElement->GetLocation().y);
 
-        std::cout << "Placed " << pCurElement->GetElementTypeString() << " (" << pCurElement->_id << ") at " << pCurElement->GetLocation().x << ", " << pCurElement->GetLocation().y << "(" << choice << ")" << std::endl;
+        DEBUG_LOG("Placed " << pCurElement->GetElementTypeString() << " (" << pCurElement->_id << ") at " << pCurElement->GetLocation().x << ", " << pCurElement->GetLocation().y);
       }
     }
   }
@@ -221,141 +718,290 @@ void Game::PlaceFood()
 
     // Check that the location is not occupied by a snake item before placing food
     if(pt.x >= 0) {
-      std::cout << "New Food Loc: x: " << pt.x << "  y: " << pt.y << std::endl;
+      DEBUG_LOG("New Food Loc: x: " << pt.x << "  y: " << pt.y);
       food.SetLocation(pt.x, pt.y);
-      board_bits[pt.x].set(pt.y);
+      board_bits.Set(pt.x, pt.y);
       food.SetVisibility(true);
-      std::cout << "Food (" << food._id << ") added at " << food.GetLocation().x << ", " << food.GetLocation().y << std::endl;
+      DEBUG_LOG("Food (" << food._id << ") added at " << food.GetLocation().x << ", " << food.GetLocation().y);
       return;
     }
   }
 }
 
 void Game::Update() {
-  if (!snake.alive) return;
+  // apply the input that arrived since the last tick before anything moves
+  _input.Drain([this](const GameEvent &event) { HandleEvent(event); });
+  if (_restartPending) {
+    _restartPending = false;
+    Restart();
+  }
+  if (_rewindPending > 0) {
+    RewindBy(_rewindPending);
+    _rewindPending = 0;
+  }
 
-  snake.Update();
+  UpdateAppearing();
+  _walls.Update();
 
-  int new_x = static_cast<int>(snake.head_x);
-  int new_y = static_cast<int>(snake.head_y);
+  for (Player *player : _players) {
+    if (player->active && player->snake.alive) UpdateSnake(*player);
+  }
 
-  if(_multiplierTimer-- <= 0) {
-    _multiplierTimer = MULTIPLIER_TIMER;
-    _multiplier = 1;
+  // everything that happened this tick is handled here, in the order it happened
+  ProcessEvents();
+
+  MarkLitBombs();
+  _particles.Update();
+
+  // the dirty cells are cleared once the tick is published, the regions have to see them first
+  _reach.Sync(_dirty);
+  if (_distances) _distances->Sync(_dirty);
+  if (_rewind) _rewind->Record();
+}
+
+void Game::UpdateSnake(Player &player) {
+  if(player.multiplierTimer-- <= 0) {
+    player.multiplierTimer = MULTIPLIER_TIMER;
+    player.multiplier = 1;
+  }
+
+  // check every cell the head moves through, not just the one it ends up in,
+  // so a fast snake can't jump over walls, food or power-ups
+  player.snake.Update([this, &player](int x, int y) { CheckCollision(player, x, y); });
+}
+
+void Game::CheckCollision(Player &player, int new_x, int new_y) {
+  Snake &snake = player.snake;
+
+  // another snake is as solid as a wall
+  if(_players.size() > 1 && !snake.IsInvincible() && HitsOtherSnake(player, new_x, new_y)) {
+    snake.KillSnake();
+    return;
   }
 
   // check the bitsets to see if an object is in that position
-  if(((new_x >= 0) && (new_x < 128)) && ((new_y >= 0) && (new_y < 128)) && board_bits[new_x].test(new_y)) {
-    // check if the snake collided with a game element
-    for(auto g : _elements) {
-      if(g->GetLocation().x == new_x && g->GetLocation().y == new_y) {
-        board_bits[new_x].reset(new_y);
+  if(board_bits.InBounds(new_x, new_y) && board_bits.Test(new_x, new_y)) {
+    if(_walls.Shown(new_x, new_y)) {
+      // keep the wall's bit, it stays on the board
+      if(_walls.Solid(new_x, new_y)) {
+        if(!snake.IsInvincible()) {
+          snake.KillSnake();
+        }
+      } else {
+        player.multiplierTimer = MULTIPLIER_TIMER;
+        player.multiplier = 1;
+      }
+    } else if(GameElement *g = _index.At(new_x, new_y)) {
+      // check if the snake collided with a game element, the index tells us which one is here
+      if(g != &food) {
         if(g->IsPotion()) {
-          std::shared_ptr<Potion> p = std::dynamic_pointer_cast<Potion>(g);
-          snake.AddPotion(p);
+          TRACE_INSTANT("potion picked up");
+          snake.AddPotion(static_cast<Potion*>(g));
         } else if(g->IsBomb()) {
-          std::shared_ptr<Bomb> b = std::dynamic_pointer_cast<Bomb>(g);
-          snake.AddBomb(b);
+          TRACE_INSTANT("bomb picked up");
+          snake.AddBomb(static_cast<Bomb*>(g));
         } else if(g->IsShrinkPill()) {
-          std::shared_ptr<ShrinkPill> s = std::dynamic_pointer_cast<ShrinkPill>(g);
-          snake.AddShrinkPill(s);
+          TRACE_INSTANT("shrink pill picked up");
+          snake.AddShrinkPill(static_cast<ShrinkPill*>(g));
         } else if(g->IsSlowPill()) {
-          std::shared_ptr<SlowPill> s = std::dynamic_pointer_cast<SlowPill>(g);
-          snake.AddSlowPill(s);
-        } else if(g->IsWall()) {
-          if(g->IsVisible() && g->IsSolid()) {
-            if(!snake.IsInvincible()) {
-              snake.KillSnake();
-            }
-            break;
-          }
+          TRACE_INSTANT("slow pill picked up");
+          snake.AddSlowPill(static_cast<SlowPill*>(g));
         }
-        _multiplierTimer = MULTIPLIER_TIMER;
-        _multiplier = 1;
+
+        board_bits.Reset(new_x, new_y);
+        player.multiplierTimer = MULTIPLIER_TIMER;
+        player.multiplier = 1;
       }
-    }    
-    
+    }
+
     // Check if there's food over here
     if (food.GetLocation().x == new_x && food.GetLocation().y == new_y) {
-      score += (1 * _multiplier);
+      _events.Push(GameEventType::kFoodEaten, {new_x, new_y}, &food, GameElement::FOOD, 0, snake.PlayerId());
+    }
+  }
+}
+
+bool Game::HitsOtherSnake(const Player &player, int x, int y) const
+{
+  for(const Player *other : _players) {
+    if(other != &player && other->active && other->snake.SnakeCell(x, y)) return true;
+  }
+  return false;
+}
+
+void Game::ProcessEvents()
+{
+  _events.Drain([this](const GameEvent &event) { HandleEvent(event); });
+}
+
+void Game::HandleEvent(const GameEvent &event)
+{
+  // the player the event is about, if it's still on the board
+  Player *player = ActivePlayer(event.player);
+
+  switch(event.type) {
+    case GameEventType::kFoodEaten:
+      // two snakes can reach the food in the same tick, the first one gets it
+      if(!player || food.GetLocation().x != event.location.x || food.GetLocation().y != event.location.y) break;
+      TRACE_INSTANT("food eaten", player->score);
+      _particles.Sparks(event.location.x, event.location.y, foodColor.toSDLColor());
+      player->score += (1 * player->multiplier);
       PlaceNextWall();
       PlaceNextElement();
       PlaceFood();
       // Grow snake and increase speed.
-      snake.GrowBody();
-      snake.speed += 0.02;
+      player->snake.GrowBody();
+      player->snake.AddSpeed(FOOD_SPEED_STEP);
 
-      _multiplierTimer = MULTIPLIER_TIMER;
-      _multiplier++;
-    }
+      player->multiplierTimer = MULTIPLIER_TIMER;
+      player->multiplier++;
+      break;
+
+    case GameEventType::kItemUsed:
+      if(event.itemType == GameElement::BOMB) {
+        _litBombs.emplace_back(event.element);
+      } else if(!player) {
+        break;
+      } else if(event.itemType == GameElement::POTION) {
+        player->snake.MakeInvincible();
+      } else if(event.itemType == GameElement::SHRINK_PILL) {
+        player->snake.ShrinkBody();
+      } else if(event.itemType == GameElement::SLOW_PILL) {
+        player->snake.SlowSnake();
+      }
+      break;
+
+    case GameEventType::kBombExploded:
+      ExplodeBomb(event.location);
+      _litBombs.erase(std::remove(_litBombs.begin(), _litBombs.end(), event.element), _litBombs.end());
+
+      // bomb exploded, hide the instance and make it available to use again
+      event.element->Hide();
+      event.element->SetAvailable();
+      break;
+
+    case GameEventType::kSnakeDied:
+      if(!player) break;
+      TRACE_INSTANT("snake died", player->score);
+      DEBUG_LOG("Snake " << event.player << " died at " << event.location.x << ", " << event.location.y << " with a score of " << player->score);
+      break;
+
+    case GameEventType::kInputTurn:
+      if(!player) break;
+      switch(static_cast<Snake::Direction>(event.value)) {
+        case Snake::Direction::kUp:
+          ChangeDirection(player->snake, Snake::Direction::kUp, Snake::Direction::kDown);
+          break;
+        case Snake::Direction::kDown:
+          ChangeDirection(player->snake, Snake::Direction::kDown, Snake::Direction::kUp);
+          break;
+        case Snake::Direction::kLeft:
+          ChangeDirection(player->snake, Snake::Direction::kLeft, Snake::Direction::kRight);
+          break;
+        case Snake::Direction::kRight:
+          ChangeDirection(player->snake, Snake::Direction::kRight, Snake::Direction::kLeft);
+          break;
+      }
+      break;
+
+    case GameEventType::kInputUseItem:
+      if(!player) {
+        break;
+      } else if(event.itemType == GameElement::POTION) {
+        if(player->snake.HasPotion()) player->snake.UsePotion();
+      } else if(event.itemType == GameElement::BOMB) {
+        if(player->snake.HasBomb()) player->snake.UseBomb();
+      } else if(event.itemType == GameElement::SHRINK_PILL) {
+        if(player->snake.HasShrinkPill()) player->snake.UseShrinkPill();
+      } else if(event.itemType == GameElement::SLOW_PILL) {
+        if(player->snake.HasSlowPill()) player->snake.UseSlowPill();
+      }
+      break;
+
+    case GameEventType::kInputSpeed:
+      if(player) player->snake.AddSpeed(SPEED_STEP * event.value);
+      break;
+
+    case GameEventType::kInputDebug:
+      DebugPrint();
+      break;
+
+    case GameEventType::kInputRestart:
+      _restartPending = true;
+      break;
+
+    case GameEventType::kInputRewind:
+      _rewindPending += event.value;
+      break;
   }
 }
 
-void Game::ExplodeBomb(SDL_Point location)
+void Game::ChangeDirection(Snake &turning, Snake::Direction input, Snake::Direction opposite)
 {
-  std::cout << "Bomb at " << location.x << ", " << location.y << " go boom!" << std::endl;
-
-  if(((location.x >= 0) && (location.x < 128)) && ((location.y >= 0) && (location.y < 128))) {
-
-    // build a vector of the possible locations to check
-    std::vector<SDL_Point> points;
-
-    // temp vectors to help build the points
-    std::vector<int> xs;
-    std::vector<int> ys;
-    
-    // add the current point
-    xs.push_back(location.x);
-    ys.push_back(location.y);
-
-    if(location.x == 0) {
-      // no squares before (no wrap around)
-      xs.push_back(location.x + 1);
-    } else if(location.x == 31) {
-      // no squares after
-      xs.push_back(location.x - 1);
-    } else {
-      // squares on both sides
-      xs.push_back(location.x - 1);
-      xs.push_back(location.x + 1);
-    }
-    
-    if(location.y == 0) {
-      // no squares before (no wrap around)
-      ys.push_back(location.y + 1);
-    } else if(location.x == 31) {
-      // no squares after
-      ys.push_back(location.y - 1);
-    } else {
-      // squares on both sides
-      ys.push_back(location.y - 1);
-      ys.push_back(location.y + 1);
-    }
+  if (turning.direction != opposite || turning.GetData()->size == 1) turning.direction = input;
+}
 
-    for(int x : xs) {
-      for(int y : ys) {
-        SDL_Point pt{x, y};
-        points.emplace_back(pt);
-      }
-    }
-    
-    for(auto &g : _elements) {
-      SDL_Point p = g->GetLocation();
-      for(SDL_Point &t : points) {
-        if(p.x == t.x && p.y == t.y) {
-          // oops, this object is in the blast radius
-          board_bits[p.x].reset(p.y);
-          g->SetColor(screenBackgroundColor);
-          g->SetVisibility(false);  // can't use Hide() here since we want to maintain wall positions for re-use
-          g->SetAvailable();
-        }
+void Game::ExplodeBomb(SDL_Point location)
+{
+  TRACE_SPAN("ExplodeBomb");
+  DEBUG_LOG("Bomb at " << location.x << ", " << location.y << " go boom!");
+
+  if(!board_bits.InBounds(location.x, location.y)) return;
+
+  const int r = _blast.Radius();
+  for(int dy = -r; dy <= r; ++dy) {
+    int y = location.y + dy;
+    int w = _blast.HalfWidth(dy);
+
+    // no wrap around, the blast stops at the edge of the board
+    if(y < 0 || y >= board_bits.Height() || w < 0) continue;
+
+    int x0 = location.x - w;
+    int x1 = location.x + w + 1;
+
+    // AND the blast row against the visible elements to find what got hit
+    _index.Occupied().ForEachSetInRow(y, x0, x1, [&](int x) {
+      GameElement *g = _index.At(x, y);
+      if(g != &food) {
+        // oops, this object is in the blast radius
+        g->SetColor(screenBackgroundColor);
+        g->SetVisibility(false);
+        g->SetAvailable();
       }
+    });
+
+    // debris from every cell in the blast, and dust from every wall it blows away
+    for(int x = std::max(x0, 0); x < std::min(x1, board_bits.Width()); ++x) {
+      _particles.Debris(x, y);
     }
+    _walls.ShownBits().ForEachSetInRow(y, x0, x1, [&](int x) {
+      _particles.Dust(x, y, _walls.CellColor(x, y));
+    });
+
+    // the walls in the blast go back into the hidden set, in place, to rematerialize later
+    _walls.HideRange(y, x0, x1);
 
+    // clear the row, but the food survives the blast
+    board_bits.ResetRange(y, x0, x1);
+    if(food.GetLocation().y == y && food.GetLocation().x >= x0 && food.GetLocation().x < x1) {
+      board_bits.Set(food.GetLocation().x, food.GetLocation().y);
+    }
   }
 }
 
-int Game::GetScore() const { return score; }
+void Game::SetBombBlast(int radius, BlastShape shape)
+{
+  _blast = BlastPattern(radius, shape);
+}
+
+const DistanceField& Game::HeadDistances() {
+  if (!_distances) _distances = std::make_unique<DistanceField>(_walls.ShownBits(), snake);
+  _distances->Sync(_dirty);
+  _distances->Refresh();
+  return *_distances;
+}
+
+int Game::GetScore() const { return _local.score; }
 int Game::GetSize() const { return snake.GetSize(); }
 int Game::GetPotionCount() const { return snake.PotionCount(); }
 int Game::GetBombCount() const { return snake.BombCount(); }
\ No newline at end of file
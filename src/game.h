@@ -1,66 +1,210 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include <random>
 #include <vector>
-#include <bitset>
 #include <memory>
+#include <memory_resource>
+#include <atomic>
 #include "SDL.h"
 #include "controller.h"
 #include "renderer.h"
 #include "snake.h"
 #include "game_element.h"
+#include "bitboard.h"
+#include "spatial_index.h"
+#include "element_pool.h"
+#include "blast.h"
+#include "event_queue.h"
+#include "alloc_tracker.h"
+#include "dirty_cells.h"
+#include "frame_snapshot.h"
+#include "frame_pacer.h"
+#include "board_planes.h"
+#include "shm_exporter.h"
+#include "wall_layer.h"
+#include "board_layout.h"
+#include "flood_fill.h"
+#include "reachability.h"
+#include "distance_field.h"
+#include "particles.h"
+#include "random.h"
+#include "rewind.h"
 
 #define MULTIPLIER_TIMER 600
+#define DEFAULT_BOMB_RADIUS 1
+#define DEFAULT_BOMB_SHAPE BlastShape::kSquare
+#define ALLOC_WARMUP_FRAMES 120   // frames before update and render are expected to stop allocating
+#define SPEED_STEP FIXED_CELLS(1, 100)        // speed change for each +/- key press
+#define FOOD_SPEED_STEP FIXED_CELLS(1, 50)    // speed gained for each piece of food
+#define GAME_ARENA_BYTES 65536                // first block of the per-game arena, enough for the reserved pool
+#define REPAINT_CELLS_PER_TICK 65536          // board cells a snapshot's repaint band covers, in whole rows
 
 class Controller;
+class SnakeEnv;
+class NetServer;
+
+// a snake and its score. Player 0 is the one at the keyboard, and the only one a local game has; a NetServer
+// adds one for each client with Game::AddPlayer, all of them on the same board.
+struct Player {
+  Player(std::size_t grid_width, std::size_t grid_height) : snake(grid_width, grid_height) {}
+
+  void ResetScore() {
+    score = 0;
+    multiplier = 1;
+    multiplierTimer = MULTIPLIER_TIMER;
+  }
+
+  Snake snake;
+  int score{0};
+  int multiplier{1};
+  int multiplierTimer{MULTIPLIER_TIMER};
+  bool active{true};    // on the board, RemovePlayer leaves the slot for the next AddPlayer
+};
 
 class Game {
  public:
   Game(std::size_t grid_width, std::size_t grid_height);
+  // same seed, same game (as long as no bombs are used, their fuses run on the wall clock). Any layout but
+  // kPerimeter is generated from the seed, see board_layout.h, and every RandomStream is split off from it.
+  Game(std::size_t grid_width, std::size_t grid_height, uint64_t seed, BoardLayout layout = BoardLayout::kPerimeter);
+  Game(std::size_t grid_width, std::size_t grid_height, BoardLayout layout);
+  // the simulation runs on its own thread at ticks_per_second, this thread handles input and renders
+  // the published snapshots at a cadence set by the pacing mode
   void Run(Controller const &controller, Renderer &renderer,
-           std::size_t target_frame_duration);
+           double ticks_per_second, double frames_per_second, PacingMode mode);
+  // a new game on the same board, without rebuilding anything: every element, wall, body cell and buffer
+  // is reused, so nothing is allocated (short of generating a layout) and the renderer just repaints.
+  // Restart() takes the next seed from this game's kRounds stream, so a seeded game's rounds repeat too.
+  // Only call it from the thread that updates the game, or before Run.
+  void Restart();
+  void Restart(uint64_t seed);
+
+  // keep the last seconds of play so the game can be wound back, see Rewind. Everything it needs is allocated
+  // here, so call it before Run. RewindBy goes back up to seconds, and returns how many ticks it went.
+  void EnableRewind(double seconds, double ticks_per_second);
+  uint64_t RewindBy(double seconds);
+
   int GetScore() const;
   int GetSize() const;
   int GetPotionCount() const;
   int GetBombCount() const;
 
-  int GetMultiplier() const { return _multiplier; }
+  int GetMultiplier() const { return _local.multiplier; }
+
+  // more snakes on the same board, for a server hosting its clients. AddPlayer puts a new snake on a free
+  // cell and returns its id, for input events and PlayerState (a slot RemovePlayer left is used again,
+  // player 0's too). RespawnPlayer starts a player over somewhere free. Only player 0 is rendered, recorded
+  // for rewinding and followed by the distances. Only call these from the thread that updates the game.
+  int AddPlayer();
+  void RemovePlayer(int player);
+  void RespawnPlayer(int player);
+  const Player& PlayerState(int player) const { return *_players[player]; }
+
+  // moves from the head to every cell, for bots and heatmaps. Set up the first time it's asked for, then
+  // repaired from the cells that changed; compare Version() to tell whether it changed since last time.
+  const DistanceField& HeadDistances();
+
+  // words in one bitplane, and all NUM_BOARD_PLANES of them copied out into planes (one memcpy per BitBoard)
+  int PlaneWords() const { return static_cast<int>(board_bits.WordCount()); }
+  void WriteBitplanes(uint64_t *planes) const;
 
   void DebugPrint();
 
   void ExplodeBomb(SDL_Point location);
+  void SetBombBlast(int radius, BlastShape shape);
 
  private:
-  Snake snake;
+  friend class SnakeEnv;    // reads the board state straight into observations
+  friend class NetServer;   // steps the game with a player per client and replicates its state
+  friend class Rewind;      // records every tick and puts a past one back
+  friend class AllocCheck;  // plays a game with a bomb and a rewind in it and counts what a tick allocates
+
+  EventQueue _events;   // declared first so it outlives everything that pushes to it
+  EventQueue _input;    // player input from the main thread, applied at the start of each tick
+  DirtyCells _dirty;    // cells changed since the last frame, marked by the snakes, the index and the game
+  Player _local;        // player 0
+  Snake &snake;         // ... and its snake
+  std::vector<std::unique_ptr<Player>> _guests;   // the players AddPlayer made
+  std::vector<Player*> _players;                  // every player by id, _local first
+  SpatialIndex _index;  // visible elements by cell, must outlive the elements below
+  WallLayer _walls;     // every wall, as a bitplane and a state byte per cell
+  BoardLayout _layout;  // how CreateWalls lays them out
+  Reachability _reach;  // the free cells the head can get to, so nothing is placed where it can't
+  std::unique_ptr<DistanceField> _distances;  // only made once something reads it
   Food food;
-  std::vector<std::shared_ptr<GameElement>> _elements;
+  std::vector<GameElement*> _appearing;   // elements fading in, advanced once per update
+  std::vector<GameElement*> _litBombs;    // bombs whose fuse is burning, their color changes every frame
+  ParticleSystem _particles;              // explosion debris, food sparks and wall dust, stepped every tick
 
-  std::random_device dev;
-  std::mt19937 engine;
-  std::uniform_int_distribution<int> random_w;
-  std::uniform_int_distribution<int> random_h;
+  // a stream of the seed each, so drawing more for one thing never changes another
+  Xoshiro256 _placementRandom;
+  Xoshiro256 _spawnRandom;
+  Xoshiro256 _wallRandom;
+  Xoshiro256 _roundRandom;
+  bool _restartPending{false};            // the restart key was pressed, done once this tick's input is applied
+  int _rewindPending{0};                  // seconds the rewind key asked to go back, done after the restart
 
-  // the bitsets will track rows and columns
-  // using 128 will allow for game boards up to 128x128
-  // if we want larger we can expand the bitset
-  // but it must be defined at compile time
-  std::bitset<128> board_bits[128];
+  // one bit per occupied cell, sized to the grid at construction
+  BitBoard board_bits;
 
-  int _wallCount{0};
+  BitBoard _openScratch;                  // the cells without a wall, for checking a wall won't cut the board in two
+  FloodFillScratch _fillScratch;
 
-  int score{0};
-  int _multiplier{1};
-  int _multiplierTimer{MULTIPLIER_TIMER};
+  BlastPattern _blast;
+
+  // allocation counts at the end of the last frame and the last report
+  AllocCounts _frameAllocs;
+  AllocCounts _reportAllocs;
+  uint64_t _frameNumber{0};
+
+  SnapshotBuffer _snapshots;      // written by the simulation thread, read by the render thread
+  std::unique_ptr<Camera> _windowCamera;  // a copy of the renderer's, sizes the window around the head, made by Run
+  int _repaintRows;               // rows in a repaint band
+  DirtyHistory _dirtyHistory;     // the cells the last few ticks changed, for snapshots the renderer skipped
+  uint64_t _tick{0};
+  std::atomic<bool> _running{false};
+
+  // each tick's state for other processes, only opened by Run (and only with SHM_EXPORT)
+  ShmExporter _exporter;
+  std::atomic<int> _exportFps{0};       // the render stats Run last reported, exported with every tick
+  std::atomic<int> _exportFrameUs{0};
+  std::atomic<int> _exportJitterUs{0};
+
+  std::unique_ptr<Rewind> _rewind;        // only made by EnableRewind
+
+  // where the pool's chunks are carved from, declared before the pool so it outlives it
+  std::pmr::monotonic_buffer_resource _arena;
+
+  // owns the power-ups, declared last so every fuse still burning is taken off the fuse thread
+  // before anything a bomb calls back into is destroyed
+  ElementPool _pool;
 
+  void Simulate(double ticks_per_second);
+  void PublishSnapshot();
+  void ExportState(int tick_us);
+  SDL_Color CellColor(int x, int y) const;
+  void AppendCells(int x0, int y0, int x1, int y1, std::vector<SnapshotCell> &out, std::vector<int32_t> *rowStart) const;
+  void ChangeDirection(Snake &turning, Snake::Direction input, Snake::Direction opposite);
   void PlaceFood();
+  void TrackFrameAllocations(bool report, int frames);
+  void UpdateHudData(HudData &hud);
+  void TrackAppearing(GameElement *element);
+  void UpdateAppearing();
+  void MarkLitBombs();
   void CreateWalls();
+  void CreateLayoutWalls();
   void PlaceNextWall();
   void PlaceNextElement();
-  std::shared_ptr<Wall> GetNextWall();
-  std::shared_ptr<GameElement> GetNextElement(GameElement::ElementType type);
   SDL_Point GetUnoccupiedLocation();
+  bool FreeCell(int x, int y);
+  Player* ActivePlayer(int player);
+  void ClearPlayer(Player &player);
   void Update();
+  void UpdateSnake(Player &player);
+  void CheckCollision(Player &player, int new_x, int new_y);
+  bool HitsOtherSnake(const Player &player, int x, int y) const;
+  void ProcessEvents();
+  void HandleEvent(const GameEvent &event);
 };
 
 #endif
\ No newline at end of file
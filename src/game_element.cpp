@@ -1,88 +1,121 @@
 #include <iostream>
 #include "game_element.h"
+#include "spatial_index.h"
+#include "element_pool.h"
+#include "event_queue.h"
+#include "debug_log.h"
+#include "trace.h"
 
 int GameElement::_debugId = 0;
 
+// bits of the packed state, from the bottom: red, green, blue, alpha, x, y, visibility, available
+#define STATE_COORD_MASK ((uint64_t{1} << ELEMENT_COORD_BITS) - 1)   // all ones is off the board
+#define STATE_X_SHIFT 32
+#define STATE_Y_SHIFT (STATE_X_SHIFT + ELEMENT_COORD_BITS)
+#define STATE_VISIBILITY_SHIFT (STATE_Y_SHIFT + ELEMENT_COORD_BITS)
+#define STATE_AVAILABLE_SHIFT (STATE_VISIBILITY_SHIFT + 2)
+
+static_assert(STATE_AVAILABLE_SHIFT < 64, "the element state must fit in one word");
+
+static uint64_t PackCoord(int c)
+{
+    if(c < 0 || static_cast<uint64_t>(c) >= STATE_COORD_MASK) return STATE_COORD_MASK;
+    return static_cast<uint64_t>(c);
+}
+
+static int UnpackCoord(uint64_t bits)
+{
+    bits &= STATE_COORD_MASK;
+    return (bits == STATE_COORD_MASK) ? -1 : static_cast<int>(bits);
+}
+
+uint64_t GameElement::PackState(const State &state)
+{
+    return uint64_t{state.color.red()}
+        | (uint64_t{state.color.green()} << 8)
+        | (uint64_t{state.color.blue()} << 16)
+        | (uint64_t{state.color.alpha()} << 24)
+        | (PackCoord(state.location.x) << STATE_X_SHIFT)
+        | (PackCoord(state.location.y) << STATE_Y_SHIFT)
+        | (static_cast<uint64_t>(state.visibility) << STATE_VISIBILITY_SHIFT)
+        | (static_cast<uint64_t>(state.available) << STATE_AVAILABLE_SHIFT);
+}
+
+GameElement::State GameElement::UnpackState(uint64_t bits)
+{
+    State state;
+    state.color = Color(bits & 0xFF, (bits >> 8) & 0xFF, (bits >> 16) & 0xFF, (bits >> 24) & 0xFF);
+    state.location = {UnpackCoord(bits >> STATE_X_SHIFT), UnpackCoord(bits >> STATE_Y_SHIFT)};
+    state.visibility = static_cast<Visibility>((bits >> STATE_VISIBILITY_SHIFT) & 3);
+    state.available = ((bits >> STATE_AVAILABLE_SHIFT) & 1) != 0;
+    return state;
+}
+
+bool GameElement::OnBoard(uint64_t bits)
+{
+    return ((bits >> STATE_VISIBILITY_SHIFT) & 3) != Hidden && ((bits >> STATE_AVAILABLE_SHIFT) & 1) != 0;
+}
+
 GameElement::GameElement() :
-    _location({0,0}),
-    _currentColor(screenBackgroundColor),
+    _state(PackState({screenBackgroundColor, {0,0}, Hidden, true})),
     _defaultColor(screenBackgroundColor),
     _actionColor(screenBackgroundColor),
     _solid(false),
-    _visibility(Hidden),
     _elementType(UNKNOWN_TYPE),
     _vecActionColors(),
-    _id(_debugId++),
-    _actionThread(),
-    _colorMtx()
+    _id(_debugId++)
 {
 }
 
 GameElement::GameElement(int x, int y, Color color, ElementType type) :
-    _location({x,y}),
-    _currentColor(screenBackgroundColor),
+    _state(PackState({screenBackgroundColor, {x,y}, Hidden, true})),
     _defaultColor(color),
     _actionColor(color),
     _solid(false),
-    _visibility(Hidden),
     _elementType(type),
     _vecActionColors(),
-    _id(_debugId++),
-    _actionThread(),
-    _colorMtx()
+    _id(_debugId++)
 {
 }
 
 GameElement::GameElement(SDL_Point location, Color color, ElementType type) :
-    _location(location),
-    _currentColor(screenBackgroundColor),
+    _state(PackState({screenBackgroundColor, location, Hidden, true})),
     _defaultColor(color),
     _actionColor(color),
     _solid(false),
-    _visibility(Hidden),
     _elementType(type),
     _vecActionColors(),
-    _id(_debugId++),
-    _actionThread(),
-    _colorMtx()
+    _id(_debugId++)
 {
 }
 
 GameElement::GameElement(Color color, ElementType type) :
-    _location({-1, -1}),
-    _currentColor(color),
+    _state(PackState({color, {-1, -1}, Hidden, true})),
     _defaultColor(color),
     _actionColor(screenBackgroundColor),
     _solid(false),
-    _visibility(Hidden),
     _elementType(type),
     _vecActionColors(),
-    _id(_debugId++),
-    _actionThread(),
-    _colorMtx()
+    _id(_debugId++)
 {
 }
 
 GameElement::~GameElement()
 {
-    if (_actionThread.joinable()) {
-        _actionThread.join();
-    }
+    // make sure the index isn't left pointing at us
+    UpdateState([](State &state) { state.visibility = Hidden; });
+    UpdateIndex();
 }
 
 // copy constructor
 GameElement::GameElement(const GameElement& element) noexcept :
-    _location(element._location),
-    _currentColor(element._currentColor),
+    _state(element._state.load()),
     _defaultColor(element._defaultColor),
     _actionColor(element._actionColor),
     _solid(element._solid),
-    _visibility(element._visibility),
     _elementType(element._elementType),
     _vecActionColors(element._vecActionColors),
-    _id(DEFAULT_DEBUG_ID),
-    _actionThread(),
-    _colorMtx()
+    _id(DEFAULT_DEBUG_ID)
 { std::cout << "GE copy constructor" << std::endl; }
 
 // copy assignment operator
@@ -91,12 +124,10 @@ GameElement& GameElement::operator=(const GameElement& element) noexcept
     std::cout << "GE copy assignment" << std::endl; 
     if(this != &element) {
         // set the values from the given element
-        _location = element._location;
-        _currentColor = element._currentColor;
+        _state = element._state.load();
         _defaultColor = element._defaultColor;
         _actionColor = element._actionColor;
         _solid = element._solid;
-        _visibility = element._visibility;
         _elementType = element._elementType;
         _vecActionColors = element._vecActionColors;
         _id = DEFAULT_DEBUG_ID;
@@ -106,37 +137,29 @@ GameElement& GameElement::operator=(const GameElement& element) noexcept
 
 // move constructor
 GameElement::GameElement(GameElement&& element) noexcept :
-    _location({-1, -1}),
-    _currentColor(screenBackgroundColor),
+    _state(PackState({screenBackgroundColor, {-1, -1}, Hidden, true})),
     _defaultColor(screenBackgroundColor),
     _actionColor(screenBackgroundColor),
     _solid(false),
-    _visibility(Hidden),
     _elementType(UNKNOWN_TYPE),
     _vecActionColors(),
-    _id(DEFAULT_DEBUG_ID),
-    _actionThread(),
-    _colorMtx()
+    _id(DEFAULT_DEBUG_ID)
 {
     std::cout << "GE move constructor" << std::endl; 
     // set the values from the given element
-    _location = element._location;
-    _currentColor = element._currentColor;
+    _state = element._state.load();
     _defaultColor = element._defaultColor;
     _actionColor = element._actionColor;
     _solid = element._solid;
-    _visibility = element._visibility;
     _elementType = element._elementType;
     _vecActionColors = element._vecActionColors;
     _id = element._id;
 
     // reset the values in the given element
-    element._location = {-1, -1};
-    element._currentColor = screenBackgroundColor;
+    element._state = PackState({screenBackgroundColor, {-1, -1}, Hidden, true});
     element._defaultColor = screenBackgroundColor;
     element._actionColor = screenBackgroundColor;
     element._solid = false;
-    element._visibility = Hidden;
     element._elementType = UNKNOWN_TYPE;
     element._vecActionColors.clear();
     _id = DEFAULT_DEBUG_ID;
@@ -148,23 +171,19 @@ GameElement& GameElement::operator=(GameElement&& element) noexcept
     std::cout << "GE move assignment" << std::endl; 
     if(this != &element) {
         // set the values from the given element
-        _location = element._location;
-        _currentColor = element._currentColor;
+        _state = element._state.load();
         _defaultColor = element._defaultColor;
         _actionColor = element._actionColor;
         _solid = element._solid;
-        _visibility = element._visibility;
         _elementType = element._elementType;
         _vecActionColors = element._vecActionColors;
         _id = element._id;
 
         // reset the values in the given element
-        element._location = {-1, -1};
-        element._currentColor = screenBackgroundColor;
+        element._state = PackState({screenBackgroundColor, {-1, -1}, Hidden, true});
         element._defaultColor = screenBackgroundColor;
         element._actionColor = screenBackgroundColor;
         element._solid = false;
-        element._visibility = Hidden;
         element._elementType = UNKNOWN_TYPE;
         element._vecActionColors.clear();
         _id = DEFAULT_DEBUG_ID;
@@ -174,8 +193,6 @@ GameElement& GameElement::operator=(GameElement&& element) noexcept
 std::shared_ptr<GameElement> GameElement::CreateGameElement(ElementType type)
 {
     switch(type) {
-        case GameElement::WALL:
-            return std::make_shared<Wall>();
         case GameElement::POTION:
             return std::make_shared<Potion>();
         case GameElement::BOMB:
@@ -186,6 +203,8 @@ std::shared_ptr<GameElement> GameElement::CreateGameElement(ElementType type)
             return std::make_shared<SlowPill>();
         case GameElement::FOOD:
             return std::make_shared<Food>();
+        case GameElement::WALL:
+            break;  // walls aren't elements, they live in the game's WallLayer
     }
 
     return std::shared_ptr<GameElement>();
@@ -194,8 +213,6 @@ std::shared_ptr<GameElement> GameElement::CreateGameElement(ElementType type)
 std::shared_ptr<GameElement> GameElement::CreateGameElement(ElementType type, int x, int y)
 {
     switch(type) {
-        case GameElement::WALL:
-            return std::make_shared<Wall>(x, y);
         case GameElement::POTION:
             return std::make_shared<Potion>(x, y);
         case GameElement::BOMB:
@@ -206,6 +223,8 @@ std::shared_ptr<GameElement> GameElement::CreateGameElement(ElementType type, in
             return std::make_shared<SlowPill>(x, y);
         case GameElement::FOOD:
             return std::make_shared<Food>(x, y);
+        case GameElement::WALL:
+            break;  // walls aren't elements, they live in the game's WallLayer
     }
 
     return std::shared_ptr<GameElement>();
@@ -238,46 +257,98 @@ std::string GameElement::GetElementTypeString()
 
 void GameElement::SetLocation(int x, int y)
 {
-    _location.x = x;
-    _location.y = y;
+    UpdateState([&](State &state) { state.location = {x, y}; });
+    UpdateIndex();
 }
 
-void GameElement::SetColor(int r, int g, int b, int a)
+void GameElement::SetAvailable()
+{
+    State state = UpdateState([](State &state) { state.available = true; });
+
+    // a hidden, available element can go straight back to its pool
+    if(_pool != nullptr && state.visibility == Hidden) {
+        _pool->Release(this);
+    }
+}
+
+void GameElement::SetUnavailable()
 {
-    // lock the mutex
-    std::unique_lock<std::mutex>(_colorMtx);
+    UpdateState([](State &state) { state.available = false; });
+}
 
-    // update the color
-    _currentColor.red(r);
-    _currentColor.green(g);
-    _currentColor.blue(b);
-    _currentColor.alpha(a);
+void GameElement::AttachIndex(SpatialIndex *index)
+{
+    _index = index;
+    UpdateIndex();
+}
+
+void GameElement::UpdateIndex()
+{
+    if(_index == nullptr) return;
+
+    // drop the old entry, then re-add at the current location if we can be seen
+    if(_indexedCell.x >= 0) {
+        _index->Remove(_indexedCell.x, _indexedCell.y, this);
+        _indexedCell = {-1, -1};
+    }
+
+    State state = GetState();
+    if(state.visibility != Hidden && state.location.x >= 0 && state.location.y >= 0) {
+        _index->Insert(state.location.x, state.location.y, this);
+        _indexedCell = state.location;
+    }
+}
+
+void GameElement::SetColor(int r, int g, int b, int a)
+{
+    SetColor(Color(r, g, b, a));
 }
 
 void GameElement::SetVisibility(bool isVisible)
 { 
+    Visibility visibility = Hidden;
     if(isVisible) {
         if(_appearanceTimer > 0) {
-            _visibility = Appearing;
+            visibility = Appearing;
         } else {
-            _visibility = Visible;
+            visibility = Visible;
         }
-    } else {
-        _visibility = Hidden;
     }
+    UpdateState([&](State &state) { state.visibility = visibility; });
+    UpdateIndex();
 }
 
 void GameElement::Show()
 {
-    _visibility = Visible;
+    UpdateState([](State &state) { state.visibility = Visible; });
     _appearanceTimer = DEFAULT_APPEARANCE_TIMER;
+    UpdateIndex();
 }
 
 void GameElement::Hide()
 {
-    _visibility = Hidden;
-    _location.x = 127;
-    _location.y = 127;
+    UpdateState([](State &state) {
+        state.visibility = Hidden;
+        state.location = {-1, -1};
+    });
+    UpdateIndex();
+}
+
+void GameElement::Recycle()
+{
+    StopAction();
+
+    UpdateState([this](State &state) {
+        state.color = _defaultColor;
+        state.location = {-1, -1};
+        state.visibility = Hidden;
+        state.available = true;
+    });
+    UpdateIndex();
+    _solid = false;
+    _appearanceTimer = DEFAULT_APPEARANCE_TIMER;
+    _actionTimer = 0;
+    _owner = 0;
 }
 
 void GameElement::SetInstantAppear()
@@ -287,65 +358,47 @@ void GameElement::SetInstantAppear()
 
 void GameElement::SetAlpha(int a)
 {
-    // lock the mutex
-    std::unique_lock<std::mutex>(_colorMtx);
-
-    // update the color
-    _currentColor.alpha(a);
+    UpdateState([&](State &state) { state.color.alpha(a); });
 }
 
 void GameElement::SetColor(Color c)
 {
-    // lock the mutex
-    std::unique_lock<std::mutex>(_colorMtx);
-
-    // update the color
-    _currentColor = c;
+    UpdateState([&](State &state) { state.color = c; });
 }
 
 void GameElement::MakeSolid() { _solid = true; }
 
 void GameElement::MakeIntangible() { _solid = false; }
 
-Color GameElement::getColor() const
-{
-    // lock the mutex while we return the color
-    std::unique_lock<std::mutex>(_colorMtx);
-    return _currentColor;
-}
-
 void GameElement::UpdateColor()
 {
-    if(_visibility == Appearing) {
+    State current = GetState();
+    if(current.visibility == Appearing) {
         if(_appearanceTimer > 0) {
-            // lock the mutex
-            std::unique_lock<std::mutex> colorLock(_colorMtx);
-
-            // update the color
-            if(_currentColor.red() < _defaultColor.red()) {
-                _currentColor.addRed(1);
-            } else if(_currentColor.red() > _defaultColor.red()) {
-                _currentColor.addRed(-1);
-            }
-
-            if(_currentColor.green() < _defaultColor.green()) {
-                _currentColor.addGreen(1);
-            } else if(_currentColor.green() > _defaultColor.green()) {
-                _currentColor.addGreen(-1);
-            }
-            
-            if(_currentColor.blue() < _defaultColor.blue()) {
-                _currentColor.addBlue(1);
-            } else if(_currentColor.blue() > _defaultColor.blue()) {
-                _currentColor.addBlue(-1);
-            }
+            // step the color towards the default, the color is the only part of the state that changes
+            UpdateState([&](State &state) {
+                if(state.color.red() < _defaultColor.red()) {
+                    state.color.addRed(1);
+                } else if(state.color.red() > _defaultColor.red()) {
+                    state.color.addRed(-1);
+                }
+
+                if(state.color.green() < _defaultColor.green()) {
+                    state.color.addGreen(1);
+                } else if(state.color.green() > _defaultColor.green()) {
+                    state.color.addGreen(-1);
+                }
+
+                if(state.color.blue() < _defaultColor.blue()) {
+                    state.color.addBlue(1);
+                } else if(state.color.blue() > _defaultColor.blue()) {
+                    state.color.addBlue(-1);
+                }
+            });
 
             --_appearanceTimer;
-
-            // unlock the mutex before printing
-            colorLock.unlock();
         } else {
-            std::cout << "Setting  " << GetElementTypeString(_elementType) << " (" << _id << ") at " << _location.x << ", " << _location.y << " visible" << std::endl;
+            DEBUG_LOG("Setting  " << GetElementTypeString(_elementType) << " (" << _id << ") at " << current.location.x << ", " << current.location.y << " visible");
             Show();
             MakeSolid();
         }
@@ -365,19 +418,6 @@ Food::~Food() { }
 
 
 
-/* class Wall */
-Wall::Wall() : GameElement(wallColor, GameElement::WALL) { }
-
-Wall::Wall(int x, int y) : GameElement(x, y, wallColor, GameElement::WALL) { }
-
-Wall::Wall(SDL_Point location) : GameElement(location, wallColor, GameElement::WALL) { }
-
-Wall::Wall(Color color) : GameElement(color, ElementType::WALL) { }
-
-Wall::~Wall() { }
-
-
-
 /* class Potion */
 Potion::Potion() : GameElement(potionColor, GameElement::POTION) { }
 
@@ -397,7 +437,7 @@ void Potion::UseItem()
 
 void Potion::DrinkPotion()
 {
-    if(_useCallbackFn) _useCallbackFn(_location);
+    if(_events) _events->Push(GameEventType::kItemUsed, GetLocation(), this, _elementType, 0, _owner);
 }
 
 
@@ -411,7 +451,11 @@ Bomb::Bomb(SDL_Point location) : GameElement(location, bombColor, GameElement::B
 
 Bomb::Bomb(Color color) : GameElement(color, ElementType::BOMB) { LoadActionColors(); }
 
-Bomb::~Bomb() { }
+Bomb::~Bomb()
+{
+    // the fuse has to be out before the bomb goes, the worker would step it
+    _fuses->Douse(this);
+}
 
 void Bomb::LoadActionColors()
 {
@@ -427,92 +471,50 @@ void Bomb::LoadActionColors()
 
 void Bomb::UseItem()
 {
-    std::cout << "Using bomb (" << _id << ")!!" << std::endl;
-
-    // if thread is running, join it
-    if(_actionThread.joinable()) {
-        _actionThread.join();
-    }
-
-    // lock the mutex
-    std::unique_lock<std::mutex> colorLock(_colorMtx);
+    DEBUG_LOG("Using bomb (" << _id << ")!!");
 
-    // update the color
-    _currentColor = _vecActionColors[0];
+    SetColor(_vecActionColors[0]);
     _actionColor = bombExplodesColor;
-    _actionTimer = DEFAULT_ACTION_TIMER;
 
     _appearanceTimer = 0;
 
-    // unlock the mutex
-    colorLock.unlock();
-
     // set the visibility
     SetVisibility(true);
 
-    // start thread
-    _actionThread = std::thread(&Bomb::LightFuse, this);
-}
-
-void Bomb::LightFuse()
-{
-    std::cout << "Running action for " << GetElementTypeString() << " (" << _id << ") - " << _visibility << std::endl;
-
-    const int one_eighths   = _actionTimer / 8;
-    const int two_eighths   = 2 * one_eighths;
-    const int three_eighths = 3 * one_eighths;
-    const int four_eighths  = 4 * one_eighths;
-    const int five_eighths  = 5 * one_eighths;
-    const int six_eighths   = 6 * one_eighths;
-    const int seven_eighths = 7 * one_eighths;
-    
-    while(_actionTimer > 0) {
-        // lock the mutex
-        std::unique_lock<std::mutex> colorLock(_colorMtx);
-
-        // update the color
-        if(_actionTimer == seven_eighths) {
-            _currentColor = _vecActionColors[1];
-        } else if(_actionTimer == six_eighths) {
-            _currentColor = _vecActionColors[2];
-        } else if(_actionTimer == five_eighths) {
-            _currentColor = _vecActionColors[3];
-        } else if(_actionTimer == four_eighths) {
-            _currentColor = _vecActionColors[4];
-        } else if(_actionTimer == three_eighths) {
-            _currentColor = _vecActionColors[5];
-        } else if(_actionTimer == two_eighths) {
-            _currentColor = _vecActionColors[6];
-        } else if(_actionTimer == one_eighths) {
-            _currentColor = _vecActionColors[7];
-        }
-
-
-        --_actionTimer;
+    // hand it to the fuse thread, a link in a list that's already there so nothing is allocated
+    TRACE_INSTANT("LightFuse", _id);
+    _fuses->Light(this);
 
-        // unlock the mutex before printing
-        colorLock.unlock();
-        std::cout << "Setting " << GetElementTypeString(_elementType) << " (" << _id << ") at " << _location.x << ", " << _location.y << " to color " << std::to_string(_currentColor.red()) << ", " << std::to_string(_currentColor.green()) << ", " << std::to_string(_currentColor.blue()) << std::endl;
+    if(_events) _events->Push(GameEventType::kItemUsed, GetLocation(), this, _elementType, 0, _owner);
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-    }
+void Bomb::StopAction()
+{
+    _fuses->Douse(this);
+}
 
-    // lock the mutex
-    std::unique_lock<std::mutex> colorLock(_colorMtx);
+bool Bomb::BurnFuse()
+{
+    if(_actionTimer > 0) {
+        // the next color every eighth of the way down, one compare and swap that the renderer picks up whole
+        const int eighth = DEFAULT_ACTION_TIMER / 8;
+        if(_actionTimer < DEFAULT_ACTION_TIMER && _actionTimer % eighth == 0) {
+            SetColor(_vecActionColors[8 - _actionTimer / eighth]);
+        }
 
-    // update the color
-    _currentColor = bombColor;
+        --_actionTimer;
 
-    // unlock the mutex before printing
-    colorLock.unlock();
+        State state = GetState();
+        DEBUG_LOG("Setting " << GetElementTypeString(_elementType) << " (" << _id << ") at " << state.location.x << ", " << state.location.y << " to color " << std::to_string(state.color.red()) << ", " << std::to_string(state.color.green()) << ", " << std::to_string(state.color.blue()));
+        return true;
+    }
 
-    // call the callback if it exists
-    if(_useCallbackFn) _useCallbackFn(_location);
-    std::cout << GetElementTypeString() << " (" << _id << ") - has exploded!!" << _visibility << std::endl;
+    SetColor(bombColor);
 
-    // bomb exploded, hide the instance and make it available to use again
-    Hide();
-    SetAvailable();
+    // let the game know, it will resolve the blast and hide the bomb on its own thread
+    if(_events) _events->Push(GameEventType::kBombExploded, GetLocation(), this, _elementType);
+    DEBUG_LOG(GetElementTypeString() << " (" << _id << ") - has exploded!!" << GetState().visibility);
+    return false;
 }
 
 
@@ -538,7 +540,7 @@ void ShrinkPill::UseItem()
 
 void ShrinkPill::PopPill()
 {
-    if(_useCallbackFn) _useCallbackFn(_location);
+    if(_events) _events->Push(GameEventType::kItemUsed, GetLocation(), this, _elementType, 0, _owner);
 }
 
 
@@ -561,6 +563,6 @@ void SlowPill::UseItem()
 
 void SlowPill::PopPill()
 {
-    if(_useCallbackFn) _useCallbackFn(_location);
+    if(_events) _events->Push(GameEventType::kItemUsed, GetLocation(), this, _elementType, 0, _owner);
 }
 
@@ -1,23 +1,33 @@
 #pragma once
 
 /*
-    file: game_element.h - contains class GameElement and its subclasses. A GameElement represents an object on the gameboard, e.g. wall, food, etc.
+    file: game_element.h - contains class GameElement and its subclasses. A GameElement represents an object on the gameboard, e.g. food or a power-up (walls are kept in a WallLayer).
 */
 
-#include <functional>
-#include <mutex>
+#include <atomic>
+#include <cstdint>
 #include <thread>
 #include <future>
 #include <vector>
 #include "SDL.h"
 #include "color.h"
 #include "color_defines.h"
+#include "fuse_worker.h"
 
 #define DEFAULT_APPEARANCE_TIMER 512
 #define DEFAULT_ACTION_TIMER 512
 #define DEFAULT_DEBUG_ID -99
+#define ELEMENT_COORD_BITS 14   // element locations are packed in this many bits, so boards can be up to 16383 cells across
+
+class SpatialIndex;
+class ElementPool;
+class EventQueue;
+class Rewind;
 
 class GameElement {
+    friend class ElementPool;
+    friend class Rewind;    // records the packed state word as it is and stores it back
+
 public:
 
     enum Visibility {
@@ -31,12 +41,20 @@ public:
         BOMB,
         SHRINK_PILL,
         SLOW_PILL,
-        WALL,
+        WALL,               // not an element, walls live in the WallLayer, but a type for the planes and placement odds
         NUM_ELEMENT_TYPES,
         UNKNOWN_TYPE,
         FOOD // this is a special type
     } ElementType;
 
+    // what the renderer and the fuse thread look at, always read and written as a whole
+    struct State {
+        Color color;
+        SDL_Point location;
+        Visibility visibility;
+        bool available;
+    };
+
     static int _debugId;    // will be incremented with each object and used to populate _id, unless copied, then will use default val
     int _id;
     
@@ -62,18 +80,20 @@ public:
     std::string GetElementTypeString();
     static std::string GetElementTypeString(ElementType type);
     
-    SDL_Point GetLocation() const { return _location; }
-    Color getColor() const;
+    // a consistent copy of the state, without locking, from any thread
+    State GetState() const { return UnpackState(_state.load(std::memory_order_acquire)); }
+
+    SDL_Point GetLocation() const { return GetState().location; }
+    Color getColor() const { return GetState().color; }
     void UpdateColor();
 
     bool IsSolid() { return _solid; }
-    bool IsHidden() { return (_visibility == Hidden); }
-    bool IsAppearing() { return (_visibility == Appearing); }
-    bool IsVisible() { return (_visibility != Hidden); }
-    bool IsAvailable() { return _available; }
+    bool IsHidden() { return (GetState().visibility == Hidden); }
+    bool IsAppearing() { return (GetState().visibility == Appearing); }
+    bool IsVisible() { return (GetState().visibility != Hidden); }
+    bool IsAvailable() { return GetState().available; }
     
     ElementType GetType() { return _elementType; }
-    bool IsWall() { return (_elementType == WALL); }
     bool IsPotion() { return (_elementType == POTION); }
     bool IsBomb() { return (_elementType == BOMB); }
     bool IsShrinkPill() { return (_elementType == SHRINK_PILL); }
@@ -83,8 +103,8 @@ public:
     void SetColor(int r, int g, int b, int a);
     void SetAlpha(int a);
 
-    void SetAvailable() { _available = true; }
-    void SetUnavailable() { _available = false; }
+    void SetAvailable();
+    void SetUnavailable();
     
     void SetLocation(int x, int y);
     
@@ -95,31 +115,66 @@ public:
     void MakeIntangible();
     void SetInstantAppear();
     
-    // set the callback function for when item is used
-    void SetUseCallbackFn(std::function<void(SDL_Point)> fn) { _useCallbackFn = fn; }
+    // register the element with the board's spatial index, it is kept there while visible
+    void AttachIndex(SpatialIndex *index);
+
+    // set the queue that is told when the item is used
+    void SetEventQueue(EventQueue *events) { _events = events; }
+
+    // the player whose snake picked the item up, named in the event when it's used
+    void SetOwner(int player) { _owner = player; }
 
     // each subclass must implement this function
     virtual void UseItem() = 0;
 
+    // stop the element's action, if it has one going, and put the element back the way it was made:
+    // hidden, available and in its default color. For restarting a game without rebuilding it.
+    void Recycle();
+
  protected:
-    SDL_Point _location;
-    Color _currentColor;
+    // color, location, visibility and availability packed into one word. The fuse thread changes the color
+    // while the game moves and hides elements, so every change is a compare and swap of the whole word
+    // and readers never see half of one.
+    std::atomic<uint64_t> _state;
     Color _defaultColor;
     Color _actionColor;
     bool _solid;
-    Visibility _visibility;
     int _appearanceTimer{DEFAULT_APPEARANCE_TIMER};
     int _actionTimer{0};
     ElementType _elementType;
-    std::function<void(SDL_Point)> _useCallbackFn;
+    EventQueue *_events{nullptr};
+    int _owner{0};
     std::vector<Color> _vecActionColors;
-    bool _available{true};
 
-    std::mutex _colorMtx;
-    std::thread _actionThread;
-
-    // most subclasses don't use this, but bomb will override it
+    static uint64_t PackState(const State &state);
+    static State UnpackState(uint64_t bits);
+    static bool OnBoard(uint64_t bits);     // visible and available, without unpacking the rest
+
+    // apply fn(State&) to the current state and publish the result, retrying if another thread got there first
+    template <typename Fn>
+    State UpdateState(Fn fn)
+    {
+        uint64_t bits = _state.load(std::memory_order_relaxed);
+        State state;
+        do {
+            state = UnpackState(bits);
+            fn(state);
+        } while(!_state.compare_exchange_weak(bits, PackState(state), std::memory_order_acq_rel, std::memory_order_relaxed));
+        return state;
+    }
+
+    SpatialIndex *_index{nullptr};
+    SDL_Point _indexedCell{-1, -1};
+    void UpdateIndex();
+
+    // bookkeeping for the owning pool: free list link
+    ElementPool *_pool{nullptr};
+    GameElement *_nextFree{nullptr};
+    bool _inFreeList{false};
+
+    // most subclasses don't use these, but bomb will override them
     virtual void LoadActionColors() { }
+    virtual void StopAction() { }
 };
 
 
@@ -135,18 +190,6 @@ class Food : public GameElement
     virtual void UseItem() override { }; // no action for a food
 };
 
-class Wall : public GameElement
-{
- public:
-    Wall();
-    Wall(int x, int y);
-    Wall(SDL_Point location);
-    Wall(Color color);
-    ~Wall();
-
-    virtual void UseItem() override { }; // no action for a wall
-};
-
 class Potion : public GameElement
 {
  public:
@@ -162,6 +205,8 @@ class Potion : public GameElement
 
 class Bomb : public GameElement
 {
+    friend class FuseWorker;    // steps the fuse and keeps the list of lit bombs
+
  public:
     Bomb();
     Bomb(int x, int y);
@@ -169,10 +214,19 @@ class Bomb : public GameElement
     Bomb(Color color);
     ~Bomb();
 
-    void LightFuse();
-
     virtual void UseItem() override;
     virtual void LoadActionColors() override;
+
+ protected:
+    virtual void StopAction() override;
+
+ private:
+    // one step of the fuse, called by the worker with its lock held. Returns false once it has exploded.
+    bool BurnFuse();
+
+    FuseWorker *_fuses{&FuseWorker::Shared()};  // taken when the bomb is made, so lighting it never starts a thread
+    Bomb *_nextLit{nullptr};
+    bool _burning{false};
 };
 
 class ShrinkPill : public GameElement
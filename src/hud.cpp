@@ -0,0 +1,203 @@
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "hud.h"
+
+#define HUD_CELL_WIDTH (HUD_GLYPH_WIDTH + 1)     // atlas cell, leaves a blank column between glyphs
+#define HUD_CELL_HEIGHT (HUD_GLYPH_HEIGHT + 1)
+
+// Built-in 5x7 font. Each glyph is seven rows, the low five bits of a row are its pixels (left to right).
+static const char kGlyphChars[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ:.-/()[]%";
+static const uint8_t kGlyphRows[][HUD_GLYPH_HEIGHT] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'A'
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // 'B'
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // 'C'
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // 'D'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // 'E'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // 'F'
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // 'G'
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'H'
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // 'L'
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'O'
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // 'P'
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // 'Q'
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // 'R'
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // 'S'
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // 'W'
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // 'X'
+    {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, // 'Y'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // 'Z'
+    {0x00, 0x04, 0x04, 0x00, 0x04, 0x04, 0x00}, // ':'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, // '['
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, // ']'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+};
+
+static const int kNumGlyphs = sizeof(kGlyphRows) / sizeof(kGlyphRows[0]);
+
+static const SDL_Color kHudTextColor{0xE6, 0xE6, 0xE6, 0xFF};
+static const SDL_Color kHudDeadColor{0xFF, 0x50, 0x50, 0xFF};
+static const SDL_Color kHudPanelColor{0x00, 0x00, 0x00, 0xA0};
+
+bool HudData::operator==(const HudData &d) const
+{
+  return score == d.score && multiplier == d.multiplier && timer == d.timer &&
+         fps == d.fps && frameUs == d.frameUs && jitterUs == d.jitterUs && potions == d.potions && bombs == d.bombs &&
+         shrinkpills == d.shrinkpills && slowpills == d.slowpills && alive == d.alive;
+}
+
+Hud::Hud()
+{
+  for(int &g : _glyphIndex) {
+    g = 0;
+  }
+  for(int i = 0; i < kNumGlyphs; ++i) {
+    unsigned char c = static_cast<unsigned char>(kGlyphChars[i]);
+    _glyphIndex[c] = i;
+    _glyphIndex[std::tolower(c)] = i;
+  }
+  _solidGlyph = kNumGlyphs;
+
+  _vertices.reserve((HUD_MAX_CHARS + 1) * 4);
+  _indices.reserve((HUD_MAX_CHARS + 1) * 6);
+}
+
+Hud::~Hud()
+{
+  if(_atlas != nullptr) {
+    SDL_DestroyTexture(_atlas);
+  }
+}
+
+void Hud::Init(SDL_Renderer *renderer)
+{
+  // one cell per glyph plus the solid cell at the end
+  _atlasWidth = (kNumGlyphs + 1) * HUD_CELL_WIDTH;
+  _atlasHeight = HUD_CELL_HEIGHT;
+  std::vector<Uint32> pixels(_atlasWidth * _atlasHeight, 0);
+
+  // RGBA32 is byte order R, G, B, A - all 0xFF is opaque white on any platform
+  for(int g = 0; g <= kNumGlyphs; ++g) {
+    for(int row = 0; row < HUD_GLYPH_HEIGHT; ++row) {
+      for(int col = 0; col < HUD_GLYPH_WIDTH; ++col) {
+        bool on = (g == _solidGlyph) || ((kGlyphRows[g][row] >> (HUD_GLYPH_WIDTH - 1 - col)) & 1);
+        if(on) {
+          pixels[row * _atlasWidth + g * HUD_CELL_WIDTH + col] = 0xFFFFFFFF;
+        }
+      }
+    }
+  }
+
+  _atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, _atlasWidth, _atlasHeight);
+  if(_atlas == nullptr) {
+    std::cerr << "HUD atlas could not be created.\n";
+    std::cerr << "SDL_Error: " << SDL_GetError() << "\n";
+    return;
+  }
+  SDL_UpdateTexture(_atlas, nullptr, pixels.data(), _atlasWidth * sizeof(Uint32));
+  SDL_SetTextureBlendMode(_atlas, SDL_BLENDMODE_BLEND);
+}
+
+void Hud::Update(const HudData &data)
+{
+  if(_dirty || data != _data) {
+    _data = data;
+    Rebuild();
+    _dirty = false;
+  }
+}
+
+void Hud::AddQuad(float x, float y, float w, float h, int glyph, SDL_Color color)
+{
+  // texture coordinates of the glyph's cell in the atlas (the solid cell is sampled in its middle)
+  float u0 = static_cast<float>(glyph * HUD_CELL_WIDTH) / _atlasWidth;
+  float u1 = static_cast<float>(glyph * HUD_CELL_WIDTH + HUD_GLYPH_WIDTH) / _atlasWidth;
+  float v0 = 0.0f;
+  float v1 = static_cast<float>(HUD_GLYPH_HEIGHT) / _atlasHeight;
+
+  int base = static_cast<int>(_vertices.size());
+  _vertices.push_back({{x, y}, color, {u0, v0}});
+  _vertices.push_back({{x + w, y}, color, {u1, v0}});
+  _vertices.push_back({{x + w, y + h}, color, {u1, v1}});
+  _vertices.push_back({{x, y + h}, color, {u0, v1}});
+
+  const int quad[6] = {0, 1, 2, 0, 2, 3};
+  for(int i : quad) {
+    _indices.push_back(base + i);
+  }
+}
+
+// returns the x position after the last character
+float Hud::AddText(const char *text, float x, float y, SDL_Color color)
+{
+  const float advance = HUD_CELL_WIDTH * HUD_SCALE;
+  for(const char *c = text; *c != '\0'; ++c) {
+    if(static_cast<int>(_vertices.size()) >= HUD_MAX_CHARS * 4) break;
+
+    int glyph = _glyphIndex[static_cast<unsigned char>(*c)];
+    if(glyph != 0) {
+      AddQuad(x, y, HUD_GLYPH_WIDTH * HUD_SCALE, HUD_GLYPH_HEIGHT * HUD_SCALE, glyph, color);
+    }
+    x += advance;
+  }
+  return x;
+}
+
+void Hud::Rebuild()
+{
+  char lines[3][64];
+  std::snprintf(lines[0], sizeof(lines[0]), "SCORE %d  X%d  [%d]%s", _data.score, _data.multiplier, _data.timer, _data.alive ? "" : "  GAME OVER");
+  std::snprintf(lines[1], sizeof(lines[1]), "POTIONS %d  BOMBS %d  SHRINK %d  SLOW %d", _data.potions, _data.bombs, _data.shrinkpills, _data.slowpills);
+  std::snprintf(lines[2], sizeof(lines[2]), "FPS %d  FRAME %d.%02d MS  JITTER %d.%02d MS", _data.fps,
+                _data.frameUs / 1000, (_data.frameUs % 1000) / 10, _data.jitterUs / 1000, (_data.jitterUs % 1000) / 10);
+
+  _vertices.clear();
+  _indices.clear();
+
+  // background panel first so the text is drawn over it in the same batch
+  const float lineHeight = HUD_CELL_HEIGHT * HUD_SCALE + 2;
+  float width = 0;
+  for(auto &line : lines) {
+    float w = static_cast<float>(std::strlen(line)) * HUD_CELL_WIDTH * HUD_SCALE;
+    if(w > width) width = w;
+  }
+  AddQuad(HUD_MARGIN - 3, HUD_MARGIN - 3, width + 6, 3 * lineHeight + 4, _solidGlyph, kHudPanelColor);
+
+  float y = HUD_MARGIN;
+  for(int i = 0; i < 3; ++i) {
+    AddText(lines[i], HUD_MARGIN, y, (i == 0 && !_data.alive) ? kHudDeadColor : kHudTextColor);
+    y += lineHeight;
+  }
+}
+
+void Hud::Draw(SDL_Renderer *renderer) const
+{
+  if(_atlas == nullptr || _indices.empty()) return;
+  SDL_RenderGeometry(renderer, _atlas, _vertices.data(), static_cast<int>(_vertices.size()),
+                     _indices.data(), static_cast<int>(_indices.size()));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+    file: hud.h - contains class Hud, the on-screen score/inventory/frame stats display. Text is drawn from a
+    glyph atlas texture that is built once from a small built-in bitmap font. The text geometry is only rebuilt
+    when one of the displayed values changes, and the whole HUD is drawn with a single geometry call.
+*/
+
+#include <vector>
+#include "SDL.h"
+
+#define HUD_GLYPH_WIDTH 5
+#define HUD_GLYPH_HEIGHT 7
+#define HUD_SCALE 2          // screen pixels per font pixel
+#define HUD_MARGIN 6         // distance from the edge of the screen, in screen pixels
+#define HUD_MAX_CHARS 192    // geometry is reserved for this many glyphs so rebuilding doesn't allocate
+
+struct HudData {
+  int score{0};
+  int multiplier{1};
+  int timer{0};
+  int fps{0};
+  int frameUs{0};      // average frame time over the last second, in microseconds
+  int jitterUs{0};     // standard deviation of the frame interval over the last second
+  int potions{0};
+  int bombs{0};
+  int shrinkpills{0};
+  int slowpills{0};
+  bool alive{true};
+
+  bool operator==(const HudData &d) const;
+  bool operator!=(const HudData &d) const { return !(*this == d); }
+};
+
+class Hud {
+ public:
+  Hud();
+  ~Hud();
+
+  // build the glyph atlas, needs the renderer so it must happen after SDL is up
+  void Init(SDL_Renderer *renderer);
+
+  // regenerate the text geometry if any of the values changed
+  void Update(const HudData &data);
+
+  // draw everything in one batch
+  void Draw(SDL_Renderer *renderer) const;
+
+ private:
+  void AddQuad(float x, float y, float w, float h, int glyph, SDL_Color color);
+  float AddText(const char *text, float x, float y, SDL_Color color);
+  void Rebuild();
+
+  SDL_Texture *_atlas{nullptr};
+  int _atlasWidth{0};
+  int _atlasHeight{0};
+  int _solidGlyph{0};        // an all-white glyph used for the background panel
+  int _glyphIndex[256];      // character -> glyph in the atlas, 0 (space) for unknown characters
+
+  std::vector<SDL_Vertex> _vertices;
+  std::vector<int> _indices;
+
+  HudData _data;
+  bool _dirty{true};
+};
@@ -1,20 +1,63 @@
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "controller.h"
 #include "game.h"
 #include "renderer.h"
+#include "net_client.h"
+#include "trace.h"
 
-int main() {
-  constexpr std::size_t kFramesPerSecond{60};
-  constexpr std::size_t kMsPerFrame{1000 / kFramesPerSecond};
+// SnakeGame --connect <host> [port] plays on a SnakeServer instead of locally
+// SnakeGame --trace [file] records a trace from the start and writes it on exit (F12 starts and writes one too)
+static int PlayOnline(const char *host, uint16_t port, std::size_t screen_width, std::size_t screen_height) {
+  NetClient client;
+  if (!client.Connect(host, port)) {
+    return 1;
+  }
+
+  // the board comes from the server, the client redraws all of it every frame
+  Renderer renderer(screen_width, screen_height, client.GridWidth(), client.GridHeight(), false);
+  Controller controller;
+  client.Run(controller, renderer);
+  std::cout << "Game has terminated successfully!\n";
+  std::cout << "Score: " << client.State().values[kValueScore] << "\n";
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  constexpr double kTicksPerSecond{60.0};    // simulation rate, the snake's speed is per tick
+  constexpr double kFramesPerSecond{60.0};   // display rate in kSleepSpin mode, e.g. 60, 120 or 144
+  constexpr PacingMode kPacingMode{PacingMode::kSleepSpin};
   constexpr std::size_t kScreenWidth{640};
   constexpr std::size_t kScreenHeight{640};
   constexpr std::size_t kGridWidth{32};
   constexpr std::size_t kGridHeight{32};
+  constexpr bool kIncrementalRender{true};  // only repaint the cells that changed each frame
+  constexpr BoardLayout kBoardLayout{BoardLayout::kPerimeter};   // or kMaze, kCave, kRooms
+  constexpr double kRewindSeconds{30.0};   // how much play Backspace can wind back through
+
+  if (argc >= 2 && std::strcmp(argv[1], "--trace") == 0) {
+    if (argc >= 3) Trace::SetOutput(argv[2]);
+    Trace::Start();
+  }
+  if (argc >= 3 && std::strcmp(argv[1], "--connect") == 0) {
+    uint16_t port = argc >= 4 ? static_cast<uint16_t>(std::atoi(argv[3])) : NET_DEFAULT_PORT;
+    return PlayOnline(argv[2], port, kScreenWidth, kScreenHeight);
+  }
 
-  Renderer renderer(kScreenWidth, kScreenHeight, kGridWidth, kGridHeight);
+  Renderer renderer(kScreenWidth, kScreenHeight, kGridWidth, kGridHeight,
+                    kPacingMode == PacingMode::kVsync);
+  if (kIncrementalRender) {
+    renderer.SetRenderMode(Renderer::RenderMode::kIncremental);
+  }
   Controller controller;
-  Game game(kGridWidth, kGridHeight);
-  game.Run(controller, renderer, kMsPerFrame);
+  Game game(kGridWidth, kGridHeight, kBoardLayout);
+  game.EnableRewind(kRewindSeconds, kTicksPerSecond);
+  game.Run(controller, renderer, kTicksPerSecond, kFramesPerSecond, kPacingMode);
+  if (Trace::Enabled()) {
+    Trace::Stop();
+    Trace::Dump();
+  }
   std::cout << "Game has terminated successfully!\n";
   std::cout << "Score: " << game.GetScore() << "\n";
   std::cout << "Size: " << game.GetSize() << "\n";
@@ -0,0 +1,110 @@
+#include "net_bits.h"
+
+BitWriter::BitWriter(std::size_t capacity) :
+    _buffer(capacity, 0)
+{
+}
+
+void BitWriter::Reset()
+{
+    _scratch = 0;
+    _scratchBits = 0;
+    _bytes = 0;
+    _overflow = false;
+}
+
+void BitWriter::WriteBits(uint32_t value, int bits)
+{
+    if(bits <= 0) return;
+    if(bits < 32) value &= (uint32_t{1} << bits) - 1;
+
+    _scratch |= static_cast<uint64_t>(value) << _scratchBits;
+    _scratchBits += bits;
+
+    // whole bytes go straight out, the scratch word never holds more than 39 bits
+    while(_scratchBits >= 8) {
+        if(_bytes < _buffer.size()) {
+            _buffer[_bytes++] = static_cast<uint8_t>(_scratch);
+        } else {
+            _overflow = true;
+        }
+        _scratch >>= 8;
+        _scratchBits -= 8;
+    }
+}
+
+void BitWriter::WriteUnsigned(uint32_t value)
+{
+    uint64_t n = static_cast<uint64_t>(value) + 1;
+    int length = 0;
+    while((n >> (length + 1)) != 0) ++length;
+
+    // length zeros, a one for n's top bit, then the rest of n
+    WriteBits(0, length);
+    WriteBits(1, 1);
+    WriteBits(static_cast<uint32_t>(n), length);
+}
+
+void BitWriter::WriteSigned(int32_t value)
+{
+    uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    WriteUnsigned(zigzag);
+}
+
+void BitWriter::Flush()
+{
+    if(_scratchBits > 0) {
+        if(_bytes < _buffer.size()) {
+            _buffer[_bytes++] = static_cast<uint8_t>(_scratch);
+        } else {
+            _overflow = true;
+        }
+        _scratch = 0;
+        _scratchBits = 0;
+    }
+}
+
+BitReader::BitReader(const uint8_t *data, std::size_t bytes) :
+    _data(data),
+    _bytes(bytes)
+{
+}
+
+uint32_t BitReader::ReadBits(int bits)
+{
+    if(bits <= 0) return 0;
+
+    while(_scratchBits < bits) {
+        if(_next >= _bytes) {
+            _overflow = true;
+            return 0;
+        }
+        _scratch |= static_cast<uint64_t>(_data[_next++]) << _scratchBits;
+        _scratchBits += 8;
+    }
+
+    uint32_t value = static_cast<uint32_t>(_scratch & ((uint64_t{1} << bits) - 1));
+    _scratch >>= bits;
+    _scratchBits -= bits;
+    return value;
+}
+
+uint32_t BitReader::ReadUnsigned()
+{
+    int length = 0;
+    while(!ReadBool()) {
+        if(_overflow || ++length > 32) {
+            _overflow = true;
+            return 0;
+        }
+    }
+
+    uint64_t n = (uint64_t{1} << length) | ReadBits(length);
+    return static_cast<uint32_t>(n - 1);
+}
+
+int32_t BitReader::ReadSigned()
+{
+    uint32_t zigzag = ReadUnsigned();
+    return static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+    file: net_bits.h - contains classes BitWriter and BitReader, which pack values into a byte buffer at the
+    bit level for network packets. Small numbers are written with Elias gamma codes, so a count or gap of
+    a few cells takes a few bits rather than a whole word. The reader never reads past the end of a packet,
+    it flags the overflow and returns zeros so a short or corrupt packet can be detected and dropped.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BitWriter {
+ public:
+    explicit BitWriter(std::size_t capacity);
+
+    void Reset();
+
+    // write the low bits of value, up to 32 of them
+    void WriteBits(uint32_t value, int bits);
+    void WriteBool(bool value) { WriteBits(value ? 1 : 0, 1); }
+
+    // Elias gamma code of value + 1: 1 bit for 0, 3 bits for 1-2, 5 bits for 3-6, ...
+    void WriteUnsigned(uint32_t value);
+    // zigzag so small negative numbers are small too
+    void WriteSigned(int32_t value);
+
+    // write out the last partial byte, call before sending
+    void Flush();
+
+    const uint8_t* Data() const { return _buffer.data(); }
+    std::size_t Bytes() const { return _bytes; }
+    bool Overflowed() const { return _overflow; }
+
+ private:
+    std::vector<uint8_t> _buffer;
+    uint64_t _scratch{0};
+    int _scratchBits{0};
+    std::size_t _bytes{0};
+    bool _overflow{false};
+};
+
+class BitReader {
+ public:
+    BitReader(const uint8_t *data, std::size_t bytes);
+
+    uint32_t ReadBits(int bits);
+    bool ReadBool() { return ReadBits(1) != 0; }
+    uint32_t ReadUnsigned();
+    int32_t ReadSigned();
+
+    bool Overflowed() const { return _overflow; }
+
+ private:
+    const uint8_t *_data;
+    std::size_t _bytes;
+    std::size_t _next{0};   // next byte to load into the scratch word
+    uint64_t _scratch{0};
+    int _scratchBits{0};
+    bool _overflow{false};
+};
+
+// bits needed to hold values 0 .. count - 1
+inline int BitsFor(uint32_t count)
+{
+    int bits = 0;
+    while(bits < 32 && (uint64_t{1} << bits) < count) ++bits;
+    return bits;
+}
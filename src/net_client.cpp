@@ -0,0 +1,387 @@
+#include "net_client.h"
+#include <iostream>
+#include <cmath>
+#include <thread>
+#include "game.h"
+
+NetClient::NetClient() :
+    _packet(NET_MAX_PACKET_BYTES),
+    _writer(NET_MAX_PACKET_BYTES)
+{
+}
+
+NetClient::~NetClient()
+{
+    Disconnect();
+}
+
+bool NetClient::Connect(const char *host, uint16_t port)
+{
+    if(!NetAddress::Resolve(host, port, _server)) {
+        std::cerr << "Could not resolve " << host << ".\n";
+        return false;
+    }
+    if(!_socket.Open(0)) {
+        return false;
+    }
+
+    for(int attempt = 0; attempt < NET_CONNECT_ATTEMPTS; ++attempt) {
+        _writer.Reset();
+        WritePacketHeader(_writer, PacketType::kConnect);
+        _writer.WriteBits(NET_PROTOCOL_VERSION, 8);
+        _writer.Flush();
+        _socket.SendTo(_server, _writer.Data(), _writer.Bytes());
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(NET_CONNECT_RETRY_MS);
+        while(std::chrono::steady_clock::now() < deadline) {
+            NetAddress from;
+            int bytes = _socket.ReceiveFrom(from, _packet.data(), _packet.size());
+            if(bytes < 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            BitReader in(_packet.data(), bytes);
+            PacketType type;
+            if(from != _server || !ReadPacketHeader(in, type) || type != PacketType::kWelcome) continue;
+
+            _id = static_cast<uint16_t>(in.ReadBits(16));
+            _gridWidth = static_cast<int>(in.ReadBits(16));
+            _gridHeight = static_cast<int>(in.ReadBits(16));
+            _ticksPerSecond = in.ReadBits(32) / 1000.0;
+            if(in.Overflowed() || _gridWidth <= 0 || _gridHeight <= 0 || _ticksPerSecond <= 0.0) continue;
+
+            _codec.reset(new NetCodec(_gridWidth, _gridHeight));
+            _codec->Init(_empty);
+            _history.resize(NET_STATE_HISTORY);
+            for(NetState &state : _history) {
+                _codec->Init(state);
+            }
+            _predicted.reset(new Snake(_gridWidth, _gridHeight));
+            _otherCells.Resize(_gridWidth, _gridHeight);
+            _otherHeads.Resize(_gridWidth, _gridHeight);
+            _otherDead.Resize(_gridWidth, _gridHeight);
+            _predictedHeads.assign(NET_STATE_HISTORY, SDL_Point{0, 0});
+            _connected = true;
+
+            std::cout << "Connected to " << _server.ToString() << " as client " << _id << ", " << _gridWidth << "x"
+                      << _gridHeight << " board at " << _ticksPerSecond << " ticks per second" << std::endl;
+            return true;
+        }
+    }
+
+    std::cerr << "No answer from " << _server.ToString() << ".\n";
+    return false;
+}
+
+void NetClient::Disconnect()
+{
+    if(!_connected) return;
+
+    _writer.Reset();
+    WritePacketHeader(_writer, PacketType::kDisconnect);
+    _writer.Flush();
+    _socket.SendTo(_server, _writer.Data(), _writer.Bytes());
+    _connected = false;
+}
+
+void NetClient::Run(Controller const &controller, Renderer &renderer)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point report_timestamp = Clock::now();
+    FrameSnapshot frame;
+    frame.Reserve(0, 0, 0);
+    frame.ReserveWindow(_gridWidth, _gridHeight);
+    int fps = 0;
+    int jitter_us = 0;
+    bool running = true;
+
+    // the display runs at the server's tick rate, one client tick per frame
+    FramePacer pacer(_ticksPerSecond, PacingMode::kSleepSpin);
+    while(running && _connected) {
+        controller.HandleInput(running, _input, renderer.GetCamera());
+        Tick();
+
+        if(_latestTick != 0) {
+            BuildSnapshot(frame);
+            frame.hud.fps = fps;
+            frame.hud.jitterUs = jitter_us;
+            renderer.Render(frame, frame.hud);
+        }
+
+        pacer.Wait();
+
+        PacingStats stats = pacer.Stats();
+        if(Clock::now() - report_timestamp >= std::chrono::seconds(1) && stats.frames > 0) {
+            fps = static_cast<int>(std::lround(1000000.0 / stats.meanUs));
+            jitter_us = static_cast<int>(stats.jitterUs);
+            pacer.ResetStats();
+            report_timestamp = Clock::now();
+        }
+    }
+
+    if(!_connected) {
+        std::cout << "The server closed the connection." << std::endl;
+    }
+    Disconnect();
+}
+
+void NetClient::Tick()
+{
+    if(!_connected) return;
+
+    ReceivePackets();
+    ++_clientTick;
+
+    // queue this tick's input for the server and apply it to the local snake right away
+    _input.Drain([this](const GameEvent &event) {
+        if(event.type != GameEventType::kInputTurn && event.type != GameEventType::kInputUseItem &&
+           event.type != GameEventType::kInputSpeed) {
+            return;
+        }
+        NetInput input;
+        input.seq = _nextSeq++;
+        input.clientTick = _clientTick;
+        input.type = event.type;
+        input.value = (event.type == GameEventType::kInputUseItem) ? static_cast<int>(event.itemType) : event.value;
+        _pending.push_back(input);
+        Apply(input);
+    });
+
+    if(_latestTick != 0 && _predicted->alive) {
+        _predicted->Update();
+    }
+    _predictedHeads[_clientTick % NET_STATE_HISTORY] = SDL_Point{_predicted->HeadX(), _predicted->HeadY()};
+
+    SendInputs();
+}
+
+void NetClient::ReceivePackets()
+{
+    NetAddress from;
+    int bytes;
+    while((bytes = _socket.ReceiveFrom(from, _packet.data(), _packet.size())) >= 0) {
+        if(from != _server) continue;
+        _stats.bytesReceived += bytes;
+
+        BitReader in(_packet.data(), bytes);
+        PacketType type;
+        if(!ReadPacketHeader(in, type)) continue;
+
+        if(type == PacketType::kSnapshot) {
+            if(!HandleSnapshot(in)) _stats.dropped++;
+        } else if(type == PacketType::kDisconnect) {
+            _connected = false;
+            return;
+        }
+    }
+}
+
+bool NetClient::HandleSnapshot(BitReader &in)
+{
+    uint32_t tick = in.ReadBits(32);
+    uint32_t base_tick = in.ReadBits(32);
+    uint32_t ack_seq = in.ReadBits(32);
+    uint32_t ack_client_tick = in.ReadBits(32);
+    if(in.Overflowed() || tick <= _latestTick || tick - base_tick >= NET_STATE_HISTORY) return false;
+
+    const NetState *base = &_empty;
+    if(base_tick != 0) {
+        base = &_history[base_tick % NET_STATE_HISTORY];
+        if(base->tick != base_tick) return false;
+    }
+
+    NetState &state = _history[tick % NET_STATE_HISTORY];
+    if(!_codec->Decode(*base, in, state) || state.snake.empty()) {
+        // don't let a half decoded state be used as a baseline
+        state.tick = 0;
+        return false;
+    }
+    state.tick = tick;
+    _latestTick = tick;
+    _stats.snapshots++;
+
+    Reconcile(state, ack_seq, ack_client_tick);
+    MarkOthers(state);
+    return true;
+}
+
+void NetClient::MarkOthers(const NetState &state)
+{
+    _otherCells.Clear();
+    _otherHeads.Clear();
+    _otherDead.Clear();
+    for(const NetSnake &other : state.others) {
+        for(const SDL_Point &cell : other.cells) {
+            _otherCells.Set(cell.x, cell.y);
+            if(!other.alive) _otherDead.Set(cell.x, cell.y);
+        }
+        if(!other.cells.empty()) _otherHeads.Set(other.cells.back().x, other.cells.back().y);
+    }
+}
+
+// put the local snake where the server had it and replay the inputs it hadn't applied yet
+void NetClient::Reconcile(const NetState &state, uint32_t ack_seq, uint32_t ack_client_tick)
+{
+    while(!_pending.empty() && _pending.front().seq <= ack_seq) {
+        _pending.pop_front();
+    }
+
+    const SDL_Point &head = state.snake.back();
+    if(ack_client_tick != 0 && _clientTick - ack_client_tick < NET_STATE_HISTORY) {
+        const SDL_Point &predicted = _predictedHeads[ack_client_tick % NET_STATE_HISTORY];
+        _stats.predictions++;
+        if(predicted.x != head.x || predicted.y != head.y) _stats.mispredictions++;
+    }
+
+    _predicted->Restore(state.values[kValueHeadX], state.values[kValueHeadY],
+                        static_cast<Snake::Direction>(state.values[kValueDirection]), state.values[kValueSpeed],
+                        state.snake.data(), static_cast<int>(state.snake.size()) - 1, state.values[kValueAlive] != 0);
+
+    uint32_t first = ack_client_tick + 1;
+    if(_clientTick >= NET_MAX_PREDICT_TICKS && first < _clientTick - NET_MAX_PREDICT_TICKS + 1) {
+        first = _clientTick - NET_MAX_PREDICT_TICKS + 1;
+    }
+    for(uint32_t t = first; t <= _clientTick; ++t) {
+        for(const NetInput &input : _pending) {
+            if(input.clientTick == t) Apply(input);
+        }
+        if(_predicted->alive) _predicted->Update();
+        _predictedHeads[t % NET_STATE_HISTORY] = SDL_Point{_predicted->HeadX(), _predicted->HeadY()};
+    }
+}
+
+// the part of an input the client can predict: turning and speed. Items are left to the server.
+void NetClient::Apply(const NetInput &input)
+{
+    Snake &snake = *_predicted;
+    if(input.type == GameEventType::kInputTurn) {
+        // the same rule as Game::ChangeDirection, no turning back on yourself unless you're only a head
+        Snake::Direction direction = static_cast<Snake::Direction>(input.value);
+        Snake::Direction opposite = direction;
+        switch(direction) {
+            case Snake::Direction::kUp: opposite = Snake::Direction::kDown; break;
+            case Snake::Direction::kDown: opposite = Snake::Direction::kUp; break;
+            case Snake::Direction::kLeft: opposite = Snake::Direction::kRight; break;
+            case Snake::Direction::kRight: opposite = Snake::Direction::kLeft; break;
+        }
+        if(snake.direction != opposite || snake.GetSize() == 1) snake.direction = direction;
+    } else if(input.type == GameEventType::kInputSpeed) {
+        snake.AddSpeed(input.value * SPEED_STEP);
+    }
+}
+
+void NetClient::SendInputs()
+{
+    // a lost packet is covered by the next one, the oldest unacknowledged inputs are always repeated
+    while(_pending.size() > NET_MAX_PREDICT_TICKS) {
+        _pending.pop_front();
+    }
+    uint32_t count = static_cast<uint32_t>(std::min<std::size_t>(_pending.size(), NET_INPUT_REDUNDANCY));
+
+    _writer.Reset();
+    WritePacketHeader(_writer, PacketType::kInput);
+    _writer.WriteBits(_clientTick, 32);
+    _writer.WriteBits(_latestTick, 32);
+    _writer.WriteBits(_pending.empty() ? _nextSeq : _pending.front().seq, 32);
+    _writer.WriteBits(count, 4);
+    for(uint32_t i = 0; i < count; ++i) {
+        WriteInput(_writer, _pending[i], _clientTick);
+    }
+    _writer.Flush();
+
+    if(_socket.SendTo(_server, _writer.Data(), _writer.Bytes())) {
+        _stats.bytesSent += _writer.Bytes();
+    }
+}
+
+void NetClient::BuildSnapshot(FrameSnapshot &snapshot) const
+{
+    const NetState &state = State();
+    const Snake &snake = *_predicted;
+
+    // there's no dirty list, every frame is a full repaint from a window covering the whole board
+    snapshot.tick = _clientTick;
+    snapshot.dirtySince = _clientTick;
+    snapshot.repaintAll = true;
+    snapshot.snakeRecolored = false;
+    snapshot.dirty.clear();
+    snapshot.body.clear();
+    snapshot.repaint.clear();
+
+    snapshot.head = SDL_Point{snake.HeadX(), snake.HeadY()};
+    snapshot.headColor = (snake.alive ? liveSnakeHeadColor : deadSnakeHeadColor).toSDLColor();
+    snapshot.bodyColor = (snake.alive ? liveSnakeBodyColor : deadSnakeBodyColor).toSDLColor();
+
+    // a cell takes the color of the last plane it's in, then food, the other snakes, body and head go over that
+    static const Color plane_colors[NET_NUM_PLANES] = {wallColor, potionColor, bombColor, shrinkPillColor, slowPillColor};
+    const int plane_words = _codec->PlaneWords();
+    const int words_per_row = plane_words / _gridHeight;
+    const BitBoard &body = snake.GetOccupancy();
+    const int food_x = state.values[kValueFoodX];
+    const int food_y = state.values[kValueFoodY];
+    auto cell_bit = [](int cell_x, int x) {
+        return (cell_x >= 0 && (cell_x >> 6) == (x >> 6)) ? uint64_t{1} << (cell_x & 63) : 0;
+    };
+
+    snapshot.window = SDL_Rect{0, 0, _gridWidth, _gridHeight};
+    snapshot.cells.clear();
+    snapshot.rowStart.clear();
+    for(int y = 0; y < _gridHeight; ++y) {
+        snapshot.rowStart.push_back(static_cast<int32_t>(snapshot.cells.size()));
+        for(int w = 0; w < words_per_row; ++w) {
+            const int word = y * words_per_row + w;
+            uint64_t bits = body.Row(y)[w] | _otherCells.Row(y)[w];
+            for(int p = 0; p < NET_NUM_PLANES; ++p) {
+                bits |= state.planes[p * plane_words + word];
+            }
+            if(y == food_y) bits |= cell_bit(food_x, w << 6);
+            if(y == snapshot.head.y) bits |= cell_bit(snapshot.head.x, w << 6);
+            while(bits) {
+                const int x = (w << 6) + __builtin_ctzll(bits);
+                const uint64_t bit = bits & (~bits + 1);
+                SDL_Color color = screenBackgroundColor.toSDLColor();
+                if(x == snapshot.head.x && y == snapshot.head.y) {
+                    color = snapshot.headColor;
+                } else if(body.Row(y)[w] & bit) {
+                    color = snapshot.bodyColor;
+                } else if(_otherCells.Row(y)[w] & bit) {
+                    const bool dead = _otherDead.Row(y)[w] & bit;
+                    if(_otherHeads.Row(y)[w] & bit) {
+                        color = (dead ? deadSnakeHeadColor : otherSnakeHeadColor).toSDLColor();
+                    } else {
+                        color = (dead ? deadSnakeBodyColor : otherSnakeBodyColor).toSDLColor();
+                    }
+                } else if(x == food_x && y == food_y) {
+                    color = foodColor.toSDLColor();
+                } else {
+                    for(int p = NET_NUM_PLANES - 1; p >= 0; --p) {
+                        if(state.planes[p * plane_words + word] & bit) {
+                            color = plane_colors[p].toSDLColor();
+                            break;
+                        }
+                    }
+                }
+                snapshot.cells.push_back(SnapshotCell{x, y, color});
+                bits &= bits - 1;
+            }
+        }
+    }
+    snapshot.rowStart.push_back(static_cast<int32_t>(snapshot.cells.size()));
+
+    HudData &hud = snapshot.hud;
+    hud.score = state.values[kValueScore];
+    hud.multiplier = state.values[kValueMultiplier];
+    hud.potions = state.values[kValuePotions];
+    hud.bombs = state.values[kValueBombs];
+    hud.shrinkpills = state.values[kValueShrinkPills];
+    hud.slowpills = state.values[kValueSlowPills];
+    hud.alive = state.values[kValueAlive] != 0;
+}
+
+NetClientStats NetClient::TakeStats()
+{
+    NetClientStats stats = _stats;
+    _stats = NetClientStats();
+    return stats;
+}
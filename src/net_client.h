@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+    file: net_client.h - contains class NetClient, the player's side of networked play. Inputs from the
+    Controller are sent to the server and also applied straight away to a local copy of the snake, so the
+    player's own snake responds without waiting a round trip. When a snapshot arrives the local snake is
+    put back where the server says it was and the inputs the server hasn't applied yet are replayed on top.
+    The other players' snakes near this one are drawn where the newest snapshot had them.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "controller.h"
+#include "renderer.h"
+#include "snake.h"
+#include "event_queue.h"
+#include "frame_snapshot.h"
+#include "net_protocol.h"
+#include "net_socket.h"
+
+#define NET_MAX_PREDICT_TICKS 64    // the furthest the local snake is run ahead of the newest snapshot
+
+struct NetClientStats {
+    uint64_t snapshots{0};
+    uint64_t bytesReceived{0};
+    uint64_t bytesSent{0};
+    uint64_t dropped{0};            // snapshots that arrived late or couldn't be decoded
+    uint64_t predictions{0};        // snapshots checked against the local snake
+    uint64_t mispredictions{0};     // ... where the head was somewhere else
+};
+
+class NetClient {
+ public:
+    NetClient();
+    ~NetClient();
+
+    // say hello and wait for the server's welcome, false if it never comes
+    bool Connect(const char *host, uint16_t port);
+    void Disconnect();
+
+    int GridWidth() const { return _gridWidth; }
+    int GridHeight() const { return _gridHeight; }
+    double TicksPerSecond() const { return _ticksPerSecond; }
+
+    // input events (as the Controller pushes them) for the next tick
+    EventQueue& Input() { return _input; }
+
+    // the interactive loop: input, a client tick and a frame, at the server's tick rate
+    void Run(Controller const &controller, Renderer &renderer);
+
+    // one client tick: apply snapshots that arrived, apply and send this tick's input, move the local snake
+    void Tick();
+
+    // the newest state from the server, and the local snake predicted from it
+    const NetState& State() const { return _history[_latestTick % NET_STATE_HISTORY]; }
+    const Snake& Predicted() const { return *_predicted; }
+
+    // the predicted snake, the other snakes and the server's elements, ready for the Renderer
+    void BuildSnapshot(FrameSnapshot &snapshot) const;
+
+    NetClientStats TakeStats();
+
+ private:
+    void ReceivePackets();
+    bool HandleSnapshot(BitReader &in);
+    void MarkOthers(const NetState &state);
+    void Reconcile(const NetState &state, uint32_t ack_seq, uint32_t ack_client_tick);
+    void Apply(const NetInput &input);
+    void SendInputs();
+
+    UdpSocket _socket;
+    NetAddress _server;
+    bool _connected{false};
+    uint16_t _id{0};
+    int _gridWidth{0};
+    int _gridHeight{0};
+    double _ticksPerSecond{0.0};
+
+    std::unique_ptr<NetCodec> _codec;
+    std::unique_ptr<Snake> _predicted;
+    NetState _empty;                      // the baseline of a full snapshot
+    std::vector<NetState> _history;       // received states by tick % NET_STATE_HISTORY
+    uint32_t _latestTick{0};
+
+    // the cells of the other snakes in the newest state: all of them, their heads, and the dead ones'
+    BitBoard _otherCells;
+    BitBoard _otherHeads;
+    BitBoard _otherDead;
+
+    EventQueue _input;
+    std::deque<NetInput> _pending;        // sent but not yet applied by the server
+    uint32_t _nextSeq{1};
+    uint32_t _clientTick{0};
+    std::vector<SDL_Point> _predictedHeads;   // the local head after each client tick, by tick % NET_STATE_HISTORY
+
+    std::vector<uint8_t> _packet;
+    BitWriter _writer;
+    NetClientStats _stats;
+};
@@ -0,0 +1,352 @@
+#include "net_protocol.h"
+#include <algorithm>
+#include "bitboard.h"
+
+static bool SamePoint(const SDL_Point &a, const SDL_Point &b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+void WritePacketHeader(BitWriter &out, PacketType type)
+{
+    out.WriteBits(NET_PROTOCOL_ID, 16);
+    out.WriteBits(static_cast<uint32_t>(type), 4);
+}
+
+bool ReadPacketHeader(BitReader &in, PacketType &type)
+{
+    if(in.ReadBits(16) != NET_PROTOCOL_ID) return false;
+    uint32_t value = in.ReadBits(4);
+    if(in.Overflowed() || value >= static_cast<uint32_t>(PacketType::NUM_PACKET_TYPES)) return false;
+    type = static_cast<PacketType>(value);
+    return true;
+}
+
+// inputs in a packet have consecutive sequence numbers, so only their tick, kind and value are written
+void WriteInput(BitWriter &out, const NetInput &input, uint32_t packet_tick)
+{
+    out.WriteUnsigned(packet_tick - input.clientTick);
+    switch(input.type) {
+        case GameEventType::kInputTurn:
+            out.WriteBits(0, 2);
+            out.WriteBits(static_cast<uint32_t>(input.value), 2);
+            break;
+        case GameEventType::kInputUseItem:
+            out.WriteBits(1, 2);
+            out.WriteBits(static_cast<uint32_t>(input.value), 3);
+            break;
+        default:
+            out.WriteBits(2, 2);
+            out.WriteSigned(input.value);
+            break;
+    }
+}
+
+bool ReadInput(BitReader &in, uint32_t seq, uint32_t packet_tick, NetInput &input)
+{
+    input.seq = seq;
+    input.clientTick = packet_tick - in.ReadUnsigned();
+    switch(in.ReadBits(2)) {
+        case 0:
+            input.type = GameEventType::kInputTurn;
+            input.value = static_cast<int>(in.ReadBits(2));
+            break;
+        case 1:
+            input.type = GameEventType::kInputUseItem;
+            input.value = static_cast<int>(in.ReadBits(3));
+            break;
+        case 2:
+            input.type = GameEventType::kInputSpeed;
+            input.value = in.ReadSigned();
+            break;
+        default:
+            return false;
+    }
+    return !in.Overflowed();
+}
+
+NetCodec::NetCodec(int grid_width, int grid_height) :
+    _width(grid_width),
+    _height(grid_height),
+    _xBits(BitsFor(grid_width)),
+    _yBits(BitsFor(grid_height))
+{
+    BitBoard layout(grid_width, grid_height);
+    _planeWords = static_cast<int>(layout.WordCount());
+}
+
+void NetCodec::Init(NetState &state) const
+{
+    state.tick = 0;
+    std::fill(std::begin(state.values), std::end(state.values), 0);
+    state.snake.clear();
+    state.others.clear();
+    state.planes.assign(static_cast<std::size_t>(_planeWords) * NET_NUM_PLANES, 0);
+}
+
+void NetCodec::Encode(const NetState &base, const NetState &state, BitWriter &out) const
+{
+    for(int v = 0; v < NUM_NET_VALUES; ++v) {
+        out.WriteBool(state.values[v] != base.values[v]);
+    }
+    for(int v = 0; v < NUM_NET_VALUES; ++v) {
+        if(state.values[v] != base.values[v]) {
+            // the difference wraps like the values do, so any pair of values round trips
+            out.WriteSigned(static_cast<int32_t>(static_cast<uint32_t>(state.values[v]) - static_cast<uint32_t>(base.values[v])));
+        }
+    }
+
+    EncodeSnake(base.snake, state.snake, out);
+
+    for(int p = 0; p < NET_NUM_PLANES; ++p) {
+        EncodePlane(base.planes.data() + p * _planeWords, state.planes.data() + p * _planeWords, out);
+    }
+
+    EncodeOthers(base.others, state.others, out);
+}
+
+// state must not be base, it is rebuilt from it
+bool NetCodec::Decode(const NetState &base, BitReader &in, NetState &state) const
+{
+    bool changed[NUM_NET_VALUES];
+    for(int v = 0; v < NUM_NET_VALUES; ++v) {
+        changed[v] = in.ReadBool();
+    }
+    for(int v = 0; v < NUM_NET_VALUES; ++v) {
+        state.values[v] = base.values[v];
+        if(changed[v]) {
+            state.values[v] = static_cast<int32_t>(static_cast<uint32_t>(base.values[v]) + static_cast<uint32_t>(in.ReadSigned()));
+        }
+    }
+
+    if(!DecodeSnake(base.snake, in, state.snake)) return false;
+
+    state.planes.resize(base.planes.size());
+    for(int p = 0; p < NET_NUM_PLANES; ++p) {
+        if(!DecodePlane(base.planes.data() + p * _planeWords, in, state.planes.data() + p * _planeWords)) return false;
+    }
+
+    if(!DecodeOthers(base.others, in, state.others)) return false;
+    return !in.Overflowed();
+}
+
+// Both lists are in id order, so the snake a base entry is for is found by walking the two together. Each
+// snake is its id (as the gap from the one before), then for one the base has a bit saying whether it
+// changed, and for a changed or new one whether it's alive and its cells against the base snake's.
+void NetCodec::EncodeOthers(const std::vector<NetSnake> &base, const std::vector<NetSnake> &others, BitWriter &out) const
+{
+    static const std::vector<SDL_Point> none;
+
+    out.WriteUnsigned(static_cast<uint32_t>(others.size()));
+    std::size_t b = 0;
+    uint32_t previous = 0;
+    for(const NetSnake &snake : others) {
+        out.WriteUnsigned(snake.id - previous - 1u);
+        previous = snake.id;
+
+        while(b < base.size() && base[b].id < snake.id) ++b;
+        const NetSnake *was = (b < base.size() && base[b].id == snake.id) ? &base[b] : nullptr;
+        if(was) {
+            const bool same = was->alive == snake.alive && was->cells.size() == snake.cells.size() &&
+                              std::equal(was->cells.begin(), was->cells.end(), snake.cells.begin(), SamePoint);
+            out.WriteBool(!same);
+            if(same) continue;
+        }
+        out.WriteBool(snake.alive);
+        EncodeSnake(was ? was->cells : none, snake.cells, out);
+    }
+}
+
+bool NetCodec::DecodeOthers(const std::vector<NetSnake> &base, BitReader &in, std::vector<NetSnake> &others) const
+{
+    static const std::vector<SDL_Point> none;
+
+    std::size_t count = in.ReadUnsigned();
+    if(in.Overflowed() || count >= NET_MAX_CLIENTS) return false;
+
+    others.resize(count);
+    std::size_t b = 0;
+    uint32_t previous = 0;
+    for(NetSnake &snake : others) {
+        uint32_t id = previous + 1 + in.ReadUnsigned();
+        if(in.Overflowed() || id > 0xffff) return false;
+        snake.id = static_cast<uint16_t>(id);
+        previous = id;
+
+        while(b < base.size() && base[b].id < snake.id) ++b;
+        const NetSnake *was = (b < base.size() && base[b].id == snake.id) ? &base[b] : nullptr;
+        if(was && !in.ReadBool()) {
+            snake.alive = was->alive;
+            snake.cells.assign(was->cells.begin(), was->cells.end());
+            continue;
+        }
+        snake.alive = in.ReadBool();
+        if(!DecodeSnake(was ? was->cells : none, in, snake.cells)) return false;
+    }
+    return !in.Overflowed();
+}
+
+// The snake only gains cells at its head and loses them from its tail, so if what's left of the base snake
+// (after some cells came off the tail) is the start of the new one, only the tail count and the new head
+// cells are sent. Anything else (a new game, a dead snake overlapping itself) is sent in full.
+void NetCodec::EncodeSnake(const std::vector<SDL_Point> &base, const std::vector<SDL_Point> &snake, BitWriter &out) const
+{
+    std::size_t removed = 0;
+    std::size_t kept = 0;
+    bool delta = false;
+
+    if(!base.empty() && !snake.empty()) {
+        while(removed < base.size() && !SamePoint(base[removed], snake[0])) ++removed;
+        kept = base.size() - removed;
+        if(kept > 0 && kept <= snake.size() &&
+           std::equal(base.begin() + removed, base.end(), snake.begin(), SamePoint)) {
+            delta = true;
+            for(std::size_t i = kept; i < snake.size() && delta; ++i) {
+                delta = StepCode(snake[i - 1], snake[i]) >= 0;
+            }
+        }
+    }
+
+    out.WriteBool(delta);
+    if(delta) {
+        out.WriteUnsigned(static_cast<uint32_t>(removed));
+        out.WriteUnsigned(static_cast<uint32_t>(snake.size() - kept));
+        for(std::size_t i = kept; i < snake.size(); ++i) {
+            out.WriteBits(static_cast<uint32_t>(StepCode(snake[i - 1], snake[i])), 2);
+        }
+    } else {
+        out.WriteUnsigned(static_cast<uint32_t>(snake.size()));
+        EncodeCells(snake, 0, out);
+    }
+}
+
+bool NetCodec::DecodeSnake(const std::vector<SDL_Point> &base, BitReader &in, std::vector<SDL_Point> &snake) const
+{
+    const std::size_t max_cells = static_cast<std::size_t>(_width) * _height + 1;
+
+    if(in.ReadBool()) {
+        std::size_t removed = in.ReadUnsigned();
+        std::size_t added = in.ReadUnsigned();
+        if(in.Overflowed() || removed >= base.size() || base.size() - removed + added > max_cells) return false;
+
+        snake.assign(base.begin() + removed, base.end());
+        for(std::size_t i = 0; i < added; ++i) {
+            snake.push_back(Step(snake.back(), static_cast<int>(in.ReadBits(2))));
+        }
+    } else {
+        std::size_t count = in.ReadUnsigned();
+        if(in.Overflowed() || count > max_cells) return false;
+        snake.clear();
+        if(!DecodeCells(in, count, snake)) return false;
+    }
+    return !in.Overflowed();
+}
+
+// the first cell as coordinates, then 2 bit steps if every cell is next to the one before (it always is
+// for a live snake), otherwise coordinates for all of them
+void NetCodec::EncodeCells(const std::vector<SDL_Point> &snake, std::size_t first, BitWriter &out) const
+{
+    if(first >= snake.size()) return;
+
+    out.WriteBits(static_cast<uint32_t>(snake[first].x), _xBits);
+    out.WriteBits(static_cast<uint32_t>(snake[first].y), _yBits);
+
+    bool chained = true;
+    for(std::size_t i = first + 1; i < snake.size() && chained; ++i) {
+        chained = StepCode(snake[i - 1], snake[i]) >= 0;
+    }
+    out.WriteBool(chained);
+    for(std::size_t i = first + 1; i < snake.size(); ++i) {
+        if(chained) {
+            out.WriteBits(static_cast<uint32_t>(StepCode(snake[i - 1], snake[i])), 2);
+        } else {
+            out.WriteBits(static_cast<uint32_t>(snake[i].x), _xBits);
+            out.WriteBits(static_cast<uint32_t>(snake[i].y), _yBits);
+        }
+    }
+}
+
+bool NetCodec::DecodeCells(BitReader &in, std::size_t count, std::vector<SDL_Point> &snake) const
+{
+    if(count == 0) return true;
+
+    auto read_cell = [&]() {
+        SDL_Point cell;
+        cell.x = static_cast<int>(in.ReadBits(_xBits));
+        cell.y = static_cast<int>(in.ReadBits(_yBits));
+        return cell;
+    };
+
+    snake.push_back(read_cell());
+    bool chained = in.ReadBool();
+    for(std::size_t i = 1; i < count; ++i) {
+        snake.push_back(chained ? Step(snake.back(), static_cast<int>(in.ReadBits(2))) : read_cell());
+    }
+
+    for(const SDL_Point &cell : snake) {
+        if(cell.x >= _width || cell.y >= _height) return false;
+    }
+    return !in.Overflowed();
+}
+
+// the toggled cells as gaps between their bit indexes, nothing but a single 1 bit if nothing changed
+void NetCodec::EncodePlane(const uint64_t *base, const uint64_t *plane, BitWriter &out) const
+{
+    uint32_t count = 0;
+    for(int w = 0; w < _planeWords; ++w) {
+        count += static_cast<uint32_t>(__builtin_popcountll(base[w] ^ plane[w]));
+    }
+
+    out.WriteUnsigned(count);
+    uint32_t next = 0;
+    for(int w = 0; w < _planeWords && count > 0; ++w) {
+        uint64_t bits = base[w] ^ plane[w];
+        while(bits) {
+            uint32_t index = (static_cast<uint32_t>(w) << 6) + __builtin_ctzll(bits);
+            out.WriteUnsigned(index - next);
+            next = index + 1;
+            bits &= bits - 1;
+            --count;
+        }
+    }
+}
+
+bool NetCodec::DecodePlane(const uint64_t *base, BitReader &in, uint64_t *plane) const
+{
+    const uint32_t total_bits = static_cast<uint32_t>(_planeWords) * 64;
+
+    std::copy(base, base + _planeWords, plane);
+    uint32_t count = in.ReadUnsigned();
+    if(in.Overflowed() || count > total_bits) return false;
+
+    uint32_t next = 0;
+    for(uint32_t i = 0; i < count; ++i) {
+        uint64_t index = static_cast<uint64_t>(next) + in.ReadUnsigned();
+        if(in.Overflowed() || index >= total_bits) return false;
+        plane[index >> 6] ^= uint64_t{1} << (index & 63);
+        next = static_cast<uint32_t>(index) + 1;
+    }
+    return true;
+}
+
+int NetCodec::StepCode(SDL_Point a, SDL_Point b) const
+{
+    int dx = (b.x - a.x + _width) % _width;
+    int dy = (b.y - a.y + _height) % _height;
+    if(dx == 0 && dy == _height - 1) return 0;
+    if(dx == 0 && dy == 1) return 1;
+    if(dy == 0 && dx == _width - 1) return 2;
+    if(dy == 0 && dx == 1) return 3;
+    return -1;
+}
+
+SDL_Point NetCodec::Step(SDL_Point a, int code) const
+{
+    switch(code) {
+        case 0: a.y = (a.y + _height - 1) % _height; break;
+        case 1: a.y = (a.y + 1) % _height; break;
+        case 2: a.x = (a.x + _width - 1) % _width; break;
+        default: a.x = (a.x + 1) % _width; break;
+    }
+    return a;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+/*
+    file: net_protocol.h - the packets exchanged between NetServer and NetClient, struct NetState (the part of
+    a game the server replicates) and class NetCodec, which delta compresses one NetState against another.
+
+    Every tick the server sends each client a snapshot encoded against the newest state that client has
+    acknowledged (or against an empty state if there is none). Only what changed is written, bit packed:
+    the values that changed, how many cells left the snake's tail and the direction of each cell added at
+    its head (2 bits each), and for each element plane the gaps between the cells that toggled. A snake
+    that moves a cell costs a few bits, not the whole body.
+
+    Every client's snake is on the same board, so a snapshot also carries the other snakes near the
+    client's own head, each delta encoded the same way against the same snake in the base state: a bit for
+    one that hasn't changed, the tail count and head steps for one that moved. Snakes further away aren't
+    sent at all, so a client's bandwidth depends on how crowded its part of the board is, not on how many
+    players there are.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "board_planes.h"
+#include "event_queue.h"
+#include "net_bits.h"
+
+#define NET_DEFAULT_PORT 40960
+#define NET_PROTOCOL_ID 0x534E        // "SN", every packet starts with it
+#define NET_PROTOCOL_VERSION 2
+#define NET_MAX_PACKET_BYTES 16384    // larger snapshots (huge boards right after connecting) are not sent
+#define NET_STATE_HISTORY 64          // ticks of state kept on both sides to encode and decode deltas against
+#define NET_INPUT_REDUNDANCY 8        // unacknowledged inputs repeated in every input packet, in case one is lost
+#define NET_TIMEOUT_SECONDS 5         // a client the server hasn't heard from in this long is dropped
+#define NET_CONNECT_ATTEMPTS 20       // connect packets sent before giving up
+#define NET_CONNECT_RETRY_MS 250
+#define NET_MAX_CLIENTS 64
+#define NET_RESPAWN_TICKS 120         // a dead snake starts over somewhere else after this many ticks
+#define NET_INPUT_DELAY_TICKS 2       // client ticks of input the server buffers to ride out jitter
+#define NET_MAX_INPUT_DRIFT 8         // further out of step than this and a client's input clock is resynced
+#define NET_VIEW_CELLS 32             // other snakes are sent to a client while their head is this close to its own
+
+// the element planes sent to clients, a contiguous run of BoardPlanes
+#define NET_FIRST_PLANE kPlaneWall
+#define NET_NUM_PLANES (NUM_BOARD_PLANES - kPlaneWall)
+
+enum class PacketType : uint8_t {
+    kConnect,       // client -> server: protocol version
+    kWelcome,       // server -> client: client id, board size and tick rate
+    kInput,         // client -> server: ack, client tick and the unacknowledged inputs
+    kSnapshot,      // server -> client: one tick, delta encoded against an acknowledged tick
+    kDisconnect,    // either way
+    NUM_PACKET_TYPES
+};
+
+// the scalar part of a NetState, sent as a mask of the ones that changed followed by the differences
+enum NetValue {
+    kValueEpisode,      // increases every time the client's snake starts over
+    kValueScore,
+    kValueMultiplier,
+    kValueSize,
+    kValueAlive,
+    kValueDirection,
+    kValueSpeed,
+    kValueHeadX,        // head position in sub-cell units, for prediction
+    kValueHeadY,
+    kValueFoodX,
+    kValueFoodY,
+    kValuePotions,
+    kValueBombs,
+    kValueShrinkPills,
+    kValueSlowPills,
+    NUM_NET_VALUES
+};
+
+// another client's snake
+struct NetSnake {
+    uint16_t id{0};                     // the client's id
+    bool alive{true};
+    std::vector<SDL_Point> cells;       // tail first, head last
+};
+
+struct NetState {
+    uint32_t tick{0};
+    int32_t values[NUM_NET_VALUES]{};
+    std::vector<SDL_Point> snake;       // tail first, head last
+    std::vector<uint64_t> planes;       // NET_NUM_PLANES planes in the BitBoard layout
+    std::vector<NetSnake> others;       // the other snakes within NET_VIEW_CELLS of the head, by increasing id
+};
+
+// one player input, the GameEvent the Controller pushed squeezed into a few bits
+struct NetInput {
+    uint32_t seq;           // increases by one for every input a client sends
+    uint32_t clientTick;    // the client tick it was applied to the prediction on
+    GameEventType type;     // kInputTurn, kInputUseItem or kInputSpeed
+    int value;              // the direction, item type or speed steps
+};
+
+void WritePacketHeader(BitWriter &out, PacketType type);
+// false if the packet isn't one of ours
+bool ReadPacketHeader(BitReader &in, PacketType &type);
+
+void WriteInput(BitWriter &out, const NetInput &input, uint32_t packet_tick);
+bool ReadInput(BitReader &in, uint32_t seq, uint32_t packet_tick, NetInput &input);
+
+class NetCodec {
+ public:
+    NetCodec(int grid_width, int grid_height);
+
+    int GridWidth() const { return _width; }
+    int GridHeight() const { return _height; }
+    int PlaneWords() const { return _planeWords; }
+
+    // size the planes and clear everything, an empty state is the baseline of a full update
+    void Init(NetState &state) const;
+
+    // write what changed between base and state
+    void Encode(const NetState &base, const NetState &state, BitWriter &out) const;
+    // rebuild state from base and the changes, false if the packet doesn't make sense
+    bool Decode(const NetState &base, BitReader &in, NetState &state) const;
+
+ private:
+    void EncodeOthers(const std::vector<NetSnake> &base, const std::vector<NetSnake> &others, BitWriter &out) const;
+    bool DecodeOthers(const std::vector<NetSnake> &base, BitReader &in, std::vector<NetSnake> &others) const;
+    void EncodeSnake(const std::vector<SDL_Point> &base, const std::vector<SDL_Point> &snake, BitWriter &out) const;
+    bool DecodeSnake(const std::vector<SDL_Point> &base, BitReader &in, std::vector<SDL_Point> &snake) const;
+    void EncodeCells(const std::vector<SDL_Point> &snake, std::size_t first, BitWriter &out) const;
+    bool DecodeCells(BitReader &in, std::size_t count, std::vector<SDL_Point> &snake) const;
+    void EncodePlane(const uint64_t *base, const uint64_t *plane, BitWriter &out) const;
+    bool DecodePlane(const uint64_t *base, BitReader &in, uint64_t *plane) const;
+
+    // 0-3 for a step up, down, left or right (wrapping around the board), -1 if b isn't next to a
+    int StepCode(SDL_Point a, SDL_Point b) const;
+    SDL_Point Step(SDL_Point a, int code) const;
+
+    int _width;
+    int _height;
+    int _planeWords;
+    int _xBits;
+    int _yBits;
+};
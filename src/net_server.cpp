@@ -0,0 +1,377 @@
+#include "net_server.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "debug_log.h"
+
+NetServer::NetServer(int grid_width, int grid_height, double ticks_per_second) :
+    _gridWidth(grid_width),
+    _gridHeight(grid_height),
+    _ticksPerSecond(ticks_per_second),
+    _codec(grid_width, grid_height),
+    _clients(NET_MAX_CLIENTS),
+    _packet(NET_MAX_PACKET_BYTES),
+    _writer(NET_MAX_PACKET_BYTES)
+{
+    _codec.Init(_empty);
+    _planes.resize(static_cast<std::size_t>(_codec.PlaneWords()) * NUM_BOARD_PLANES);
+    for(Client &client : _clients) {
+        client.inputs.reserve(NET_INPUT_REDUNDANCY * NET_MAX_INPUT_DRIFT);
+        client.history.resize(NET_STATE_HISTORY);
+        for(NetState &state : client.history) {
+            _codec.Init(state);
+        }
+    }
+
+    // dozens of snakes logging every pick-up would drown out the server's own output
+    DebugLog::SetEnabled(false);
+
+    // nobody plays at the server, its snakes are all the clients'
+    _game.reset(new Game(grid_width, grid_height));
+    _game->RemovePlayer(0);
+    _game->_dirty.Clear();
+}
+
+bool NetServer::Open(uint16_t port)
+{
+    if(!_socket.Open(port)) {
+        return false;
+    }
+    std::cout << "Server listening on port " << _socket.Port() << ", " << _gridWidth << "x" << _gridHeight
+              << " board at " << _ticksPerSecond << " ticks per second" << std::endl;
+    return true;
+}
+
+void NetServer::Run(std::atomic<bool> &running, bool report)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point report_timestamp = Clock::now();
+    FramePacer pacer(_ticksPerSecond, PacingMode::kSleepSpin);
+
+    while(running) {
+        Tick();
+        pacer.Wait();
+
+        if(report && Clock::now() - report_timestamp >= std::chrono::seconds(1)) {
+            NetServerStats stats = TakeStats();
+            double per_client = stats.clients > 0 ? static_cast<double>(stats.bytesSent) / stats.clients : 0.0;
+            std::cout << stats.clients << " clients, tick " << stats.meanTickUs << " us (max " << stats.maxTickUs
+                      << " us), " << per_client << " bytes/s per client, " << stats.fullSnapshots << " full snapshots" << std::endl;
+            report_timestamp = Clock::now();
+        }
+    }
+}
+
+void NetServer::Tick()
+{
+    auto tick_start = std::chrono::steady_clock::now();
+
+    ReceivePackets();
+    ++_tick;
+
+    for(Client &client : _clients) {
+        if(!client.active) continue;
+
+        // a client that went quiet without saying goodbye
+        if(tick_start - client.lastHeard > std::chrono::seconds(NET_TIMEOUT_SECONDS)) {
+            std::cout << "Client " << client.id << " timed out" << std::endl;
+            Disconnect(client);
+            continue;
+        }
+
+        ApplyInputs(client);
+    }
+
+    auto update_start = std::chrono::steady_clock::now();
+    _game->Update();
+    _updateUsTotal += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - update_start).count();
+
+    for(Client &client : _clients) {
+        if(client.active && !_game->PlayerState(client.player).snake.alive && ++client.deadTicks > NET_RESPAWN_TICKS) {
+            Spawn(client);
+        }
+    }
+    // nothing on the server draws the game
+    _game->_dirty.Clear();
+
+    // the elements are the same for everyone, only the snakes differ
+    _game->WriteBitplanes(_planes.data());
+    for(Client &client : _clients) {
+        if(!client.active) continue;
+        NetState &state = client.history[_tick % NET_STATE_HISTORY];
+        Capture(client, state);
+        SendSnapshot(client, state);
+    }
+
+    double tick_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tick_start).count();
+    _stats.ticks++;
+    _tickUsTotal += tick_us;
+    if(tick_us > _stats.maxTickUs) _stats.maxTickUs = tick_us;
+}
+
+int NetServer::ClientCount() const
+{
+    int count = 0;
+    for(const Client &client : _clients) {
+        if(client.active) ++count;
+    }
+    return count;
+}
+
+NetServerStats NetServer::TakeStats()
+{
+    NetServerStats stats = _stats;
+    stats.clients = ClientCount();
+    stats.meanTickUs = stats.ticks > 0 ? _tickUsTotal / stats.ticks : 0.0;
+    stats.meanUpdateUs = stats.ticks > 0 ? _updateUsTotal / stats.ticks : 0.0;
+    _stats = NetServerStats();
+    _tickUsTotal = 0.0;
+    _updateUsTotal = 0.0;
+    return stats;
+}
+
+void NetServer::ReceivePackets()
+{
+    NetAddress from;
+    int bytes;
+    while((bytes = _socket.ReceiveFrom(from, _packet.data(), _packet.size())) >= 0) {
+        _stats.bytesReceived += bytes;
+
+        BitReader in(_packet.data(), bytes);
+        PacketType type;
+        if(!ReadPacketHeader(in, type)) continue;
+
+        Client *client = FindClient(from);
+        switch(type) {
+            case PacketType::kConnect:
+                if(in.ReadBits(8) == NET_PROTOCOL_VERSION) {
+                    HandleConnect(from);
+                }
+                break;
+            case PacketType::kInput:
+                if(client) HandleInput(*client, in);
+                break;
+            case PacketType::kDisconnect:
+                if(client) {
+                    std::cout << "Client " << client->id << " disconnected" << std::endl;
+                    Disconnect(*client);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void NetServer::HandleConnect(const NetAddress &from)
+{
+    Client *client = FindClient(from);
+    if(client == nullptr) {
+        for(Client &c : _clients) {
+            if(!c.active) {
+                client = &c;
+                break;
+            }
+        }
+        if(client == nullptr) {
+            std::cout << "Server full, refusing " << from.ToString() << std::endl;
+            return;
+        }
+
+        client->active = true;
+        client->address = from;
+        client->id = _nextId++;
+        client->ackTick = 0;
+        client->receivedSeq = 0;
+        client->appliedSeq = 0;
+        client->newestClientTick = 0;
+        client->simClientTick = 0;
+        client->inputs.clear();
+        client->episode = 0;
+        Spawn(*client);
+        std::cout << "Client " << client->id << " connected from " << from.ToString() << std::endl;
+    }
+
+    // the welcome can get lost too, so every connect gets one
+    client->lastHeard = std::chrono::steady_clock::now();
+    SendWelcome(*client);
+}
+
+void NetServer::HandleInput(Client &client, BitReader &in)
+{
+    client.lastHeard = std::chrono::steady_clock::now();
+
+    uint32_t packet_tick = in.ReadBits(32);
+    uint32_t ack = in.ReadBits(32);
+    uint32_t first_seq = in.ReadBits(32);
+    uint32_t count = in.ReadBits(4);
+    if(in.Overflowed()) return;
+
+    // packets can arrive out of order, only ever move forward
+    if(ack > client.ackTick && ack <= _tick) client.ackTick = ack;
+    if(packet_tick > client.newestClientTick) client.newestClientTick = packet_tick;
+
+    for(uint32_t i = 0; i < count; ++i) {
+        NetInput input;
+        if(!ReadInput(in, first_seq + i, packet_tick, input)) return;
+
+        // inputs are repeated until acknowledged, each one is only kept once
+        if(input.seq <= client.receivedSeq) continue;
+        client.receivedSeq = input.seq;
+        client.inputs.push_back(input);
+    }
+}
+
+// step the client's input clock by one tick and push the inputs it reaches into the game
+void NetServer::ApplyInputs(Client &client)
+{
+    if(client.newestClientTick == 0) return;
+
+    int64_t lead = static_cast<int64_t>(client.newestClientTick) - client.simClientTick;
+    if(client.simClientTick == 0 || lead < 0 || lead > NET_MAX_INPUT_DRIFT) {
+        // first input, or the two clocks have drifted apart: start again a few ticks behind the client
+        client.simClientTick = client.newestClientTick > NET_INPUT_DELAY_TICKS ? client.newestClientTick - NET_INPUT_DELAY_TICKS : 1;
+    } else {
+        client.simClientTick++;
+    }
+
+    std::size_t applied = 0;
+    for(const NetInput &input : client.inputs) {
+        if(input.clientTick > client.simClientTick) break;
+        // the same queue the Controller feeds, drained at the start of the game's next Update
+        if(input.type == GameEventType::kInputUseItem) {
+            _game->_input.Push(input.type, {0, 0}, nullptr, static_cast<GameElement::ElementType>(input.value), 0, client.player);
+        } else {
+            _game->_input.Push(input.type, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE, input.value, client.player);
+        }
+        client.appliedSeq = input.seq;
+        ++applied;
+    }
+    client.inputs.erase(client.inputs.begin(), client.inputs.begin() + applied);
+}
+
+void NetServer::SendWelcome(const Client &client)
+{
+    _writer.Reset();
+    WritePacketHeader(_writer, PacketType::kWelcome);
+    _writer.WriteBits(client.id, 16);
+    _writer.WriteBits(static_cast<uint32_t>(_gridWidth), 16);
+    _writer.WriteBits(static_cast<uint32_t>(_gridHeight), 16);
+    _writer.WriteBits(static_cast<uint32_t>(_ticksPerSecond * 1000.0), 32);
+    _writer.Flush();
+    _socket.SendTo(client.address, _writer.Data(), _writer.Bytes());
+}
+
+void NetServer::SendSnapshot(Client &client, const NetState &state)
+{
+    // delta against the newest state the client has, as long as it's still in the history
+    const NetState *base = &_empty;
+    uint32_t base_tick = 0;
+    if(client.ackTick != 0 && _tick - client.ackTick < NET_STATE_HISTORY) {
+        const NetState &acked = client.history[client.ackTick % NET_STATE_HISTORY];
+        if(acked.tick == client.ackTick) {
+            base = &acked;
+            base_tick = client.ackTick;
+        }
+    }
+
+    _writer.Reset();
+    WritePacketHeader(_writer, PacketType::kSnapshot);
+    _writer.WriteBits(_tick, 32);
+    _writer.WriteBits(base_tick, 32);
+    _writer.WriteBits(client.appliedSeq, 32);
+    _writer.WriteBits(client.simClientTick, 32);
+    _codec.Encode(*base, state, _writer);
+    _writer.Flush();
+
+    if(_writer.Overflowed()) {
+        // the next one goes against a newer baseline and will be smaller
+        return;
+    }
+    if(_socket.SendTo(client.address, _writer.Data(), _writer.Bytes())) {
+        _stats.bytesSent += _writer.Bytes();
+        _stats.packetsSent++;
+        if(base_tick == 0) _stats.fullSnapshots++;
+    }
+}
+
+void NetServer::Disconnect(Client &client)
+{
+    client.active = false;
+    _game->RemovePlayer(client.player);
+    client.player = -1;
+}
+
+// a new snake for the client somewhere free on the board, its episode tells the client the old one is gone
+void NetServer::Spawn(Client &client)
+{
+    if(client.player < 0) {
+        client.player = _game->AddPlayer();
+    } else {
+        _game->RespawnPlayer(client.player);
+    }
+    client.episode++;
+    client.deadTicks = 0;
+}
+
+// the client's own snake and values, the element planes WriteBitplanes put in _planes this tick, and the
+// other snakes near the client's head
+void NetServer::Capture(Client &client, NetState &state)
+{
+    const Game &game = *_game;
+    const Player &player = game.PlayerState(client.player);
+    const Snake &snake = player.snake;
+
+    state.tick = _tick;
+    state.values[kValueEpisode] = client.episode;
+    state.values[kValueScore] = player.score;
+    state.values[kValueMultiplier] = player.multiplier;
+    state.values[kValueSize] = snake.GetSize();
+    state.values[kValueAlive] = snake.alive ? 1 : 0;
+    state.values[kValueDirection] = static_cast<int32_t>(snake.direction);
+    state.values[kValueSpeed] = snake.GetSpeed();
+    state.values[kValueHeadX] = snake.FixedHeadX();
+    state.values[kValueHeadY] = snake.FixedHeadY();
+    state.values[kValueFoodX] = game.food.GetLocation().x;
+    state.values[kValueFoodY] = game.food.GetLocation().y;
+    state.values[kValuePotions] = snake.PotionCount();
+    state.values[kValueBombs] = snake.BombCount();
+    state.values[kValueShrinkPills] = snake.ShrinkPillCount();
+    state.values[kValueSlowPills] = snake.SlowPillCount();
+
+    state.snake.assign(snake.body.begin(), snake.body.end());
+    state.snake.push_back({snake.HeadX(), snake.HeadY()});
+
+    std::memcpy(state.planes.data(), _planes.data() + static_cast<std::size_t>(NET_FIRST_PLANE) * _codec.PlaneWords(),
+                state.planes.size() * sizeof(uint64_t));
+
+    // the board wraps, so the distance between two heads does too
+    auto near = [](int a, int b, int size) {
+        const int d = std::abs(a - b);
+        return std::min(d, size - d) <= NET_VIEW_CELLS;
+    };
+    std::size_t count = 0;
+    for(const Client &other : _clients) {
+        if(!other.active || &other == &client) continue;
+        const Snake &theirs = game.PlayerState(other.player).snake;
+        if(!near(theirs.HeadX(), snake.HeadX(), _gridWidth) || !near(theirs.HeadY(), snake.HeadY(), _gridHeight)) continue;
+
+        if(count == state.others.size()) state.others.emplace_back();
+        NetSnake &seen = state.others[count++];
+        seen.id = other.id;
+        seen.alive = theirs.alive;
+        seen.cells.assign(theirs.body.begin(), theirs.body.end());
+        seen.cells.push_back({theirs.HeadX(), theirs.HeadY()});
+    }
+    state.others.resize(count);
+    std::sort(state.others.begin(), state.others.end(), [](const NetSnake &a, const NetSnake &b) { return a.id < b.id; });
+}
+
+NetServer::Client* NetServer::FindClient(const NetAddress &address)
+{
+    for(Client &client : _clients) {
+        if(client.active && client.address == address) return &client;
+    }
+    return nullptr;
+}
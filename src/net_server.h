@@ -0,0 +1,102 @@
+#pragma once
+
+/*
+    file: net_server.h - contains class NetServer, the authoritative side of networked play. The server runs
+    one Game and every client that connects gets a snake in it (a Game player), so they all play on the same
+    board. It applies the inputs the clients send, steps the game at a fixed tick rate and sends each client
+    a snapshot every tick, delta compressed against the newest tick that client has acknowledged: its own
+    snake, the elements and the other snakes near its head. The game is stepped and its planes copied out
+    once a tick however many clients there are, only the snapshots are per client.
+
+    Inputs are buffered a couple of ticks and each server tick consumes exactly one client tick of them, so a
+    snapshot says precisely which client tick it reflects and the client's prediction can line up with it.
+*/
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "game.h"
+#include "net_protocol.h"
+#include "net_socket.h"
+
+struct NetServerStats {
+    int clients{0};
+    int ticks{0};
+    double meanTickUs{0.0};     // receiving, stepping the game and sending every snapshot
+    double maxTickUs{0.0};
+    double meanUpdateUs{0.0};   // ... of which stepping the game
+    uint64_t bytesSent{0};
+    uint64_t packetsSent{0};
+    uint64_t bytesReceived{0};
+    uint64_t fullSnapshots{0};  // snapshots sent without a baseline
+};
+
+class NetServer {
+ public:
+    NetServer(int grid_width, int grid_height, double ticks_per_second);
+
+    // open the socket, port 0 picks any free one
+    bool Open(uint16_t port);
+    uint16_t Port() const { return _socket.Port(); }
+
+    // run ticks until running goes false
+    void Run(std::atomic<bool> &running, bool report);
+
+    // one tick: read every waiting packet, step the game, send every snapshot
+    void Tick();
+
+    int ClientCount() const;
+
+    // stats since the last call
+    NetServerStats TakeStats();
+
+ private:
+    struct Client {
+        bool active{false};
+        NetAddress address;
+        uint16_t id{0};
+        int player{-1};                 // the client's snake in the game
+        int32_t episode{0};
+        int deadTicks{0};
+
+        uint32_t ackTick{0};            // newest snapshot the client has decoded
+        uint32_t receivedSeq{0};        // newest input received
+        uint32_t appliedSeq{0};         // newest input pushed into the game
+        uint32_t newestClientTick{0};   // client tick of the newest input packet
+        uint32_t simClientTick{0};      // the client tick the game has been stepped up to
+        std::vector<NetInput> inputs;   // received but not applied yet, in order
+        std::chrono::steady_clock::time_point lastHeard;
+
+        std::vector<NetState> history;  // the states sent, by tick % NET_STATE_HISTORY
+    };
+
+    void ReceivePackets();
+    void HandleConnect(const NetAddress &from);
+    void HandleInput(Client &client, BitReader &in);
+    void ApplyInputs(Client &client);
+    void SendWelcome(const Client &client);
+    void SendSnapshot(Client &client, const NetState &state);
+    void Disconnect(Client &client);
+    void Spawn(Client &client);
+    void Capture(Client &client, NetState &state);
+    Client* FindClient(const NetAddress &address);
+
+    int _gridWidth;
+    int _gridHeight;
+    double _ticksPerSecond;
+    uint32_t _tick{0};
+    uint16_t _nextId{1};
+
+    UdpSocket _socket;
+    NetCodec _codec;
+    std::unique_ptr<Game> _game;        // every client's snake is in it
+    NetState _empty;                    // the baseline for clients that haven't acknowledged anything
+    std::vector<Client> _clients;
+    std::vector<uint64_t> _planes;      // every board plane of the game this tick, the element planes are copied out
+    std::vector<uint8_t> _packet;
+    BitWriter _writer;
+
+    NetServerStats _stats;
+    double _tickUsTotal{0.0};
+    double _updateUsTotal{0.0};
+};
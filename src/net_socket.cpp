@@ -0,0 +1,112 @@
+#include "net_socket.h"
+#include <iostream>
+#include <cstring>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define NET_SOCKET_BUFFER_BYTES (1 << 20)   // room for a burst of packets from dozens of clients
+
+bool NetAddress::Resolve(const char *host, uint16_t port, NetAddress &address)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo *result = nullptr;
+    if(getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr) {
+        return false;
+    }
+    const sockaddr_in *in = reinterpret_cast<const sockaddr_in*>(result->ai_addr);
+    address.ip = ntohl(in->sin_addr.s_addr);
+    address.port = port;
+    freeaddrinfo(result);
+    return true;
+}
+
+std::string NetAddress::ToString() const
+{
+    return std::to_string((ip >> 24) & 0xFF) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+           std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + ":" + std::to_string(port);
+}
+
+UdpSocket::UdpSocket()
+{
+}
+
+UdpSocket::~UdpSocket()
+{
+    Close();
+}
+
+bool UdpSocket::Open(uint16_t port)
+{
+    Close();
+
+    _fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if(_fd < 0) {
+        std::cerr << "UDP socket could not be created.\n";
+        return false;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if(bind(_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "UDP socket could not be bound to port " << port << ".\n";
+        Close();
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(_fd, reinterpret_cast<sockaddr*>(&address), &length);
+    _port = ntohs(address.sin_port);
+
+    int buffer = NET_SOCKET_BUFFER_BYTES;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    setsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+
+    // the game loops poll the socket once per tick, they never wait on it
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+void UdpSocket::Close()
+{
+    if(_fd >= 0) {
+        close(_fd);
+    }
+    _fd = -1;
+    _port = 0;
+}
+
+bool UdpSocket::SendTo(const NetAddress &to, const uint8_t *data, std::size_t bytes)
+{
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(to.ip);
+    address.sin_port = htons(to.port);
+
+    ssize_t sent = sendto(_fd, data, bytes, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    return sent == static_cast<ssize_t>(bytes);
+}
+
+int UdpSocket::ReceiveFrom(NetAddress &from, uint8_t *data, std::size_t capacity)
+{
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    ssize_t received = recvfrom(_fd, data, capacity, 0, reinterpret_cast<sockaddr*>(&address), &length);
+    if(received < 0) {
+        return -1;
+    }
+    from.ip = ntohl(address.sin_addr.s_addr);
+    from.port = ntohs(address.sin_port);
+    return static_cast<int>(received);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/*
+    file: net_socket.h - contains struct NetAddress and class UdpSocket, a thin non-blocking wrapper over a
+    POSIX UDP socket for the networked game.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct NetAddress {
+    uint32_t ip{0};     // IPv4, host byte order
+    uint16_t port{0};
+
+    bool operator==(const NetAddress &a) const { return ip == a.ip && port == a.port; }
+    bool operator!=(const NetAddress &a) const { return !(*this == a); }
+
+    // a host name or dotted address, false if it can't be resolved
+    static bool Resolve(const char *host, uint16_t port, NetAddress &address);
+    std::string ToString() const;
+};
+
+class UdpSocket {
+ public:
+    UdpSocket();
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // open a non-blocking socket on this port (0 for any free port)
+    bool Open(uint16_t port);
+    void Close();
+    bool IsOpen() const { return _fd >= 0; }
+
+    // the port actually bound, useful after opening on port 0
+    uint16_t Port() const { return _port; }
+
+    bool SendTo(const NetAddress &to, const uint8_t *data, std::size_t bytes);
+
+    // the size of the next waiting datagram copied into data, or -1 if there is none
+    int ReceiveFrom(NetAddress &from, uint8_t *data, std::size_t capacity);
+
+ private:
+    int _fd{-1};
+    uint16_t _port{0};
+};
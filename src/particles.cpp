@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+#include "particles.h"
+#include "color_defines.h"
+
+void ParticleSnapshot::Reserve(std::size_t particles)
+{
+    // sized rather than reserved, CopyTo writes straight into them
+    x.resize(particles);
+    y.resize(particles);
+    size.resize(particles);
+    color.resize(particles);
+    count = 0;
+}
+
+ParticleSystem::ParticleSystem(const Xoshiro256 &random) :
+    _x(PARTICLE_CAPACITY),
+    _y(PARTICLE_CAPACITY),
+    _vx(PARTICLE_CAPACITY),
+    _vy(PARTICLE_CAPACITY),
+    _life(PARTICLE_CAPACITY),
+    _fade(PARTICLE_CAPACITY),
+    _size(PARTICLE_CAPACITY),
+    _color(PARTICLE_CAPACITY),
+    _random(random)
+{
+}
+
+void ParticleSystem::Burst(int x, int y, int count, SDL_Color color, float speed, int ticks, float size)
+{
+    const float fade = 1.0f / static_cast<float>(ticks > 0 ? ticks : 1);
+    for(int n = 0; n < count && _count < PARTICLE_CAPACITY; ++n) {
+        const int i = _count++;
+        const float angle = _random.Unit() * 6.2831853f;
+        const float v = speed * (0.3f + 0.7f * _random.Unit());
+        _x[i] = static_cast<float>(x) + 0.5f;
+        _y[i] = static_cast<float>(y) + 0.5f;
+        _vx[i] = v * std::cos(angle);
+        _vy[i] = v * std::sin(angle);
+        _life[i] = static_cast<float>(ticks);
+        _fade[i] = fade;
+        _size[i] = size;
+        _color[i] = color;
+    }
+}
+
+void ParticleSystem::Debris(int x, int y)
+{
+    // from white hot to the bomb's fuse colors
+    const SDL_Color colors[3] = {bombExplodesColor.toSDLColor(), bombLit6.toSDLColor(), bombLit4.toSDLColor()};
+    for(const SDL_Color &color : colors) {
+        Burst(x, y, DEBRIS_PARTICLES / 3, color, DEBRIS_SPEED, DEBRIS_TICKS, 0.3f);
+    }
+}
+
+void ParticleSystem::Sparks(int x, int y, SDL_Color color)
+{
+    Burst(x, y, SPARK_PARTICLES, color, SPARK_SPEED, SPARK_TICKS, 0.2f);
+}
+
+void ParticleSystem::Dust(int x, int y, SDL_Color color)
+{
+    Burst(x, y, DUST_PARTICLES, color, DUST_SPEED, DUST_TICKS, 0.5f);
+}
+
+// the per-component steps of the update. n is a whole number of PARTICLE_LANES blocks, so every block is a
+// couple of vector instructions even at -O2, and the arrays are parameters so the compiler takes their
+// word that they don't overlap.
+static void AddTo(float *__restrict to, const float *__restrict from, int n)
+{
+    for(int b = 0; b < n; b += PARTICLE_LANES) {
+        for(int k = 0; k < PARTICLE_LANES; ++k) {
+            to[b + k] += from[b + k];
+        }
+    }
+}
+
+static void Scale(float *__restrict values, float by, int n)
+{
+    for(int b = 0; b < n; b += PARTICLE_LANES) {
+        for(int k = 0; k < PARTICLE_LANES; ++k) {
+            values[b + k] *= by;
+        }
+    }
+}
+
+static void Subtract(float *__restrict values, float by, int n)
+{
+    for(int b = 0; b < n; b += PARTICLE_LANES) {
+        for(int k = 0; k < PARTICLE_LANES; ++k) {
+            values[b + k] -= by;
+        }
+    }
+}
+
+void ParticleSystem::Update()
+{
+    // one component at a time, the slots past the last live particle in its block are stepped too and ignored
+    const int n = (_count + PARTICLE_LANES - 1) / PARTICLE_LANES * PARTICLE_LANES;
+    float *x = _x.data();
+    float *y = _y.data();
+    float *vx = _vx.data();
+    float *vy = _vy.data();
+    float *life = _life.data();
+    AddTo(x, vx, n);
+    AddTo(y, vy, n);
+    Scale(vx, PARTICLE_DRAG, n);
+    Scale(vy, PARTICLE_DRAG, n);
+    Subtract(life, 1.0f, n);
+
+    // the last live particle takes the place of each one that faded out, so the live ones stay packed. The
+    // slot it leaves is stopped, or its velocity would decay into denormals that slow the loops above down.
+    int i = 0;
+    while(i < _count) {
+        if(life[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        const int last = --_count;
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        life[i] = life[last];
+        _fade[i] = _fade[last];
+        _size[i] = _size[last];
+        _color[i] = _color[last];
+        vx[last] = 0.0f;
+        vy[last] = 0.0f;
+    }
+}
+
+void ParticleSystem::CopyTo(ParticleSnapshot &out) const
+{
+    const int n = std::min(_count, static_cast<int>(out.x.size()));
+    std::copy(_x.begin(), _x.begin() + n, out.x.begin());
+    std::copy(_y.begin(), _y.begin() + n, out.y.begin());
+
+    // the share of its life a particle has left scales its size and its alpha
+    const float *life = _life.data();
+    const float *fade = _fade.data();
+    const float *size = _size.data();
+    float *outSize = out.size.data();
+    for(int i = 0; i < n; ++i) {
+        outSize[i] = size[i] * life[i] * fade[i];
+    }
+    for(int i = 0; i < n; ++i) {
+        SDL_Color color = _color[i];
+        color.a = static_cast<Uint8>(static_cast<float>(color.a) * life[i] * fade[i]);
+        out.color[i] = color;
+    }
+    out.count = n;
+}
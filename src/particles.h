@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+    file: particles.h - contains class ParticleSystem, the debris, sparks and dust thrown off when a bomb
+    goes off, food is eaten or a wall is blown away. Particles live in a fixed-capacity pool kept as a
+    structure of arrays, one float array per component, with the live particles always packed at the
+    front. Each step of the update is then a straight loop over one or two arrays, which the compiler
+    vectorizes. The pool is stepped once per tick on the simulation thread and copied into the snapshot.
+    The renderer draws the particles in one geometry call, never more of them than its particle budget.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "random.h"
+
+#define PARTICLE_CAPACITY 4096      // live particles, a burst that doesn't fit is cut short
+#define PARTICLE_LANES 8            // particles stepped per block, the capacity has to be a multiple of it
+#define PARTICLE_DRAG 0.9f          // share of its velocity a particle keeps from one tick to the next
+
+// per blasted cell, food eaten and wall blown away
+#define DEBRIS_PARTICLES 6
+#define DEBRIS_SPEED 0.25f          // cells per tick
+#define DEBRIS_TICKS 40
+#define SPARK_PARTICLES 24
+#define SPARK_SPEED 0.15f
+#define SPARK_TICKS 30
+#define DUST_PARTICLES 4
+#define DUST_SPEED 0.05f
+#define DUST_TICKS 90
+
+// the particles as they are at the end of a tick, what the renderer needs and nothing else
+struct ParticleSnapshot {
+    std::vector<float> x;           // cell coordinates, the middle of cell (3, 4) is (3.5, 4.5)
+    std::vector<float> y;
+    std::vector<float> size;        // in cells, shrinking as the particle fades
+    std::vector<SDL_Color> color;   // alpha fading out
+    int count{0};
+
+    void Reserve(std::size_t particles);
+};
+
+class ParticleSystem {
+ public:
+    // random should be a stream of its own, effects never change the game
+    explicit ParticleSystem(const Xoshiro256 &random);
+
+    // throw count particles out of the middle of cell (x, y) in random directions, at up to speed cells per
+    // tick, fading out over ticks
+    void Burst(int x, int y, int count, SDL_Color color, float speed, int ticks, float size);
+
+    // what each effect looks like
+    void Debris(int x, int y);
+    void Sparks(int x, int y, SDL_Color color);
+    void Dust(int x, int y, SDL_Color color);
+
+    // move and age every particle one tick, and drop the ones that have faded out
+    void Update();
+
+    // copy the live particles out, faded by their age
+    void CopyTo(ParticleSnapshot &out) const;
+
+    int Count() const { return _count; }
+    void Clear() { _count = 0; }
+
+    // drop every particle and draw from a new stream, for a new game
+    void Reset(const Xoshiro256 &random)
+    {
+        _count = 0;
+        _random = random;
+    }
+
+ private:
+    // one entry per particle in each, the first _count are live
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _vx;
+    std::vector<float> _vy;
+    std::vector<float> _life;       // ticks left
+    std::vector<float> _fade;       // 1 / the ticks it started with
+    std::vector<float> _size;
+    std::vector<SDL_Color> _color;
+    int _count{0};
+
+    Xoshiro256 _random;
+};
@@ -0,0 +1,57 @@
+#include "random.h"
+
+Xoshiro256::Xoshiro256(uint64_t seed)
+{
+    // splitmix64 spreads the seed over the whole state, and never leaves it all zero
+    for(uint64_t &word : _s) {
+        seed += 0x9E3779B97F4A7C15ull;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        word = z ^ (z >> 31);
+    }
+}
+
+Xoshiro256 Xoshiro256::Stream(uint64_t seed, RandomStream stream)
+{
+    Xoshiro256 random(seed);
+    for(int i = 0; i < static_cast<int>(stream); ++i) {
+        random.LongJump();
+    }
+    return random;
+}
+
+void Xoshiro256::Jump()
+{
+    static const uint64_t kJump[4] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                      0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+    Apply(kJump);
+}
+
+void Xoshiro256::LongJump()
+{
+    static const uint64_t kLongJump[4] = {0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull,
+                                          0x77710069854EE241ull, 0x39109BB02ACBE635ull};
+    Apply(kLongJump);
+}
+
+void Xoshiro256::Apply(const uint64_t (&polynomial)[4])
+{
+    // the state that many draws ahead, from the jump polynomial's bits (256 draws' worth of work)
+    uint64_t s[4] = {0, 0, 0, 0};
+    for(uint64_t word : polynomial) {
+        for(int b = 0; b < 64; ++b) {
+            if(word & (uint64_t{1} << b)) {
+                s[0] ^= _s[0];
+                s[1] ^= _s[1];
+                s[2] ^= _s[2];
+                s[3] ^= _s[3];
+            }
+            Next();
+        }
+    }
+    _s[0] = s[0];
+    _s[1] = s[1];
+    _s[2] = s[2];
+    _s[3] = s[3];
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+    file: random.h - contains class Xoshiro256, the random number generator everything in the game draws
+    from. It is xoshiro256** (Blackman and Vigna): 32 bytes of state, seeded from one 64-bit seed through
+    splitmix64, with a few shifts, rotates and a multiply per draw. LongJump() moves a generator 2^192 draws
+    ahead and Jump() 2^128, so one seed gives a family of streams that never overlap. Each purpose (see
+    RandomStream) gets its own stream, and drawing more from one never changes what another draws. Below()
+    gives unbiased integers in a range with Lemire's multiply-and-reject, nearly always a single multiply.
+*/
+
+#include <cstdint>
+
+// what each stream of a game's seed is for, in the order they're split off
+enum class RandomStream {
+    kPlacement,   // the cells food and power-ups are put in
+    kSpawning,    // whether a power-up appears when food is eaten, and which
+    kWalls,       // the layout's seed and which hidden wall grows back
+    kEffects,     // particles, which never change the game
+    kBots,        // players driven by the program, Jump() once per bot
+    kRounds       // the seed of the next game when one is restarted
+};
+
+class Xoshiro256 {
+ public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed = 0);
+
+    // the seeded generator, long jumped ahead once per stream before this one
+    static Xoshiro256 Stream(uint64_t seed, RandomStream stream);
+
+    uint64_t Next()
+    {
+        const uint64_t result = Rotl(_s[1] * 5, 7) * 9;
+        const uint64_t t = _s[1] << 17;
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+        _s[2] ^= t;
+        _s[3] = Rotl(_s[3], 45);
+        return result;
+    }
+
+    // a uniform integer in [0, bound), 0 if bound is 0
+    uint32_t Below(uint32_t bound)
+    {
+        // the high half of a 32x32 multiply, redrawn in the rare case the low half shows it would be biased
+        uint64_t m = (Next() >> 32) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if(low < bound) {
+            const uint32_t threshold = (0u - bound) % bound;
+            while(low < threshold) {
+                m = (Next() >> 32) * bound;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    // a uniform integer in [lo, hi]
+    int Between(int lo, int hi)
+    {
+        return lo + static_cast<int>(Below(static_cast<uint32_t>(hi - lo) + 1));
+    }
+
+    // a uniform float in [0, 1)
+    float Unit()
+    {
+        return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    void Jump();
+    void LongJump();
+
+    // so it can stand in for a standard engine with the <random> distributions
+    result_type operator()() { return Next(); }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~uint64_t{0}; }
+
+ private:
+    static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    void Apply(const uint64_t (&polynomial)[4]);
+
+    uint64_t _s[4];
+};
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include "reachability.h"
+#include "dirty_cells.h"
+#include "flood_fill.h"
+#include "snake.h"
+
+Reachability::Reachability(const BitBoard &walls, const Snake &snake) :
+    _walls(walls),
+    _snake(snake),
+    _free(walls.Width(), walls.Height()),
+    _respawned(walls.Width(), walls.Height()),
+    _spareOf(2 * REACH_SPARE_NODES, -1),
+    _spareCell(REACH_SPARE_NODES),
+    _cells(walls.Width() * walls.Height())
+{
+    // a node per cell, then the spares for the cells that free up between rebuilds
+    _parent.resize(static_cast<std::size_t>(_cells) + REACH_SPARE_NODES);
+    _rank.resize(_parent.size());
+}
+
+void Reachability::Sync(const DirtyCells &dirty)
+{
+    // the whole board changed and no cells were listed for it
+    if(dirty.All()) {
+        _stale = true;
+        return;
+    }
+
+    for(const SDL_Point &cell : dirty.Cells()) {
+        Refresh(cell.x, cell.y);
+    }
+}
+
+bool Reachability::Blocked(int x, int y) const
+{
+    return _walls.Test(x, y) || _snake.SnakeCell(x, y);
+}
+
+void Reachability::Refresh(int x, int y)
+{
+    if(_stale || !_free.InBounds(x, y)) return;
+
+    bool free = !Blocked(x, y);
+    if(free == _free.Test(x, y)) return;
+
+    const int width = _free.Width();
+    const int height = _free.Height();
+    if(free) {
+        // its old node may still be in the set of a region it no longer touches, so it starts over in a spare
+        // one and joins every free cell next to it. The snake wraps so the sets do too.
+        if(_spares == REACH_SPARE_NODES) {
+            _stale = true;
+            return;
+        }
+        _free.Set(x, y);
+        const int32_t node = _cells + _spares;
+        _spareCell[_spares++] = y * width + x;
+        _parent[node] = node;
+        _rank[node] = 0;
+        _spareOf[SpareSlot(y * width + x)] = node;
+        _respawned.Set(x, y);
+
+        const int nx[4] = {(x + 1) % width, (x + width - 1) % width, x, x};
+        const int ny[4] = {y, y, (y + 1) % height, (y + height - 1) % height};
+        for(int d = 0; d < 4; ++d) {
+            if(_free.Test(nx[d], ny[d])) Union(node, Node(ny[d] * width + nx[d]));
+        }
+    } else {
+        _free.Reset(x, y);
+        if(!LocallyConnected(_free, x, y, true)) _stale = true;
+    }
+}
+
+bool Reachability::Reachable(int x, int y)
+{
+    if(_stale) Rebuild();
+    if(!_free.InBounds(x, y) || !_free.Test(x, y)) return false;
+
+    // the head's own cell is never free, it can get to whatever it's next to
+    const int width = _free.Width();
+    const int height = _free.Height();
+    const int hx = _snake.HeadX();
+    const int hy = _snake.HeadY();
+    const int32_t root = Find(Node(y * width + x));
+    const int nx[4] = {(hx + 1) % width, (hx + width - 1) % width, hx, hx};
+    const int ny[4] = {hy, hy, (hy + 1) % height, (hy + height - 1) % height};
+    for(int d = 0; d < 4; ++d) {
+        if(_free.Test(nx[d], ny[d]) && Find(Node(ny[d] * width + nx[d])) == root) return true;
+    }
+    return false;
+}
+
+int32_t Reachability::Node(int32_t cell) const
+{
+    const int width = _free.Width();
+    if(!_respawned.Test(cell % width, cell / width)) return cell;
+    return _spareOf[SpareSlot(cell)];
+}
+
+// the slot of the cell in the spare node table, open addressing with a multiplicative hash. The table is
+// twice the spares, so a probe finds the cell or an empty slot in a step or two.
+uint32_t Reachability::SpareSlot(int32_t cell) const
+{
+    const uint32_t mask = 2 * REACH_SPARE_NODES - 1;
+    uint32_t slot = (static_cast<uint32_t>(cell) * 2654435761u) & mask;
+    while(_spareOf[slot] >= 0 && _spareCell[_spareOf[slot] - _cells] != cell) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void Reachability::Rebuild()
+{
+    const int width = _free.Width();
+    const int height = _free.Height();
+    const int words = _free.WordsPerRow();
+    const int tail = width & 63;
+    const uint64_t lastMask = tail ? ((uint64_t{1} << tail) - 1) : ~uint64_t{0};
+
+    // the free cells, a word at a time
+    const BitBoard &body = _snake.GetOccupancy();
+    for(int y = 0; y < height; ++y) {
+        const uint64_t *walls = _walls.Row(y);
+        const uint64_t *snake = body.Row(y);
+        uint64_t *row = _free.Row(y);
+        for(int w = 0; w < words; ++w) {
+            row[w] = ~(walls[w] | snake[w]);
+        }
+        row[words - 1] &= lastMask;
+    }
+    _free.Reset(_snake.HeadX(), _snake.HeadY());
+
+    // every cell is its own node again, and the spares are free
+    _respawned.Clear();
+    std::fill(_spareOf.begin(), _spareOf.end(), -1);
+    std::fill(_rank.begin(), _rank.end(), 0);
+    _spares = 0;
+
+    // every run of free cells along a row is a set rooted at its first cell, found from the bits where a run
+    // starts and ends. A cell that isn't free is never looked up until it frees up and gets a new node.
+    for(int y = 0; y < height; ++y) {
+        const uint64_t *row = _free.Row(y);
+        const int32_t rowStart = y * width;
+        uint64_t carry = 0;
+        int32_t root = -1;
+        for(int w = 0; w < words; ++w) {
+            const uint64_t bits = row[w];
+            if(bits == 0 && root < 0) {
+                carry = 0;
+                continue;
+            }
+            const uint64_t next = (w + 1 < words) ? row[w + 1] : 0;
+            uint64_t starts = bits & ~((bits << 1) | carry);
+            uint64_t ends = bits & ~((bits >> 1) | (next << 63));
+            carry = bits >> 63;
+
+            // a run carried in from the last word ends first
+            int from = w << 6;
+            while(root >= 0 || starts) {
+                if(root < 0) {
+                    from = (w << 6) + __builtin_ctzll(starts);
+                    starts &= starts - 1;
+                    root = rowStart + from;
+                }
+                if(!ends) {
+                    // it runs on into the next word
+                    std::fill(&_parent[rowStart + from], &_parent[rowStart + ((w + 1) << 6)], root);
+                    break;
+                }
+                const int to = (w << 6) + __builtin_ctzll(ends) + 1;
+                ends &= ends - 1;
+                std::fill(&_parent[rowStart + from], &_parent[rowStart + to], root);
+                if(to - 1 > root - rowStart) _rank[root] = 1;
+                root = -1;
+            }
+        }
+        // a run through the row's ends is one run, the snake wraps
+        if(width > 1 && _free.Test(0, y) && _free.Test(width - 1, y)) Union(rowStart, rowStart + width - 1);
+    }
+
+    // then join each run to the runs it touches in the row above, once per stretch where they touch
+    for(int y = 0; y < height; ++y) {
+        if(y == 0 && height < 2) break;
+        const int above = (y > 0) ? y - 1 : height - 1;
+        const uint64_t *row = _free.Row(y);
+        const uint64_t *up = _free.Row(above);
+        uint64_t carry = 0;
+        for(int w = 0; w < words; ++w) {
+            uint64_t both = row[w] & up[w];
+            uint64_t starts = both & ~((both << 1) | carry);
+            carry = both >> 63;
+            while(starts) {
+                const int x = (w << 6) + __builtin_ctzll(starts);
+                Union(y * width + x, above * width + x);
+                starts &= starts - 1;
+            }
+        }
+    }
+
+    _stale = false;
+    ++_rebuilds;
+}
+
+int32_t Reachability::Find(int32_t node)
+{
+    // path halving, every other node on the way up points at its grandparent
+    while(_parent[node] != node) {
+        _parent[node] = _parent[_parent[node]];
+        node = _parent[node];
+    }
+    return node;
+}
+
+void Reachability::Union(int32_t a, int32_t b)
+{
+    a = Find(a);
+    b = Find(b);
+    if(a == b) return;
+
+    // the shorter tree goes under the taller one
+    if(_rank[a] < _rank[b]) std::swap(a, b);
+    _parent[b] = a;
+    if(_rank[a] == _rank[b]) ++_rank[a];
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+    file: reachability.h - contains class Reachability, which free cells (no wall showing, no snake) the
+    snake's head can get to. The free cells are kept in a union-find with one set per connected region, so
+    whether a cell is in the head's region is a handful of near-constant finds. A cell that frees up gets a
+    new node that joins the sets around it. A cell that fills in can split a region, which a union-find
+    can't undo, so unless its eight neighbours show it can't have, the sets are marked stale and relabeled
+    from scratch (a row of runs at a time) the next time they're asked. They're also relabeled once the
+    cells that freed up have used up the REACH_SPARE_NODES new nodes. A cell is its own node until it frees
+    up, so the sets take five bytes a cell: a parent and a rank.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+
+#define REACH_SPARE_NODES 4096      // cells that can free up between rebuilds, a few hundred ticks of play
+
+class DirtyCells;
+class Snake;
+
+class Reachability {
+ public:
+    Reachability(const BitBoard &walls, const Snake &snake);
+
+    // look again at every cell changed since the dirty list was last cleared. Going over the same list
+    // twice is harmless, so it can be called mid-tick and again at the end of it.
+    void Sync(const DirtyCells &dirty);
+
+    // whether the head can get to (x, y), which has to be free
+    bool Reachable(int x, int y);
+
+    // relabel every region from the walls and the snake as they are now
+    void Rebuild();
+
+    int Rebuilds() const { return _rebuilds; }
+
+ private:
+    bool Blocked(int x, int y) const;
+    void Refresh(int x, int y);
+    int32_t Node(int32_t cell) const;
+    uint32_t SpareSlot(int32_t cell) const;
+    int32_t Find(int32_t node);
+    void Union(int32_t a, int32_t b);
+
+    const BitBoard &_walls;             // the walls showing, fading in or solid
+    const Snake &_snake;
+    BitBoard _free;                     // the free cells as the sets last saw them
+    BitBoard _respawned;                // cells that freed up since the rebuild, and have a spare node
+    std::vector<int32_t> _parent;       // each node's parent in its set, a node per cell then the spares
+    std::vector<uint8_t> _rank;         // a bound on the height of each root's tree
+    std::vector<int32_t> _spareOf;      // the spare node of a cell in _respawned, hashed by cell, -1 if empty
+    std::vector<int32_t> _spareCell;    // the cell each spare node was handed out for
+    int32_t _cells{0};
+    int32_t _spares{0};                 // spare nodes handed out since the rebuild
+    bool _stale{true};                  // a cell filled in that might have split a region
+    int _rebuilds{0};
+};
@@ -1,14 +1,18 @@
 #include "renderer.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <string>
+#include "color_defines.h"
 
 Renderer::Renderer(const std::size_t screen_width,
                    const std::size_t screen_height,
-                   const std::size_t grid_width, const std::size_t grid_height)
+                   const std::size_t grid_width, const std::size_t grid_height,
+                   bool vsync)
     : screen_width(screen_width),
       screen_height(screen_height),
       grid_width(grid_width),
-      grid_height(grid_height) {
+      grid_height(grid_height),
+      _camera(screen_width, screen_height, grid_width, grid_height) {
   // Initialize SDL
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
     std::cerr << "SDL could not initialize.\n";
@@ -25,15 +29,31 @@ Renderer::Renderer(const std::size_t screen_width,
     std::cerr << " SDL_Error: " << SDL_GetError() << "\n";
   }
 
-  // Create renderer
-  sdl_renderer = SDL_CreateRenderer(sdl_window, -1, SDL_RENDERER_ACCELERATED);
+  // Create renderer, with vsync the present waits for the display's refresh
+  Uint32 flags = SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
+  sdl_renderer = SDL_CreateRenderer(sdl_window, -1, flags);
   if (nullptr == sdl_renderer) {
     std::cerr << "Renderer could not be created.\n";
     std::cerr << "SDL_Error: " << SDL_GetError() << "\n";
   }
+
+  // the score and stats are drawn in the window instead of the title bar
+  _hud.Init(sdl_renderer);
+
+  _particleVertices.reserve(4 * PARTICLE_CAPACITY);
+  _particleIndices.reserve(6 * PARTICLE_CAPACITY);
+  const int quad[6] = {0, 1, 2, 0, 2, 3};
+  for (int base = 0; base < 4 * PARTICLE_CAPACITY; base += 4) {
+    for (int i : quad) {
+      _particleIndices.push_back(base + i);
+    }
+  }
 }
 
 Renderer::~Renderer() {
+  if (_boardTexture != nullptr) {
+    SDL_DestroyTexture(_boardTexture);
+  }
   SDL_DestroyWindow(sdl_window);
   SDL_Quit();
 }
@@ -43,53 +63,219 @@ void Renderer::SetRenderDrawColor(SDL_Renderer *renderer, Color color)
   SDL_SetRenderDrawColor(renderer, color.red(), color.green(), color.blue(), color.alpha());
 }
 
-void Renderer::Render(Snake const &snake, GameElement const &food, std::vector<std::shared_ptr<GameElement>> &elements) {
-  SDL_Rect block;
-  block.w = screen_width / grid_width;
-  block.h = screen_height / grid_height;
+void Renderer::SetRenderDrawColor(SDL_Renderer *renderer, SDL_Color color)
+{
+  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+}
+
+void Renderer::SetRenderMode(RenderMode mode)
+{
+  if(mode == RenderMode::kIncremental && _boardTexture == nullptr && !CreateBoardTexture()) {
+    std::cerr << "Incremental rendering not available, drawing the full board every frame.\n";
+    mode = RenderMode::kFull;
+  }
+
+  // the texture isn't kept up to date in full mode, so it has to be repainted when switching back
+  if(mode == RenderMode::kIncremental && _mode != mode) {
+    _boardValid = false;
+    _repaintRow = 0;
+  }
+  _mode = mode;
+}
+
+bool Renderer::CreateBoardTexture()
+{
+  if(!SDL_RenderTargetSupported(sdl_renderer)) {
+    std::cerr << "Render targets are not supported.\n";
+    return false;
+  }
+
+  SDL_RendererInfo info;
+  if(SDL_GetRendererInfo(sdl_renderer, &info) == 0 && info.max_texture_width > 0 &&
+     (static_cast<int>(grid_width) > info.max_texture_width || static_cast<int>(grid_height) > info.max_texture_height)) {
+    std::cerr << "Board is larger than the maximum texture size (" << info.max_texture_width << "x" << info.max_texture_height << ").\n";
+    return false;
+  }
+
+  // one texel per cell, the camera's viewport is the source rectangle when it gets scaled onto the screen
+  _boardTexture = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                    static_cast<int>(grid_width), static_cast<int>(grid_height));
+  if(nullptr == _boardTexture) {
+    std::cerr << "Board texture could not be created.\n";
+    std::cerr << "SDL_Error: " << SDL_GetError() << "\n";
+    return false;
+  }
+
+  // copy the cells as they are (like the full redraw does) and keep them sharp when scaled up
+  SDL_SetTextureBlendMode(_boardTexture, SDL_BLENDMODE_NONE);
+  SDL_SetTextureScaleMode(_boardTexture, SDL_ScaleModeNearest);
+  return true;
+}
+
+void Renderer::Render(FrameSnapshot const &snapshot, HudData const &hud) {
+  const auto draw_start = std::chrono::steady_clock::now();
+
+  // keep the head in view, only the cells inside the viewport get drawn
+  _camera.Follow(snapshot.head.x, snapshot.head.y);
+  const SDL_Rect view = _camera.GetViewport();
 
   // Clear screen
   SetRenderDrawColor(sdl_renderer, screenBackgroundColor);
   SDL_RenderClear(sdl_renderer);
 
-  // Render the game elements
-  for(auto &g : elements) {
-    if(g->IsVisible()) {
-      g->UpdateColor();
-      SetRenderDrawColor(sdl_renderer, g->getColor());
-      block.x = g->GetLocation().x * block.w;
-      block.y = g->GetLocation().y * block.h;
+  // right after switching to full mode the snapshots don't carry the window yet, but the texture is whole
+  if(_mode == RenderMode::kIncremental || (snapshot.window.w == 0 && _boardValid && _repaintRow < 0)) {
+    RenderIncremental(snapshot, view);
+  } else {
+    RenderFull(snapshot, view);
+  }
+  _lastTick = snapshot.tick;
+
+  // the particles go over the board (the texture never sees them) and under the HUD
+  RenderParticles(snapshot.particles, view);
+
+  // Render the HUD over the board, its text is only regenerated when a value changes
+  _hud.Update(hud);
+  _hud.Draw(sdl_renderer);
+
+  // the present is left out, with vsync it waits for the display whatever was drawn
+  UpdateParticleBudget(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - draw_start).count());
+
+  // Update Screen
+  SDL_RenderPresent(sdl_renderer);
+}
+
+void Renderer::RenderFull(FrameSnapshot const &snapshot, SDL_Rect const &view) {
+  SDL_Rect block;
+  block.w = _camera.GetBlockWidth();
+  block.h = _camera.GetBlockHeight();
+
+  // the window holds the viewport, so only its rows in view are read, each stopping at the first cell past it
+  const SDL_Rect &window = snapshot.window;
+  const int y0 = std::max(view.y, window.y);
+  const int y1 = std::min(view.y + view.h, window.y + window.h);
+  for (int y = y0; y < y1; ++y) {
+    const int row = y - window.y;
+    for (int32_t i = snapshot.rowStart[row]; i < snapshot.rowStart[row + 1]; ++i) {
+      const SnapshotCell &cell = snapshot.cells[i];
+      if (cell.x < view.x) continue;
+      if (cell.x >= view.x + view.w) break;
+      SetRenderDrawColor(sdl_renderer, cell.color);
+      block.x = (cell.x - view.x) * block.w;
+      block.y = (y - view.y) * block.h;
       SDL_RenderFillRect(sdl_renderer, &block);
     }
   }
+}
+
+void Renderer::RenderIncremental(FrameSnapshot const &snapshot, SDL_Rect const &view) {
+  if(SDL_SetRenderTarget(sdl_renderer, _boardTexture) != 0) {
+    // the texture can't be drawn to, fall back to drawing everything
+    RenderFull(snapshot, view);
+    return;
+  }
+
+  if(_boardValid && snapshot.tick == _lastTick) {
+    // same snapshot as the last frame, the texture is already up to date
+  } else {
+    if(!_boardValid) {
+      SetRenderDrawColor(sdl_renderer, screenBackgroundColor);
+      SDL_RenderClear(sdl_renderer);
+      _boardValid = true;
+      _repaintRow = 0;
+    } else if(snapshot.repaintAll || snapshot.dirtySince > _lastTick + 1) {
+      // the dirty list doesn't reach back to the last snapshot drawn, rebuild the texture from the top
+      _repaintRow = 0;
+    }
+
+    // the rebuild goes on from whichever band reaches the next row needed
+    if(_repaintRow >= 0 && snapshot.repaintFrom <= _repaintRow && _repaintRow < snapshot.repaintTo) {
+      PaintArea(SDL_Rect{0, snapshot.repaintFrom, static_cast<int>(grid_width), snapshot.repaintTo - snapshot.repaintFrom},
+                snapshot.repaint);
+      _repaintRow = snapshot.repaintTo < static_cast<int>(grid_height) ? snapshot.repaintTo : -1;
+    }
+
+    for(const SnapshotCell &cell : snapshot.dirty) {
+      SetRenderDrawColor(sdl_renderer, cell.color);
+      SDL_RenderDrawPoint(sdl_renderer, cell.x, cell.y);
+    }
 
-  // Render food
-  SetRenderDrawColor(sdl_renderer, food.getColor());
-  block.x = food.GetLocation().x * block.w;
-  block.y = food.GetLocation().y * block.h;
-  SDL_RenderFillRect(sdl_renderer, &block);
+    // a color change touches every snake cell, but only the snake's cells
+    if(snapshot.snakeRecolored) {
+      SetRenderDrawColor(sdl_renderer, snapshot.bodyColor);
+      for(const SDL_Point &point : snapshot.body) {
+        SDL_RenderDrawPoint(sdl_renderer, point.x, point.y);
+      }
+      SetRenderDrawColor(sdl_renderer, snapshot.headColor);
+      SDL_RenderDrawPoint(sdl_renderer, snapshot.head.x, snapshot.head.y);
+    }
 
-  // Render snake's body
-  SetRenderDrawColor(sdl_renderer, snake.body_color);
-  for (SDL_Point const &point : snake.body) {
-    block.x = point.x * block.w;
-    block.y = point.y * block.h;
-    SDL_RenderFillRect(sdl_renderer, &block);
+    // rows not rebuilt yet can be stale, but never in view: it always lies inside the window
+    if(_repaintRow >= 0) {
+      PaintArea(snapshot.window, snapshot.cells);
+    }
   }
 
-  // Render snake's head
-  block.x = static_cast<int>(snake.head_x) * block.w;
-  block.y = static_cast<int>(snake.head_y) * block.h;
-  SetRenderDrawColor(sdl_renderer, snake.head_color);
-  SDL_RenderFillRect(sdl_renderer, &block);
+  SDL_SetRenderTarget(sdl_renderer, nullptr);
 
-  // Update Screen
-  SDL_RenderPresent(sdl_renderer);
+  // scale the part of the board inside the viewport up onto the screen
+  SDL_Rect dest{0, 0, view.w * _camera.GetBlockWidth(), view.h * _camera.GetBlockHeight()};
+  SDL_RenderCopy(sdl_renderer, _boardTexture, &view, &dest);
 }
 
-//void Renderer::UpdateWindowTitle(int score, int multiplier, int timer, int fps, int potions, int bombs, int shrinkpills) {
-void Renderer::UpdateWindowTitle(int score, int multiplier, int timer, int fps, struct SnakeData *pData)
-{
-  std::string title{"Snake Score: " + std::to_string(score) + " (x" + std::to_string(multiplier) + ") [" + std::to_string(timer) + "] FPS: " + std::to_string(fps) + " Potions: " + std::to_string(pData->potions) + " Bombs: " + std::to_string(pData->bombs) + " Shrink: " + std::to_string(pData->shrinkpills) + " Slow: " + std::to_string(pData->slowpills)};
-  SDL_SetWindowTitle(sdl_window, title.c_str());
+// set an area of the texture to the background and draw the cells found in it over that
+void Renderer::PaintArea(SDL_Rect const &area, std::vector<SnapshotCell> const &cells) {
+  if (area.w <= 0 || area.h <= 0) return;
+  SetRenderDrawColor(sdl_renderer, screenBackgroundColor);
+  SDL_RenderFillRect(sdl_renderer, &area);
+
+  for (const SnapshotCell &cell : cells) {
+    SetRenderDrawColor(sdl_renderer, cell.color);
+    SDL_RenderDrawPoint(sdl_renderer, cell.x, cell.y);
+  }
+}
+
+void Renderer::RenderParticles(ParticleSnapshot const &particles, SDL_Rect const &view) {
+  if (particles.count == 0 || _particleBudget == 0) return;
+
+  // over the budget every stride-th particle is drawn, so every effect thins out rather than the newest vanishing
+  const int stride = (particles.count + _particleBudget - 1) / _particleBudget;
+  const float bw = static_cast<float>(_camera.GetBlockWidth());
+  const float bh = static_cast<float>(_camera.GetBlockHeight());
+  const float right = static_cast<float>(view.w) * bw;
+  const float bottom = static_cast<float>(view.h) * bh;
+
+  _particleVertices.clear();
+  for (int i = 0; i < particles.count; i += stride) {
+    const float cx = (particles.x[i] - static_cast<float>(view.x)) * bw;
+    const float cy = (particles.y[i] - static_cast<float>(view.y)) * bh;
+    const float hw = 0.5f * particles.size[i] * bw;
+    const float hh = 0.5f * particles.size[i] * bh;
+    if (cx + hw < 0.0f || cx - hw > right || cy + hh < 0.0f || cy - hh > bottom) continue;
+
+    const SDL_Color color = particles.color[i];
+    _particleVertices.push_back({{cx - hw, cy - hh}, color, {0.0f, 0.0f}});
+    _particleVertices.push_back({{cx + hw, cy - hh}, color, {0.0f, 0.0f}});
+    _particleVertices.push_back({{cx + hw, cy + hh}, color, {0.0f, 0.0f}});
+    _particleVertices.push_back({{cx - hw, cy + hh}, color, {0.0f, 0.0f}});
+  }
+  if (_particleVertices.empty()) return;
+
+  // all of them in one call, blended so they fade out
+  const int quads = static_cast<int>(_particleVertices.size()) / 4;
+  SDL_SetRenderDrawBlendMode(sdl_renderer, SDL_BLENDMODE_BLEND);
+  SDL_RenderGeometry(sdl_renderer, nullptr, _particleVertices.data(), 4 * quads, _particleIndices.data(), 6 * quads);
+  SDL_SetRenderDrawBlendMode(sdl_renderer, SDL_BLENDMODE_NONE);
+}
+
+void Renderer::UpdateParticleBudget(double drawUs) {
+  if (_frameTargetUs <= 0.0) return;
+
+  // particles are the one part of a frame that can be cut, so one slow frame halves them at once and they only
+  // come back a step at a time
+  if (drawUs > _frameTargetUs) {
+    _particleBudget /= 2;
+  } else if (drawUs < 0.5 * _frameTargetUs) {
+    _particleBudget = std::min(_particleBudget + PARTICLE_BUDGET_STEP, PARTICLE_CAPACITY);
+  }
 }
@@ -4,17 +4,45 @@
 #include <vector>
 #include <memory>
 #include "SDL.h"
-#include "snake.h"
+#include "color.h"
+#include "camera.h"
+#include "hud.h"
+#include "frame_snapshot.h"
+
+#define PARTICLE_BUDGET_STEP 256   // particles the budget grows back by after each frame with time to spare
 
 class Renderer {
  public:
+  // kFull redraws every visible cell each frame, kIncremental keeps the board in a texture (one texel
+  // per cell) and only repaints the dirty cells before scaling the viewport onto the screen. When the
+  // texture has to be rebuilt it's done a band of rows per snapshot, with the cells around the head
+  // painted from the snapshot's window meanwhile.
+  enum class RenderMode { kFull, kIncremental };
+
   Renderer(const std::size_t screen_width, const std::size_t screen_height,
-           const std::size_t grid_width, const std::size_t grid_height);
+           const std::size_t grid_width, const std::size_t grid_height,
+           bool vsync = false);
   ~Renderer();
 
-  void Render(Snake const &snake, GameElement const &food, std::vector<std::shared_ptr<GameElement>> &elements);
+  // draw a snapshot published by the simulation, the renderer never reads the game objects themselves
+  void Render(FrameSnapshot const &snapshot, HudData const &hud);
   void SetRenderDrawColor(SDL_Renderer *renderer, Color color);
-  void UpdateWindowTitle(int score, int multiplier, int timer, int fps, struct SnakeData *pData);
+  void SetRenderDrawColor(SDL_Renderer *renderer, SDL_Color color);
+
+  Camera& GetCamera() { return _camera; }
+
+  void SetRenderMode(RenderMode mode);
+  RenderMode GetRenderMode() const { return _mode; }
+
+  // what the next snapshots should carry: the window around the head, and the first row of the board
+  // still to be rebuilt in the texture (-1 for none)
+  bool WantsWindow() const { return _mode == RenderMode::kFull || _repaintRow >= 0; }
+  int RepaintRow() const { return _mode == RenderMode::kIncremental ? _repaintRow : -1; }
+
+  // the time a frame has, in microseconds. The particle budget halves after any frame that takes longer to
+  // draw, and grows back while frames take less than half of it. 0 (the default) draws every particle.
+  void SetFrameTarget(double us) { _frameTargetUs = us; }
+  int GetParticleBudget() const { return _particleBudget; }
 
  private:
   SDL_Window *sdl_window;
@@ -24,6 +52,28 @@ class Renderer {
   const std::size_t screen_height;
   const std::size_t grid_width;
   const std::size_t grid_height;
+
+  void RenderFull(FrameSnapshot const &snapshot, SDL_Rect const &view);
+  void RenderIncremental(FrameSnapshot const &snapshot, SDL_Rect const &view);
+  bool CreateBoardTexture();
+  void PaintArea(SDL_Rect const &area, std::vector<SnapshotCell> const &cells);
+  void RenderParticles(ParticleSnapshot const &particles, SDL_Rect const &view);
+  void UpdateParticleBudget(double drawUs);
+
+  Camera _camera;
+  Hud _hud;
+
+  RenderMode _mode{RenderMode::kFull};
+  SDL_Texture *_boardTexture{nullptr};
+  bool _boardValid{false};  // false until the texture has been cleared
+  int _repaintRow{0};       // the first row of the texture still to be rebuilt, -1 once it holds the whole board
+  uint64_t _lastTick{0};    // tick of the last snapshot drawn, a dirty list starting after it means changes were missed
+
+  // every particle is a quad, the indices never change so they're built once for the whole pool
+  std::vector<SDL_Vertex> _particleVertices;
+  std::vector<int> _particleIndices;
+  int _particleBudget{PARTICLE_CAPACITY};
+  double _frameTargetUs{0.0};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,483 @@
+#include "rewind.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "game.h"
+#include "debug_log.h"
+#include "trace.h"
+
+namespace {
+    // on a dirty cell, which of its state byte and its board and wall words come next
+    constexpr uint32_t kStateFollows = uint32_t{1} << 30;
+    constexpr uint32_t kWordsFollow = uint32_t{1} << 31;
+
+    // appends to a keyframe's delta bytes, and notes when they run out instead of writing past them
+    struct Writer {
+        uint8_t *data;
+        std::size_t size;
+        std::size_t at;
+        bool full{false};
+
+        template <typename T>
+        void Put(const T &value)
+        {
+            if(at + sizeof(T) > size) {
+                full = true;
+                return;
+            }
+            std::memcpy(data + at, &value, sizeof(T));
+            at += sizeof(T);
+        }
+
+        // fill in a count put down as a placeholder before what it counts
+        void Patch(std::size_t where, uint32_t count)
+        {
+            if(!full) std::memcpy(data + where, &count, sizeof(count));
+        }
+    };
+
+    template <typename T>
+    T Get(const uint8_t *data, std::size_t &at)
+    {
+        T value;
+        std::memcpy(&value, data + at, sizeof(T));
+        at += sizeof(T);
+        return value;
+    }
+
+    uint32_t PackCell(SDL_Point cell) { return (static_cast<uint32_t>(cell.y) << 16) | static_cast<uint32_t>(cell.x); }
+    SDL_Point UnpackCell(uint32_t cell) { return {static_cast<int>(cell & 0xFFFF), static_cast<int>(cell >> 16)}; }
+
+    uint32_t PackColor(const Color &c)
+    {
+        return uint32_t{c.red()} | (uint32_t{c.green()} << 8) | (uint32_t{c.blue()} << 16) | (uint32_t{c.alpha()} << 24);
+    }
+    Color UnpackColor(uint32_t c) { return Color(c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, c >> 24); }
+
+    // the list's new length, then the slots that differ from what it was, in one pass
+    template <typename T>
+    void PutListDiff(Writer &out, const std::vector<T> &before, const std::vector<T> &after)
+    {
+        out.Put(static_cast<uint32_t>(after.size()));
+        const std::size_t countAt = out.at;
+        out.Put(uint32_t{0});
+
+        uint32_t changed = 0;
+        for(std::size_t i = 0; i < after.size() && !out.full; ++i) {
+            if(i < before.size() && std::memcmp(&before[i], &after[i], sizeof(T)) == 0) continue;
+            out.Put(static_cast<uint32_t>(i));
+            out.Put(after[i]);
+            ++changed;
+        }
+        out.Patch(countAt, changed);
+    }
+
+    template <typename T>
+    void GetListDiff(const uint8_t *data, std::size_t &at, std::vector<T> &list)
+    {
+        list.resize(Get<uint32_t>(data, at));
+        for(uint32_t changed = Get<uint32_t>(data, at); changed > 0; --changed) {
+            const uint32_t i = Get<uint32_t>(data, at);
+            list[i] = Get<T>(data, at);
+        }
+    }
+}
+
+Rewind::Rewind(Game &game, double seconds, double ticks_per_second) :
+    _game(game),
+    _ticksPerSecond(ticks_per_second),
+    _keyframes(REWIND_KEYFRAMES)
+{
+    static_assert(sizeof(Scalars) == kScalarWords * sizeof(uint64_t) && kScalarWords <= 64,
+                  "the scalars are diffed as up to 64 whole words");
+    static_assert(sizeof(ElementRecord) == 16, "element records are compared as bytes, they can't have padding");
+
+    // the keyframes but the one being filled cover the window
+    const uint64_t window = std::max<uint64_t>(TicksFor(seconds), 1);
+    _interval = (window + REWIND_KEYFRAMES - 2) / (REWIND_KEYFRAMES - 1);
+
+    // room for everything up front, recording never allocates
+    for(Keyframe &key : _keyframes) {
+        key.board.resize(game.board_bits.WordCount());
+        key.shown.resize(game._walls._shown.WordCount());
+        key.wallStates.resize(game._walls._state.size());
+        key.body.reserve(game.snake.body.capacity());
+        key.deltas.resize(_interval * REWIND_TICK_BYTES);
+    }
+    _lastBoard.resize(game.board_bits.WordCount());
+    _lastShown.resize(game._walls._shown.WordCount());
+    _lastWallStates.resize(game._walls._state.size());
+    ReserveElements(game._pool.Capacity());
+
+    DEBUG_LOG("Rewind: " << seconds << " s, a keyframe every " << _interval << " ticks, "
+              << REWIND_KEYFRAMES * (_interval * REWIND_TICK_BYTES + _keyframes[0].wallStates.size()
+                                     + 16 * _keyframes[0].board.size()) / 1024 << " KB");
+}
+
+uint64_t Rewind::TicksFor(double seconds) const
+{
+    return static_cast<uint64_t>(std::llround(std::max(seconds, 0.0) * _ticksPerSecond));
+}
+
+uint64_t Rewind::Available() const
+{
+    return _count > 0 ? _tick - Slot(0).tick : 0;
+}
+
+void Rewind::Record()
+{
+    ++_tick;
+    ReserveElements(_game._pool.Capacity());
+    CaptureElements(_elements);
+    const Scalars scalars = CaptureScalars();
+
+    // a keyframe when the last one is full, or when this tick changed too much to store as a delta
+    if(_count == 0 || _game._dirty.All() || Slot(_count - 1).ticks >= _interval || !StoreDelta(Slot(_count - 1), scalars)) {
+        StoreKeyframe(scalars);
+    }
+
+    const Snake &snake = _game.snake;
+    _lastScalars = scalars;
+    _lastPushes = snake._bodyPushes;
+    _lastPops = snake._bodyPops;
+    _lastElements.swap(_elements);
+}
+
+uint8_t Rewind::Indexed(const Game &game, const GameElement *element)
+{
+    const SDL_Point cell = element->GetLocation();
+    return cell.x >= 0 && cell.y >= 0 && game._index.At(cell.x, cell.y) == element;
+}
+
+// an element put in a cell another one had since taken over is left out of the index until it's hidden,
+// so it goes back the same way: where it was, but not indexed
+void Rewind::Reindex(GameElement *element, bool indexed)
+{
+    if(indexed) {
+        element->UpdateIndex();
+    } else if(element->IsVisible()) {
+        element->_indexedCell = element->GetLocation();
+    }
+}
+
+Rewind::Scalars Rewind::CaptureScalars() const
+{
+    const Game &game = _game;
+    const Snake &snake = game.snake;
+
+    Scalars s;
+    s.placementRandom = game._placementRandom;
+    s.spawnRandom = game._spawnRandom;
+    s.wallRandom = game._wallRandom;
+    s.roundRandom = game._roundRandom;
+    s.foodState = game.food._state.load(std::memory_order_acquire);
+    s.score = game._local.score;
+    s.multiplier = game._local.multiplier;
+    s.multiplierTimer = game._local.multiplierTimer;
+    s.wallTicks = game._walls._ticks;
+    s.headX = snake._headX;
+    s.headY = snake._headY;
+    s.speed = snake._speed;
+    s.direction = static_cast<int32_t>(snake.direction);
+    s.size = snake._pData ? snake._pData->size : 0;
+    s.invincibleTimer = snake._invincibleTimer;
+    s.headColor = PackColor(snake.head_color);
+    s.bodyColor = PackColor(snake.body_color);
+    for(int type = 0; type < GameElement::NUM_ELEMENT_TYPES - 1; ++type) {
+        s.items[type] = static_cast<int32_t>(snake._items[type].size());
+    }
+    s.alive = snake.alive;
+    s.growing = snake._growing;
+    s.shrinking = snake._shrinking;
+    s.invincible = snake._invincible;
+    s.abilityActive = snake._abilityActive;
+    s.foodIndexed = Indexed(game, &game.food);
+    s.unused[0] = s.unused[1] = 0;
+    return s;
+}
+
+// room for that many power-ups on the board in every list that holds them, only ever more than there was
+void Rewind::ReserveElements(std::size_t count)
+{
+    if(count <= _elements.capacity()) return;
+    for(Keyframe &key : _keyframes) {
+        key.elements.reserve(count);
+    }
+    _lastElements.reserve(count);
+    _elements.reserve(count);
+}
+
+void Rewind::CaptureElements(std::vector<ElementRecord> &elements) const
+{
+    elements.clear();
+    const Game &game = _game;
+    game._pool.ForEach([&](GameElement *element) {
+        // the inventory is counted in the scalars, and lit bombs are left out: their fuses burn on the wall
+        // clock, so a seek doesn't bring them back
+        const uint64_t bits = element->_state.load(std::memory_order_acquire);
+        if(!GameElement::OnBoard(bits)) return;
+        elements.push_back({bits, element->_appearanceTimer, static_cast<uint8_t>(element->_elementType),
+                            static_cast<uint8_t>(element->_solid), Indexed(game, element), 0});
+    });
+}
+
+void Rewind::StoreKeyframe(const Scalars &scalars)
+{
+    if(_count == REWIND_KEYFRAMES) {
+        _first = (_first + 1) % REWIND_KEYFRAMES;
+        --_count;
+    }
+    Keyframe &key = Slot(_count++);
+
+    const Game &game = _game;
+    const WallLayer &walls = game._walls;
+    key.tick = _tick;
+    key.scalars = scalars;
+    std::copy(game.board_bits.Data(), game.board_bits.Data() + game.board_bits.WordCount(), key.board.begin());
+    std::copy(walls._shown.Data(), walls._shown.Data() + walls._shown.WordCount(), key.shown.begin());
+    std::copy(walls._state.begin(), walls._state.end(), key.wallStates.begin());
+    _lastBoard.assign(key.board.begin(), key.board.end());
+    _lastShown.assign(key.shown.begin(), key.shown.end());
+    _lastWallStates.assign(key.wallStates.begin(), key.wallStates.end());
+    key.body.clear();
+    for(const SDL_Point &cell : game.snake.body) {
+        key.body.push_back(PackCell(cell));
+    }
+    key.elements.assign(_elements.begin(), _elements.end());
+    key.used = 0;
+    key.ticks = 0;
+}
+
+bool Rewind::StoreDelta(Keyframe &key, const Scalars &scalars)
+{
+    const Game &game = _game;
+    const Snake &snake = game.snake;
+    const WallLayer &walls = game._walls;
+    Writer out{key.deltas.data(), key.deltas.size(), key.used};
+
+    // the words of the scalars that changed
+    uint64_t words[kScalarWords];
+    uint64_t last[kScalarWords];
+    std::memcpy(words, &scalars, sizeof(words));
+    std::memcpy(last, &_lastScalars, sizeof(last));
+    uint64_t mask = 0;
+    for(int i = 0; i < kScalarWords; ++i) {
+        if(words[i] != last[i]) mask |= uint64_t{1} << i;
+    }
+    out.Put(mask);
+    for(int i = 0; i < kScalarWords; ++i) {
+        if(mask & (uint64_t{1} << i)) out.Put(words[i]);
+    }
+
+    // the cells pushed onto the head end are the last ones in the body, unless a shrink took them off again
+    const uint64_t pushed = snake._bodyPushes - _lastPushes;
+    const uint64_t popped = snake._bodyPops - _lastPops;
+    if(pushed > snake.body.size()) return false;
+    out.Put(static_cast<uint32_t>(pushed));
+    out.Put(static_cast<uint32_t>(popped));
+    for(std::size_t i = snake.body.size() - pushed; i < snake.body.size(); ++i) {
+        out.Put(PackCell(snake.body[i]));
+    }
+
+    // every change to the board and the walls marks its cell, so the dirty cells are the only places to look.
+    // Most of them are only recolored, only the state bytes and words that differ from last tick are stored.
+    const std::vector<SDL_Point> &cells = game._dirty.Cells();
+    const int wordsPerRow = game.board_bits.WordsPerRow();
+    const std::size_t countAt = out.at;
+    uint32_t changed = 0;
+    out.Put(uint32_t{0});
+    for(const SDL_Point &cell : cells) {
+        const int index = cell.y * walls._shown.Width() + cell.x;
+        const int word = cell.y * wordsPerRow + (cell.x >> 6);
+        const uint8_t state = walls._state[index];
+        const uint64_t board = game.board_bits.Data()[word];
+        const uint64_t shown = walls._shown.Data()[word];
+
+        uint32_t entry = static_cast<uint32_t>(index);
+        if(state != _lastWallStates[index]) entry |= kStateFollows;
+        if(board != _lastBoard[word] || shown != _lastShown[word]) entry |= kWordsFollow;
+        if(entry == static_cast<uint32_t>(index)) continue;
+
+        out.Put(entry);
+        if(entry & kStateFollows) {
+            out.Put(state);
+            _lastWallStates[index] = state;
+        }
+        if(entry & kWordsFollow) {
+            out.Put(board);
+            out.Put(shown);
+            _lastBoard[word] = board;
+            _lastShown[word] = shown;
+        }
+        ++changed;
+    }
+    out.Patch(countAt, changed);
+
+    PutListDiff(out, _lastElements, _elements);
+
+    if(out.full) return false;
+    key.used = out.at;
+    ++key.ticks;
+    return true;
+}
+
+uint64_t Rewind::ReplayDelta(const Keyframe &key, std::size_t &at, Scalars &scalars)
+{
+    Game &game = _game;
+    WallLayer &walls = game._walls;
+    const uint8_t *data = key.deltas.data();
+
+    uint64_t words[kScalarWords];
+    std::memcpy(words, &scalars, sizeof(words));
+    const uint64_t mask = Get<uint64_t>(data, at);
+    for(int i = 0; i < kScalarWords; ++i) {
+        if(mask & (uint64_t{1} << i)) words[i] = Get<uint64_t>(data, at);
+    }
+    std::memcpy(&scalars, words, sizeof(words));
+
+    // cells only ever come off the tail, so the caller takes them all off once the replay is done
+    const uint32_t pushed = Get<uint32_t>(data, at);
+    const uint32_t popped = Get<uint32_t>(data, at);
+    for(uint32_t i = 0; i < pushed; ++i) {
+        game.snake.body.push_back(UnpackCell(Get<uint32_t>(data, at)));
+    }
+
+    const int wordsPerRow = game.board_bits.WordsPerRow();
+    for(uint32_t cells = Get<uint32_t>(data, at); cells > 0; --cells) {
+        const uint32_t entry = Get<uint32_t>(data, at);
+        const int index = static_cast<int>(entry & ~(kStateFollows | kWordsFollow));
+        if(entry & kStateFollows) {
+            walls._state[index] = Get<uint8_t>(data, at);
+        }
+        if(entry & kWordsFollow) {
+            const int word = (index / walls._shown.Width()) * wordsPerRow + ((index % walls._shown.Width()) >> 6);
+            game.board_bits.Row(0)[word] = Get<uint64_t>(data, at);
+            walls._shown.Row(0)[word] = Get<uint64_t>(data, at);
+        }
+    }
+
+    GetListDiff(data, at, _lastElements);
+    return popped;
+}
+
+uint64_t Rewind::Seek(uint64_t ticks)
+{
+    if(_count == 0) return 0;
+    TRACE_SPAN("Rewind");
+
+    Game &game = _game;
+    Snake &snake = game.snake;
+    WallLayer &walls = game._walls;
+    const uint64_t oldest = Slot(0).tick;
+    const uint64_t target = (_tick - oldest > ticks) ? _tick - ticks : oldest;
+    int k = _count - 1;
+    while(Slot(k).tick > target) --k;
+    Keyframe &key = Slot(k);
+
+    // stop the bomb fuses and take every power-up back, the ones out at the target are put out again below
+    game._pool.Recycle();
+    game._events.Drain([](const GameEvent &) { });
+    game._appearing.clear();
+    game._litBombs.clear();
+    game._particles.Clear();
+
+    // the keyframe goes straight back into the game, then the ticks after it are replayed on top
+    std::copy(key.board.begin(), key.board.end(), game.board_bits.Row(0));
+    std::copy(key.shown.begin(), key.shown.end(), walls._shown.Row(0));
+    std::copy(key.wallStates.begin(), key.wallStates.end(), walls._state.begin());
+    snake.body.clear();
+    for(uint32_t cell : key.body) {
+        snake.body.push_back(UnpackCell(cell));
+    }
+    _lastElements.assign(key.elements.begin(), key.elements.end());
+    Scalars scalars = key.scalars;
+
+    std::size_t at = 0;
+    uint64_t popped = 0;
+    for(uint64_t tick = key.tick; tick < target; ++tick) {
+        popped += ReplayDelta(key, at, scalars);
+    }
+    snake.body.erase(snake.body.begin(), snake.body.begin() + popped);
+
+    // the ticks after the target are gone, the next one recorded follows it
+    key.used = at;
+    key.ticks = target - key.tick;
+    _count = k + 1;
+    const uint64_t back = _tick - target;
+    _tick = target;
+
+    Apply(scalars);
+    std::copy(game.board_bits.Data(), game.board_bits.Data() + game.board_bits.WordCount(), _lastBoard.begin());
+    std::copy(walls._shown.Data(), walls._shown.Data() + walls._shown.WordCount(), _lastShown.begin());
+    std::copy(walls._state.begin(), walls._state.end(), _lastWallStates.begin());
+    _lastScalars = scalars;
+    _lastPushes = snake._bodyPushes;
+    _lastPops = snake._bodyPops;
+
+    // everything changed, the regions and distances start over and the renderer repaints the whole board
+    game._dirty.MarkAll();
+    game._reach.Sync(game._dirty);
+    if (game._distances) game._distances->Sync(game._dirty);
+    DEBUG_LOG("Rewound " << back << " ticks to tick " << target);
+    return back;
+}
+
+void Rewind::Apply(const Scalars &scalars)
+{
+    Game &game = _game;
+    Snake &snake = game.snake;
+    WallLayer &walls = game._walls;
+
+    game._placementRandom = scalars.placementRandom;
+    game._spawnRandom = scalars.spawnRandom;
+    game._wallRandom = scalars.wallRandom;
+    game._roundRandom = scalars.roundRandom;
+    game._local.score = scalars.score;
+    game._local.multiplier = scalars.multiplier;
+    game._local.multiplierTimer = scalars.multiplierTimer;
+    walls._ticks = scalars.wallTicks;
+    walls.Relist();
+
+    snake._headX = scalars.headX;
+    snake._headY = scalars.headY;
+    snake._speed = scalars.speed;
+    snake.direction = static_cast<Snake::Direction>(scalars.direction);
+    if(snake._pData) snake._pData->size = scalars.size;
+    snake._invincibleTimer = scalars.invincibleTimer;
+    snake.head_color = UnpackColor(scalars.headColor);
+    snake.body_color = UnpackColor(scalars.bodyColor);
+    snake.alive = scalars.alive;
+    snake._growing = scalars.growing;
+    snake._shrinking = scalars.shrinking;
+    snake._invincible = scalars.invincible;
+    snake._abilityActive = scalars.abilityActive;
+    snake._occupancy.Clear();
+    for(const SDL_Point &cell : snake.body) {
+        snake._occupancy.Set(cell.x, cell.y);
+    }
+
+    // any element of a type will do, they're only told apart by their state
+    for(int type = 0; type < GameElement::NUM_ELEMENT_TYPES - 1; ++type) {
+        snake._items[type].clear();
+        for(int i = 0; i < scalars.items[type]; ++i) {
+            GameElement *element = game._pool.Acquire(static_cast<GameElement::ElementType>(type));
+            element->SetUnavailable();
+            snake._items[type].push_back(element);
+        }
+    }
+
+    // food first, then the power-ups, the ones the index had last so they end up with their cells
+    game.food._state.store(scalars.foodState, std::memory_order_release);
+    Reindex(&game.food, scalars.foodIndexed);
+    for(int indexed = 0; indexed < 2; ++indexed) {
+        for(const ElementRecord &record : _lastElements) {
+            if(record.indexed != indexed) continue;
+            GameElement *element = game._pool.Acquire(static_cast<GameElement::ElementType>(record.type));
+            element->_state.store(record.state, std::memory_order_release);
+            element->_appearanceTimer = record.appearanceTimer;
+            element->_solid = record.solid != 0;
+            Reindex(element, record.indexed);
+            game.TrackAppearing(element);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+/*
+    file: rewind.h - contains class Rewind, the last stretch of a game kept so it can be wound back, for
+    practice and for seeing how the snake died. Every so often the whole state is copied into a keyframe, and
+    each tick after it is stored as what changed: the body cells pushed onto the head end and how many came
+    off the tail, the board and wall words that changed under the cells the tick marked dirty, the visible
+    power-ups that changed and the counters and random streams that did. The hidden walls are rebuilt from
+    the wall state bytes. All of it is allocated when the Rewind is made: REWIND_KEYFRAMES keyframes, each with
+    room for its share of the window's ticks and for every power-up the pool owns, and once they are all used
+    the oldest one is reused. Only a tick that grows the pool, which allocates anyway, makes room for more. A tick
+    that doesn't fit (a big blast, say) starts the next keyframe early, which shortens the window until it
+    comes round again. Seeking restores the last keyframe before the target and replays the ticks after it.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "game_element.h"
+#include "random.h"
+
+#define REWIND_KEYFRAMES 32         // full copies of the state across the window
+#define REWIND_TICK_BYTES 256       // bytes budgeted per tick, a couple of body cells and dirty words is ~100
+#define REWIND_STEP_SECONDS 3       // how far back each press of the rewind key goes
+
+class Game;
+
+class Rewind {
+ public:
+    // keeps at least seconds of a game updated ticks_per_second times a second
+    Rewind(Game &game, double seconds, double ticks_per_second);
+
+    Rewind(const Rewind&) = delete;
+    Rewind& operator=(const Rewind&) = delete;
+
+    // store the tick the game just finished, called at the end of every update while the dirty cells still
+    // hold what changed in it. A tick with the whole board marked dirty is stored as a keyframe.
+    void Record();
+
+    // put the game back the way it was ticks ago, or as far back as there is, and forget everything after
+    // that. Returns how many ticks it went back. Only call it from the thread that updates the game.
+    uint64_t Seek(uint64_t ticks);
+
+    // how many ticks Seek can go back right now
+    uint64_t Available() const;
+
+    uint64_t TicksFor(double seconds) const;
+
+ private:
+    // everything that isn't a board, a list or a power-up, diffed a 64-bit word at a time
+    struct Scalars {
+        Xoshiro256 placementRandom;
+        Xoshiro256 spawnRandom;
+        Xoshiro256 wallRandom;
+        Xoshiro256 roundRandom;
+        uint64_t foodState;
+        int32_t score;
+        int32_t multiplier;
+        int32_t multiplierTimer;
+        int32_t wallTicks;
+        int32_t headX;
+        int32_t headY;
+        int32_t speed;
+        int32_t direction;
+        int32_t size;
+        int32_t invincibleTimer;
+        uint32_t headColor;
+        uint32_t bodyColor;
+        int32_t items[GameElement::NUM_ELEMENT_TYPES - 1];  // held in the inventory, by type
+        uint8_t alive;
+        uint8_t growing;
+        uint8_t shrinking;
+        uint8_t invincible;
+        uint8_t abilityActive;
+        uint8_t foodIndexed;
+        uint8_t unused[2];
+    };
+    static constexpr int kScalarWords = sizeof(Scalars) / sizeof(uint64_t);
+
+    // a visible power-up, its packed state word as the element holds it. Indexed is whether the spatial
+    // index has it, it only keeps the last element put in a cell.
+    struct ElementRecord {
+        uint64_t state;
+        int32_t appearanceTimer;
+        uint8_t type;
+        uint8_t solid;
+        uint8_t indexed;
+        uint8_t unused;
+    };
+
+    struct Keyframe {
+        uint64_t tick{0};
+        Scalars scalars;
+        std::vector<uint64_t> board;
+        std::vector<uint64_t> shown;
+        std::vector<uint8_t> wallStates;
+        std::vector<uint32_t> body;             // packed cells, tail first
+        std::vector<ElementRecord> elements;
+        std::vector<uint8_t> deltas;            // the ticks after this one, sized once
+        std::size_t used{0};                    // bytes of deltas holding them
+        uint64_t ticks{0};
+    };
+
+    Keyframe& Slot(int i) { return _keyframes[(_first + i) % REWIND_KEYFRAMES]; }
+    const Keyframe& Slot(int i) const { return _keyframes[(_first + i) % REWIND_KEYFRAMES]; }
+
+    static uint8_t Indexed(const Game &game, const GameElement *element);
+    static void Reindex(GameElement *element, bool indexed);
+    Scalars CaptureScalars() const;
+    void ReserveElements(std::size_t count);
+    void CaptureElements(std::vector<ElementRecord> &elements) const;
+    void StoreKeyframe(const Scalars &scalars);
+    bool StoreDelta(Keyframe &key, const Scalars &scalars);
+    uint64_t ReplayDelta(const Keyframe &key, std::size_t &at, Scalars &scalars);
+    void Apply(const Scalars &scalars);
+
+    Game &_game;
+    double _ticksPerSecond;
+    uint64_t _interval;                 // ticks from one keyframe to the next
+    std::vector<Keyframe> _keyframes;   // a ring, _count of them from _first are in use
+    int _first{0};
+    int _count{0};
+    uint64_t _tick{0};                  // the tick last recorded
+
+    // the last tick recorded, for the next one to be diffed against
+    Scalars _lastScalars;
+    uint64_t _lastPushes{0};
+    uint64_t _lastPops{0};
+    std::vector<uint64_t> _lastBoard;
+    std::vector<uint64_t> _lastShown;
+    std::vector<uint8_t> _lastWallStates;
+    std::vector<ElementRecord> _lastElements;
+    std::vector<ElementRecord> _elements;   // this tick's, gathered before they're compared
+};
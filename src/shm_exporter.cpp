@@ -0,0 +1,117 @@
+#include "shm_exporter.h"
+#include <iostream>
+#include <new>
+
+#ifdef SHM_EXPORT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+ShmExporter::ShmExporter()
+{
+}
+
+ShmExporter::~ShmExporter()
+{
+    Close();
+}
+
+bool ShmExporter::Open(int grid_width, int grid_height, int words_per_row, int plane_words, const char *name)
+{
+#ifdef SHM_EXPORT
+    Close();
+
+    int max_cells = grid_width * grid_height;
+    if(max_cells > SHM_MAX_CELLS) max_cells = SHM_MAX_CELLS;
+
+    ShmHeader layout;
+    layout.slotBytes = ShmSlotBytes(plane_words, NUM_BOARD_PLANES, max_cells);
+    layout.ringSlots = SHM_RING_SLOTS;
+    uint64_t bytes = ShmRegionBytes(layout);
+
+    // start from a fresh region so a reader of an old game can't mix the two up
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0) {
+        std::cerr << "Shared memory " << name << " could not be created.\n";
+        return false;
+    }
+    if(ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        std::cerr << "Shared memory " << name << " could not be sized.\n";
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        std::cerr << "Shared memory " << name << " could not be mapped.\n";
+        shm_unlink(name);
+        return false;
+    }
+
+    // the new region is zero filled, so every slot starts with seq 0 (no tick)
+    _base = static_cast<unsigned char*>(base);
+    _bytes = bytes;
+    _name = name;
+    _header = new (_base) ShmHeader;
+    _header->version = SHM_VERSION;
+    _header->gridWidth = grid_width;
+    _header->gridHeight = grid_height;
+    _header->wordsPerRow = words_per_row;
+    _header->planeWords = plane_words;
+    _header->numPlanes = NUM_BOARD_PLANES;
+    _header->ringSlots = SHM_RING_SLOTS;
+    _header->maxCells = max_cells;
+    _header->slotBytes = layout.slotBytes;
+    _header->latestTick.store(0, std::memory_order_relaxed);
+    for(int i = 0; i < SHM_RING_SLOTS; ++i) {
+        ShmSlotHeader *slot = new (_base + ShmSlotOffset(*_header, i)) ShmSlotHeader;
+        slot->seq.store(0, std::memory_order_relaxed);
+    }
+
+    // publish the magic last, readers wait for it before trusting anything else in the header
+    _header->magic.store(SHM_MAGIC, std::memory_order_release);
+
+    std::cout << "Exporting game state to shared memory " << name << " (" << bytes << " bytes)" << std::endl;
+    return true;
+#else
+    (void)grid_width; (void)grid_height; (void)words_per_row; (void)plane_words; (void)name;
+    return false;
+#endif
+}
+
+ShmExporter::Slot ShmExporter::BeginWrite(uint64_t tick)
+{
+    unsigned char *slot = _base + ShmSlotOffset(*_header, static_cast<int>(tick % SHM_RING_SLOTS));
+    ShmSlotHeader *header = reinterpret_cast<ShmSlotHeader*>(slot);
+
+    // odd: a reader that sees this (or sees it change while copying) throws its copy away
+    header->seq.store(2 * tick - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t *planes = reinterpret_cast<uint64_t*>(slot + sizeof(ShmSlotHeader));
+    ShmCell *cells = reinterpret_cast<ShmCell*>(planes + static_cast<uint64_t>(_header->planeWords) * _header->numPlanes);
+    return {header, planes, cells, _header->maxCells};
+}
+
+void ShmExporter::EndWrite(const Slot &slot, uint64_t tick)
+{
+    slot.header->seq.store(2 * tick, std::memory_order_release);
+    _header->latestTick.store(tick, std::memory_order_release);
+}
+
+void ShmExporter::Close()
+{
+#ifdef SHM_EXPORT
+    if(_base != nullptr) {
+        munmap(_base, _bytes);
+        shm_unlink(_name.c_str());
+    }
+#endif
+    _base = nullptr;
+    _header = nullptr;
+    _bytes = 0;
+}
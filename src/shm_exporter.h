@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+    file: shm_exporter.h - contains class ShmExporter, which publishes each tick's state into the POSIX shared
+    memory ring described in shm_layout.h. Setting the region up takes a few syscalls, but publishing a tick
+    is only memory writes. Built in with the SHM_EXPORT option, otherwise Open always fails and nothing is
+    exported.
+*/
+
+#include <cstdint>
+#include <string>
+#include "shm_layout.h"
+
+class ShmExporter {
+ public:
+    struct Slot {
+        ShmSlotHeader *header;
+        uint64_t *planes;
+        ShmCell *cells;
+        int maxCells;
+    };
+
+    ShmExporter();
+    ~ShmExporter();
+
+    // create (or replace) the shared memory region for a board of this size
+    bool Open(int grid_width, int grid_height, int words_per_row, int plane_words, const char *name = SHM_EXPORT_NAME);
+    bool IsOpen() const { return _base != nullptr; }
+
+    // mark the tick's slot as being written and return where its data goes, then fill it in and EndWrite
+    Slot BeginWrite(uint64_t tick);
+    void EndWrite(const Slot &slot, uint64_t tick);
+
+ private:
+    void Close();
+
+    unsigned char *_base{nullptr};
+    uint64_t _bytes{0};
+    ShmHeader *_header{nullptr};
+    std::string _name;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+    file: shm_layout.h - the layout of the shared memory the game exports its state into, shared by the
+    exporter (shm_exporter.h) and the reader library (shm_reader.h).
+
+    The region starts with a ShmHeader, followed by SHM_RING_SLOTS slots of header.slotBytes each. Every tick
+    is written into slot (tick % SHM_RING_SLOTS). Each slot is guarded by a sequence number (a seqlock): the
+    writer makes it odd before writing and even (2 * tick) afterwards, and a reader copies the slot out and
+    only trusts the copy if the sequence number was the same even value before and after. Readers never
+    block the writer, and a reader that falls fewer than SHM_RING_SLOTS ticks behind can still read every tick.
+
+    A slot holds a ShmSlotHeader, then header.numPlanes bitplanes of header.planeWords words each (see
+    board_planes.h), then up to header.maxCells ShmCell entries for the snake, head first.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include "board_planes.h"
+
+#define SHM_EXPORT_NAME "/snake_game_state"
+#define SHM_MAGIC 0x4B414E53u       // "SNAK"
+#define SHM_VERSION 1u
+#define SHM_RING_SLOTS 8
+#define SHM_MAX_CELLS 65536         // snake cells exported per tick, the body plane always has all of them
+
+struct ShmCell {
+    int32_t x;
+    int32_t y;
+};
+
+struct ShmHeader {
+    std::atomic<uint32_t> magic;    // written last by the exporter, once everything else is set up
+    uint32_t version;
+    int32_t gridWidth;
+    int32_t gridHeight;
+    int32_t wordsPerRow;
+    int32_t planeWords;
+    int32_t numPlanes;
+    int32_t ringSlots;
+    int32_t maxCells;
+    uint64_t slotBytes;
+    std::atomic<uint64_t> latestTick;  // newest complete tick, 0 before the first one
+};
+
+// the per-tick values, plain data so readers can copy it out
+struct ShmTickInfo {
+    uint64_t tick;
+    int32_t score;
+    int32_t multiplier;
+    int32_t multiplierTimer;
+    int32_t size;
+    int32_t alive;
+    int32_t cellCount;      // snake cells in this slot (head first), at most maxCells
+    int32_t fps;            // render frame stats over the last second
+    int32_t frameUs;
+    int32_t jitterUs;
+    int32_t tickUs;         // how long this tick's update took
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> seq;      // odd while being written, 2 * tick once complete
+    ShmTickInfo info;
+};
+
+// everything in the header and slot headers has to be readable from another process without a lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory export needs lock-free 64 bit atomics");
+
+inline uint64_t ShmSlotBytes(int planeWords, int numPlanes, int maxCells)
+{
+    uint64_t bytes = sizeof(ShmSlotHeader) + sizeof(uint64_t) * static_cast<uint64_t>(planeWords) * numPlanes +
+                     sizeof(ShmCell) * static_cast<uint64_t>(maxCells);
+    return (bytes + 63) & ~uint64_t{63};    // keep slots on their own cache lines
+}
+
+inline uint64_t ShmRegionBytes(const ShmHeader &header)
+{
+    return ((sizeof(ShmHeader) + 63) & ~uint64_t{63}) + header.slotBytes * header.ringSlots;
+}
+
+inline uint64_t ShmSlotOffset(const ShmHeader &header, int slot)
+{
+    return ((sizeof(ShmHeader) + 63) & ~uint64_t{63}) + header.slotBytes * slot;
+}
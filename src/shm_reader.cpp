@@ -0,0 +1,134 @@
+#include "shm_reader.h"
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_READ_RETRIES 16     // copies of a slot tried before giving up on a tick being rewritten
+
+ShmReader::ShmReader()
+{
+}
+
+ShmReader::~ShmReader()
+{
+    Close();
+}
+
+bool ShmReader::Open(const char *name)
+{
+    Close();
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if(fd < 0) {
+        return false;
+    }
+
+    // the exporter sizes the region before writing anything into it, so a short region isn't ready yet
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(ShmHeader)) {
+        close(fd);
+        return false;
+    }
+    uint64_t bytes = static_cast<uint64_t>(st.st_size);
+    void *base = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        return false;
+    }
+
+    const ShmHeader *header = static_cast<const ShmHeader*>(base);
+    if(header->magic.load(std::memory_order_acquire) != SHM_MAGIC) {
+        // not set up yet (or not ours)
+        munmap(base, bytes);
+        return false;
+    }
+    if(header->version != SHM_VERSION || header->numPlanes != NUM_BOARD_PLANES || ShmRegionBytes(*header) > bytes) {
+        std::cerr << "Shared memory " << name << " has version " << header->version << ", expected " << SHM_VERSION << ".\n";
+        munmap(base, bytes);
+        return false;
+    }
+
+    _base = static_cast<const unsigned char*>(base);
+    _bytes = bytes;
+    _header = header;
+    return true;
+}
+
+void ShmReader::Close()
+{
+    if(_base != nullptr) {
+        munmap(const_cast<unsigned char*>(_base), _bytes);
+    }
+    _base = nullptr;
+    _header = nullptr;
+    _bytes = 0;
+}
+
+uint64_t ShmReader::LatestTick() const
+{
+    return _header->latestTick.load(std::memory_order_acquire);
+}
+
+void ShmReader::InitFrame(ShmFrame &frame) const
+{
+    frame.wordsPerRow = _header->wordsPerRow;
+    frame.planeWords = _header->planeWords;
+    frame.planes.assign(static_cast<std::size_t>(_header->planeWords) * _header->numPlanes, 0);
+    frame.cells.assign(_header->maxCells, ShmCell{0, 0});
+    frame.info = ShmTickInfo{};
+}
+
+ShmReader::ReadResult ShmReader::Read(uint64_t tick, ShmFrame &frame)
+{
+    if(tick == 0) {
+        return ReadResult::kNotReady;
+    }
+
+    const unsigned char *slot = _base + ShmSlotOffset(*_header, static_cast<int>(tick % _header->ringSlots));
+    const ShmSlotHeader *header = reinterpret_cast<const ShmSlotHeader*>(slot);
+    const uint64_t *planes = reinterpret_cast<const uint64_t*>(slot + sizeof(ShmSlotHeader));
+    const ShmCell *cells = reinterpret_cast<const ShmCell*>(planes + frame.planes.size());
+    const uint64_t expected = 2 * tick;
+
+    for(int attempt = 0; attempt < SHM_READ_RETRIES; ++attempt) {
+        uint64_t before = header->seq.load(std::memory_order_acquire);
+        if(before > expected) {
+            return ReadResult::kOverwritten;
+        }
+        if(before < expected - 1) {
+            return ReadResult::kNotReady;
+        }
+        if(before == expected - 1) {
+            // being written right now, it will be done within a tick
+            ++_tornReads;
+            continue;
+        }
+
+        std::memcpy(&frame.info, &header->info, sizeof(ShmTickInfo));
+        std::memcpy(frame.planes.data(), planes, frame.planes.size() * sizeof(uint64_t));
+        int count = frame.info.cellCount;
+        if(count < 0 || count > static_cast<int>(frame.cells.size())) count = 0;
+        std::memcpy(frame.cells.data(), cells, count * sizeof(ShmCell));
+
+        // the copy only counts if nothing started rewriting the slot while it was being made
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = header->seq.load(std::memory_order_relaxed);
+        if(after == expected) {
+            frame.info.cellCount = count;
+            return ReadResult::kOk;
+        }
+        if(after > expected) {
+            return ReadResult::kOverwritten;
+        }
+        ++_tornReads;
+    }
+    return ReadResult::kNotReady;
+}
+
+ShmReader::ReadResult ShmReader::ReadLatest(ShmFrame &frame)
+{
+    return Read(LatestTick(), frame);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+    file: shm_reader.h - contains class ShmReader, the reader side of the shared memory export, for tools that
+    watch or record a running game from another process. Reading never blocks the game: a slot that changes
+    while it is being copied is copied again, and a tick that has already been overwritten is reported as such.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "shm_layout.h"
+
+// one tick copied out of shared memory, the vectors are sized once when the reader is opened
+struct ShmFrame {
+    ShmTickInfo info;
+    std::vector<uint64_t> planes;   // numPlanes planes of planeWords words, see board_planes.h
+    std::vector<ShmCell> cells;     // info.cellCount of these are valid, head first
+    int wordsPerRow{0};
+    int planeWords{0};
+
+    bool Test(BoardPlane plane, int x, int y) const {
+        return (planes[plane * planeWords + y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+};
+
+class ShmReader {
+ public:
+    enum class ReadResult {
+        kOk,
+        kNotReady,      // the tick hasn't been written yet
+        kOverwritten,   // the reader fell more than SHM_RING_SLOTS ticks behind and the tick is gone
+    };
+
+    ShmReader();
+    ~ShmReader();
+
+    // map an exported region read only, false if there is none or it's from an incompatible version
+    bool Open(const char *name = SHM_EXPORT_NAME);
+    void Close();
+    bool IsOpen() const { return _header != nullptr; }
+
+    const ShmHeader &Header() const { return *_header; }
+    uint64_t LatestTick() const;
+
+    // size the frame's buffers for this region, done once so reading doesn't allocate
+    void InitFrame(ShmFrame &frame) const;
+
+    ReadResult Read(uint64_t tick, ShmFrame &frame);
+    ReadResult ReadLatest(ShmFrame &frame);
+
+    // copies thrown away because the game was writing the slot at the same time
+    uint64_t TornReads() const { return _tornReads; }
+
+ private:
+    const unsigned char *_base{nullptr};
+    uint64_t _bytes{0};
+    const ShmHeader *_header{nullptr};
+    uint64_t _tornReads{0};
+};
@@ -1,17 +1,26 @@
 #include "snake.h"
-#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include "debug_log.h"
 
 Snake::Snake(int grid_width, int grid_height)
-      : grid_width(grid_width),
+      : head_color(liveSnakeHeadColor), body_color(liveSnakeBodyColor),
+        grid_width(grid_width),
         grid_height(grid_height),
-        head_x(grid_width / 2),
-        head_y(grid_height / 2),
-        head_color(liveSnakeHeadColor), body_color(liveSnakeBodyColor),
-        _items(GameElement::NUM_ELEMENT_TYPES-1, std::vector<std::shared_ptr<GameElement>>()),
+        _headX((grid_width / 2) << FIXED_SHIFT),
+        _headY((grid_height / 2) << FIXED_SHIFT),
+        _fixedWidth(grid_width << FIXED_SHIFT),
+        _fixedHeight(grid_height << FIXED_SHIFT),
+        _items(GameElement::NUM_ELEMENT_TYPES-1, std::vector<GameElement*>()),
+        _occupancy(grid_width, grid_height),
         _pData(new SnakeData())
 {
+  // room for a typical inventory so picking items up doesn't allocate
+  for(auto &items : _items) {
+    items.reserve(DEFAULT_INVENTORY_SIZE);
+  }
+  body.reserve(std::min(grid_width * grid_height, MAX_BODY_RESERVE));
 }
 
 Snake::~Snake()
@@ -22,22 +31,7 @@ Snake::~Snake()
   }
 }
 
-void Snake::Update() {
-  SDL_Point prev_cell{
-      static_cast<int>(head_x),
-      static_cast<int>(
-          head_y)};  // We first capture the head's cell before updating.
-  UpdateHead();
-  SDL_Point current_cell{
-      static_cast<int>(head_x),
-      static_cast<int>(head_y)};  // Capture the head's cell after updating.
-
-  // Update all of the body vector items if the snake head has moved to a new
-  // cell.
-  if (current_cell.x != prev_cell.x || current_cell.y != prev_cell.y) {
-    UpdateBody(current_cell, prev_cell);
-  }
-
+void Snake::UpdateInvincibility() {
   if(_invincible) {
     if(_invincibleTimer > 0) {
       _invincibleTimer--;
@@ -46,6 +40,7 @@ void Snake::Update() {
         if(_invincibleTimer % (DEFAULT_INVINCIBLE_TIMER/16) == 0) {
           head_color = (head_color == liveSnakeHeadColor) ? invincibleSnakeHeadColor : liveSnakeHeadColor;
           body_color = (body_color == liveSnakeBodyColor) ? invincibleSnakeBodyColor : liveSnakeBodyColor;
+          MarkRecolored();
         }
       }
     } else {
@@ -53,56 +48,171 @@ void Snake::Update() {
       _invincible = false;
       body_color = liveSnakeBodyColor;
       head_color = liveSnakeHeadColor;
+      MarkRecolored();
       _abilityActive = false;
     }
   }
 }
 
-void Snake::UpdateHead() {
+// Move the head's position within its cell by this tick's speed and return how many cell
+// boundaries that crosses. The head stays in its current cell, StepCell moves it across them.
+int Snake::AdvanceHead() {
+  const bool vertical = (direction == Direction::kUp || direction == Direction::kDown);
+  const bool backwards = (direction == Direction::kUp || direction == Direction::kLeft);
+  int32_t &pos = vertical ? _headY : _headX;
+  int32_t target = backwards ? (pos - _speed) : (pos + _speed);
+
+  int crossed = std::abs((target >> FIXED_SHIFT) - (pos >> FIXED_SHIFT));
+
+  // keep the cell, take the position inside the cell from where the head ends up
+  pos = (pos & ~(FIXED_ONE - 1)) | (target & (FIXED_ONE - 1));
+  return crossed;
+}
+
+// Move the head one cell in the current direction and drag the body along behind it.
+void Snake::StepCell() {
+  SDL_Point prev_cell{HeadX(), HeadY()};  // We first capture the head's cell before updating.
+
   switch (direction) {
     case Direction::kUp:
-      head_y -= speed;
+      _headY -= FIXED_ONE;
       break;
 
     case Direction::kDown:
-      head_y += speed;
+      _headY += FIXED_ONE;
       break;
 
     case Direction::kLeft:
-      head_x -= speed;
+      _headX -= FIXED_ONE;
       break;
 
     case Direction::kRight:
-      head_x += speed;
+      _headX += FIXED_ONE;
       break;
   }
 
   // Wrap the Snake around to the beginning if going off of the screen.
-  head_x = fmod(head_x + grid_width, grid_width);
-  head_y = fmod(head_y + grid_height, grid_height);
+  // The head only ever moves one cell, so one compare and add/subtract is enough.
+  if (_headX < 0) {
+    _headX += _fixedWidth;
+  } else if (_headX >= _fixedWidth) {
+    _headX -= _fixedWidth;
+  }
+  if (_headY < 0) {
+    _headY += _fixedHeight;
+  } else if (_headY >= _fixedHeight) {
+    _headY -= _fixedHeight;
+  }
+
+  SDL_Point current_cell{HeadX(), HeadY()};  // Capture the head's cell after updating.
+  MarkDirty(prev_cell.x, prev_cell.y);
+  MarkDirty(current_cell.x, current_cell.y);
+  UpdateBody(current_cell, prev_cell);
+}
+
+void Snake::AddSpeed(int32_t delta)
+{
+  // the head can cross many cells in one tick, but never the whole board
+  int32_t max_speed = std::min(_fixedWidth, _fixedHeight) - 1;
+  _speed = std::max(0, std::min(_speed + delta, max_speed));
+}
+
+void Snake::Reset()
+{
+  Reset(grid_width / 2, grid_height / 2);
+}
+
+void Snake::Reset(int x, int y)
+{
+  _headX = x << FIXED_SHIFT;
+  _headY = y << FIXED_SHIFT;
+  direction = Direction::kUp;
+  _speed = DEFAULT_SPEED;
+  alive = true;
+  _growing = false;
+  _shrinking = false;
+  _invincible = false;
+  _invincibleTimer = DEFAULT_INVINCIBLE_TIMER;
+  _abilityActive = false;
+  head_color = liveSnakeHeadColor;
+  body_color = liveSnakeBodyColor;
+  MarkRecolored();
+
+  _bodyPops += body.size();
+  body.clear();
+  _occupancy.Clear();
+  for(auto &items : _items) {
+    items.clear();
+  }
+  *_pData = SnakeData();
+}
+
+void Snake::ReleaseItems()
+{
+  for(auto &items : _items) {
+    for(GameElement *item : items) {
+      item->SetAvailable();
+    }
+    items.clear();
+  }
+}
+
+void Snake::Restore(int32_t head_x, int32_t head_y, Direction dir, int32_t speed,
+                    const SDL_Point *body_cells, int body_count, bool is_alive)
+{
+  _headX = head_x;
+  _headY = head_y;
+  direction = dir;
+  _speed = speed;
+  alive = is_alive;
+  _growing = false;
+  _shrinking = false;
+
+  _bodyPops += body.size();
+  _bodyPushes += body_count;
+  body.assign(body_cells, body_cells + body_count);
+  _occupancy.Clear();
+  for (const SDL_Point &cell : body) {
+    if (_occupancy.InBounds(cell.x, cell.y)) _occupancy.Set(cell.x, cell.y);
+  }
+  if(_pData) {
+    _pData->size = body_count + 1;
+  }
 }
 
 void Snake::UpdateBody(SDL_Point &current_head_cell, SDL_Point &prev_head_cell) {
   // Add previous head location to vector
   body.push_back(prev_head_cell);
+  _occupancy.Set(prev_head_cell.x, prev_head_cell.y);
+  ++_bodyPushes;
 
   if (!_growing) {
     if(_shrinking) {
-      std::cout << "Shrinking body" << std::endl;
+      DEBUG_LOG("Shrinking body");
       _shrinking = false;
       _abilityActive = false;
 
       // Remove half of the body from the vector.
-      body.erase(body.begin(), body.begin() + ((body.size()/2) - 1));
+      std::size_t removed = (body.size() >= 2) ? (body.size()/2) - 1 : 0;
+      auto new_tail = body.begin() + removed;
+      for(auto it = body.begin(); it != new_tail; ++it) {
+        _occupancy.Reset(it->x, it->y);
+        MarkDirty(it->x, it->y);
+      }
+      body.erase(body.begin(), new_tail);
+      _bodyPops += removed;
       if(_pData) {
         _pData->size = body.size() + 1;
       }
     } else {
       // Remove the tail from the vector.
+      _occupancy.Reset(body.front().x, body.front().y);
+      MarkDirty(body.front().x, body.front().y);
       body.erase(body.begin());
+      ++_bodyPops;
     }
   } else {
-    std::cout << "Growing body" << std::endl;
+    DEBUG_LOG("Growing body");
     _growing = false;
     if(_pData) {
       _pData->size++;
@@ -110,24 +220,27 @@ void Snake::UpdateBody(SDL_Point &current_head_cell, SDL_Point &prev_head_cell)
   }
 
   // Check if the snake has died.
-  for (auto const &item : body) {
-    if (current_head_cell.x == item.x && current_head_cell.y == item.y) {
-      KillSnake();
-    }
+  if (_occupancy.Test(current_head_cell.x, current_head_cell.y)) {
+    KillSnake();
   }
 }
 
 void Snake::KillSnake()
 {
+  if(alive && _events) {
+    _events->Push(GameEventType::kSnakeDied, {HeadX(), HeadY()}, nullptr, GameElement::UNKNOWN_TYPE, 0, _player);
+  }
   alive = false;
   body_color = deadSnakeBodyColor;
   head_color = deadSnakeHeadColor;
+  MarkRecolored();
 }
 
 void Snake::MakeInvincible()
 {
   head_color = invincibleSnakeHeadColor;
   body_color = invincibleSnakeBodyColor;
+  MarkRecolored();
   _invincible = true;
   // _abilityActive will be set false after invincibility wears off in Update()
 }
@@ -136,28 +249,23 @@ void Snake::GrowBody() { _growing = true; }
 
 void Snake::ShrinkBody()
 {
-  std::cout << "Shrinking snake" << std::endl;
+  DEBUG_LOG("Shrinking snake");
   _shrinking = true;
   _abilityActive = false;
 }
 
-// Inefficient method to check if cell is occupied by snake.
-bool Snake::SnakeCell(int x, int y) {
-  if (x == static_cast<int>(head_x) && y == static_cast<int>(head_y)) {
+// Check if cell is occupied by snake, the body is looked up in the occupancy bits.
+bool Snake::SnakeCell(int x, int y) const {
+  if (x == HeadX() && y == HeadY()) {
     return true;
   }
-  for (auto const &item : body) {
-    if (x == item.x && y == item.y) {
-      return true;
-    }
-  }
-  return false;
+  return _occupancy.InBounds(x, y) && _occupancy.Test(x, y);
 }
 
 void Snake::SlowSnake()
 {
-  std::cout << "Slowing snake" << std::endl;
-  speed = DEFAULT_SPEED;
+  DEBUG_LOG("Slowing snake");
+  _speed = DEFAULT_SPEED;
   _abilityActive = false;
 }
 
@@ -170,16 +278,16 @@ void Snake::UseElement(GameElement::ElementType type)
     // don't make potions or pills visible, they just get used
     if(type == GameElement::POTION) {
       _abilityActive = true;
-      std::cout << "Potion used" << std::endl;
+      DEBUG_LOG("Potion used");
     } else if(type == GameElement::SHRINK_PILL) {
       _abilityActive = true;
-      std::cout << "Shrink Pill used" << std::endl;
+      DEBUG_LOG("Shrink Pill used");
     } else if(type == GameElement::SLOW_PILL) {
       _abilityActive = true;
-      std::cout << "Slow Pill used" << std::endl;
+      DEBUG_LOG("Slow Pill used");
     } else if(type == GameElement::BOMB) {
-      e->SetLocation(head_x, head_y);
-      std::cout << GameElement::GetElementTypeString(type) << " (" << e->_id << ") placed at " << (int)head_x << ", " << (int)head_y << std::endl;
+      e->SetLocation(HeadX(), HeadY());
+      DEBUG_LOG(GameElement::GetElementTypeString(type) << " (" << e->_id << ") placed at " << HeadX() << ", " << HeadY());
     }
 
     // use the item's callback to trigger an action, if one is set
@@ -190,40 +298,40 @@ void Snake::UseElement(GameElement::ElementType type)
   }
 }
 
-void Snake::AddPotion(std::shared_ptr<Potion> &potion)
+void Snake::AddPotion(Potion *potion)
 {
   potion->Hide();
   potion->SetUnavailable();
-  potion->SetUseCallbackFn(std::bind(&Snake::MakeInvincible, this));
+  potion->SetOwner(_player);
   _items.at(GameElement::POTION).emplace_back(potion);
-  std::cout << potion->GetElementTypeString() << " (" << potion->_id << ") picked up from " << (int)head_x << ", " << (int)head_y << std::endl;
+  DEBUG_LOG(potion->GetElementTypeString() << " (" << potion->_id << ") picked up from " << HeadX() << ", " << HeadY());
 }
 
-void Snake::AddBomb(std::shared_ptr<Bomb> &bomb)
+void Snake::AddBomb(Bomb *bomb)
 {
   bomb->Hide();
   bomb->SetUnavailable();
-  // callback was set in Game
+  bomb->SetOwner(_player);
   _items.at(GameElement::BOMB).emplace_back(bomb);
-  std::cout << bomb->GetElementTypeString() << " (" << bomb->_id << ") picked up from " << (int)head_x << ", " << (int)head_y << std::endl;
+  DEBUG_LOG(bomb->GetElementTypeString() << " (" << bomb->_id << ") picked up from " << HeadX() << ", " << HeadY());
 }
 
-void Snake::AddShrinkPill(std::shared_ptr<ShrinkPill> &pill)
+void Snake::AddShrinkPill(ShrinkPill *pill)
 {
   pill->Hide();
   pill->SetUnavailable();
-  pill->SetUseCallbackFn(std::bind(&Snake::ShrinkBody, this));
+  pill->SetOwner(_player);
   _items.at(GameElement::SHRINK_PILL).emplace_back(pill);
-  std::cout << pill->GetElementTypeString() << " (" << pill->_id << ") picked up from " << (int)head_x << ", " << (int)head_y << std::endl;
+  DEBUG_LOG(pill->GetElementTypeString() << " (" << pill->_id << ") picked up from " << HeadX() << ", " << HeadY());
 }
 
-void Snake::AddSlowPill(std::shared_ptr<SlowPill> &pill)
+void Snake::AddSlowPill(SlowPill *pill)
 {
   pill->Hide();
   pill->SetUnavailable();
-  pill->SetUseCallbackFn(std::bind(&Snake::SlowSnake, this));
+  pill->SetOwner(_player);
   _items.at(GameElement::SLOW_PILL).emplace_back(pill);
-  std::cout << pill->GetElementTypeString() << " (" << pill->_id << ") picked up from " << (int)head_x << ", " << (int)head_y << std::endl;
+  DEBUG_LOG(pill->GetElementTypeString() << " (" << pill->_id << ") picked up from " << HeadX() << ", " << HeadY());
 }
 
 void Snake::UsePotion()
@@ -3,14 +3,24 @@
 
 #include <vector>
 #include <memory>
-#include <functional>
 #include "SDL.h"
 #include "color.h"
 #include "game_element.h"
 #include "color_defines.h"
+#include "bitboard.h"
+#include "event_queue.h"
+#include "dirty_cells.h"
 
 #define DEFAULT_INVINCIBLE_TIMER 512
-#define DEFAULT_SPEED 0.1f
+
+// positions and speeds are fixed-point, FIXED_ONE sub-cell units make up one cell
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_CELLS(n, d) (((FIXED_ONE * (n)) + ((d) / 2)) / (d))   // n/d of a cell, rounded
+
+#define DEFAULT_SPEED FIXED_CELLS(1, 10)   // cells per tick
+#define DEFAULT_INVENTORY_SIZE 16
+#define MAX_BODY_RESERVE 65536    // body cells reserved up front, growing past this allocates
 
 struct SnakeData {
   int size{1};
@@ -20,6 +30,8 @@ struct SnakeData {
   int slowpills{0};
 };
 
+class Rewind;
+
 class Snake {
  public:
   enum class Direction { kUp, kDown, kLeft, kRight };
@@ -27,11 +39,24 @@ class Snake {
   Snake(int grid_width, int grid_height);
   ~Snake();
 
-  void Update();
+  // Move the snake for this tick. At high speed the head crosses several cells in one tick, so it is
+  // stepped through every one of them and enteredCell(x, y) is called for each, letting the caller check
+  // collisions cell by cell. Stepping stops early if the snake dies.
+  template <typename Fn>
+  void Update(Fn enteredCell)
+  {
+    int cells = AdvanceHead();
+    for (int i = 0; i < cells && alive; ++i) {
+      StepCell();
+      if (alive) enteredCell(HeadX(), HeadY());
+    }
+    UpdateInvincibility();
+  }
+  void Update() { Update([](int, int) { }); }
 
   // game action functions
   void GrowBody();
-  bool SnakeCell(int x, int y);
+  bool SnakeCell(int x, int y) const;
   void KillSnake();
   
   // element action functions
@@ -40,10 +65,10 @@ class Snake {
   void SlowSnake();
 
   // add element functions  
-  void AddPotion(std::shared_ptr<Potion> &potion);
-  void AddBomb(std::shared_ptr<Bomb> &bomb);
-  void AddShrinkPill(std::shared_ptr<ShrinkPill> &pill);
-  void AddSlowPill(std::shared_ptr<SlowPill> &pill);
+  void AddPotion(Potion *potion);
+  void AddBomb(Bomb *bomb);
+  void AddShrinkPill(ShrinkPill *pill);
+  void AddSlowPill(SlowPill *pill);
 
   // element tests
   bool HasPotion() { return (_items.at(GameElement::POTION).size() > 0); }
@@ -73,33 +98,86 @@ class Snake {
   void UpdateData();
   SnakeData* GetData();
 
+  // the queue the snake reports its death to
+  void SetEventQueue(EventQueue *events) { _events = events; }
+
+  // the player the snake belongs to, named in its death and in the use of every item it picks up
+  void SetPlayer(int player) { _player = player; }
+  int PlayerId() const { return _player; }
+
+  // the cells the snake moves through or recolors are marked here for the incremental renderer
+  void SetDirtyCells(DirtyCells *dirty) { _dirty = dirty; }
+
+  // one bit per cell covered by the body (not the head)
+  const BitBoard& GetOccupancy() const { return _occupancy; }
+
+  // the cell the head is in
+  int HeadX() const { return _headX >> FIXED_SHIFT; }
+  int HeadY() const { return _headY >> FIXED_SHIFT; }
+
+  // the head position in sub-cell units
+  int32_t FixedHeadX() const { return _headX; }
+  int32_t FixedHeadY() const { return _headY; }
+
+  // back to a new snake in the middle of the board (or with its head at x, y), keeping the memory of the
+  // body and inventory
+  void Reset();
+  void Reset(int x, int y);
+
+  // put every item the snake carries back in its pool, for a snake that's leaving the board mid-game
+  void ReleaseItems();
+
+  // put the snake exactly where the server says it is, for client-side prediction. body is tail first.
+  void Restore(int32_t head_x, int32_t head_y, Direction dir, int32_t speed,
+               const SDL_Point *body_cells, int body_count, bool is_alive);
+
+  // speed in sub-cell units per tick, kept between 0 and just under the size of the board (it can be more than a cell)
+  int32_t GetSpeed() const { return _speed; }
+  void AddSpeed(int32_t delta);
+
   Direction direction = Direction::kUp;
 
-  float speed{DEFAULT_SPEED};
   bool alive{true};
-  float head_x;
-  float head_y;
   std::vector<SDL_Point> body;
 
   Color head_color;
   Color body_color;
 
  private:
-  void UpdateHead();
+  friend class Rewind;    // records the body by what came on and off its ends, and puts all of it back
+
+  int AdvanceHead();
+  void StepCell();
+  void UpdateInvincibility();
   void UpdateBody(SDL_Point &current_cell, SDL_Point &prev_cell);
 
   void UseElement(GameElement::ElementType type);
+  void MarkDirty(int x, int y) { if(_dirty) _dirty->Mark(x, y); }
+  void MarkRecolored() { if(_dirty) _dirty->MarkSnakeRecolored(); }
 
   bool _growing{false};
   bool _shrinking{false};
+  uint64_t _bodyPushes{0};    // cells ever added to the head end of body, and taken off the tail end
+  uint64_t _bodyPops{0};
   int grid_width;
   int grid_height;
-  std::vector<std::vector<std::shared_ptr<GameElement>>> _items;
+
+  // head position in sub-cell units, wrapped to [0, _fixedWidth) and [0, _fixedHeight)
+  int32_t _headX;
+  int32_t _headY;
+  int32_t _fixedWidth;
+  int32_t _fixedHeight;
+  int32_t _speed{DEFAULT_SPEED};
+  std::vector<std::vector<GameElement*>> _items;  // elements are owned by the game's ElementPool
+  BitBoard _occupancy;
   int _invincibleTimer{DEFAULT_INVINCIBLE_TIMER};
   bool _invincible{false};
   bool _abilityActive{false};
 
   struct SnakeData* _pData;
+  EventQueue *_events{nullptr};
+  DirtyCells *_dirty{nullptr};
+  int _player{0};
 
 };
 
@@ -0,0 +1,109 @@
+#include "snake_env.h"
+#include "debug_log.h"
+
+// spread (seed, env, episode) over the whole 64 bit range so neighbouring games don't get related seeds
+static uint64_t MixSeed(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+SnakeEnv::SnakeEnv(int num_envs, int grid_width, int grid_height, int ticks_per_step) :
+    _gridWidth(grid_width),
+    _gridHeight(grid_height),
+    _ticksPerStep(ticks_per_step > 0 ? ticks_per_step : 1),
+    _games(num_envs),
+    _scores(num_envs, 0),
+    _episodes(num_envs, 0)
+{
+    BitBoard layout(grid_width, grid_height);
+    _wordsPerRow = layout.WordsPerRow();
+    _planeWords = static_cast<int>(layout.WordCount());
+
+    // the per-event log would cost more than the games themselves
+    DebugLog::SetEnabled(false);
+}
+
+void SnakeEnv::Reset(uint64_t seed, uint64_t *observations)
+{
+    _seed = seed;
+    for(int i = 0; i < NumEnvs(); ++i) {
+        _episodes[i] = 0;
+        ResetEnv(i);
+        _games[i]->WriteBitplanes(observations + static_cast<std::size_t>(i) * ObservationWords());
+    }
+}
+
+void SnakeEnv::Step(const int *actions, float *rewards, uint8_t *dones, uint64_t *observations)
+{
+    for(int i = 0; i < NumEnvs(); ++i) {
+        Game &game = *_games[i];
+
+        ApplyAction(game, actions[i]);
+        for(int t = 0; t < _ticksPerStep && game.snake.alive; ++t) {
+            game.Update();
+        }
+        // nothing draws these games, so throw the changed cells away instead of letting them pile up
+        game._dirty.Clear();
+
+        int score = game.GetScore();
+        float reward = static_cast<float>(score - _scores[i]);
+        _scores[i] = score;
+
+        bool done = !game.snake.alive;
+        if(done) {
+            reward += ENV_DEATH_REWARD;
+            ResetEnv(i);
+        }
+
+        rewards[i] = reward;
+        dones[i] = done ? 1 : 0;
+        _games[i]->WriteBitplanes(observations + static_cast<std::size_t>(i) * ObservationWords());
+    }
+}
+
+// each env's game is built once and restarted in place for every episode after that
+void SnakeEnv::ResetEnv(int env)
+{
+    uint64_t seed = MixSeed(_seed ^ MixSeed((static_cast<uint64_t>(env) << 32) + _episodes[env]++));
+    if(_games[env]) {
+        _games[env]->Restart(seed);
+    } else {
+        _games[env].reset(new Game(_gridWidth, _gridHeight, seed));
+    }
+    _games[env]->_dirty.Clear();
+    _scores[env] = 0;
+}
+
+void SnakeEnv::ApplyAction(Game &game, int action) const
+{
+    Snake &snake = game.snake;
+
+    switch(action) {
+        case kActionUp:
+            game.ChangeDirection(snake, Snake::Direction::kUp, Snake::Direction::kDown);
+            break;
+        case kActionDown:
+            game.ChangeDirection(snake, Snake::Direction::kDown, Snake::Direction::kUp);
+            break;
+        case kActionLeft:
+            game.ChangeDirection(snake, Snake::Direction::kLeft, Snake::Direction::kRight);
+            break;
+        case kActionRight:
+            game.ChangeDirection(snake, Snake::Direction::kRight, Snake::Direction::kLeft);
+            break;
+        case kActionUsePotion:
+            if(snake.HasPotion()) snake.UsePotion();
+            break;
+        case kActionUseShrinkPill:
+            if(snake.HasShrinkPill()) snake.UseShrinkPill();
+            break;
+        case kActionUseSlowPill:
+            if(snake.HasSlowPill()) snake.UseSlowPill();
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+    file: snake_env.h - contains class SnakeEnv, a batch of games stepped in lockstep for training agents.
+    Reset and Step write each game's observation into a caller-provided buffer as bitplanes, one bit per cell,
+    copied straight out of the game's BitBoards. Nothing is rendered and no SDL window is needed.
+
+    Observation layout, for env i and plane p:
+        observations[(i * ENV_NUM_PLANES + p) * PlaneWords() + y * WordsPerRow() + (x >> 6)] bit (x & 63)
+*/
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "game.h"
+
+#define ENV_DEATH_REWARD -1.0f
+
+#define ENV_NUM_PLANES NUM_BOARD_PLANES   // see board_planes.h
+
+// bombs can be picked up but not used, their fuse burns on the fuse thread against the wall clock
+enum EnvAction {
+    kActionNone,
+    kActionUp,
+    kActionDown,
+    kActionLeft,
+    kActionRight,
+    kActionUsePotion,
+    kActionUseShrinkPill,
+    kActionUseSlowPill,
+    ENV_NUM_ACTIONS
+};
+
+class SnakeEnv {
+ public:
+    // ticks_per_step game ticks are run for every action (the snake starts out crossing a cell every 10 ticks)
+    SnakeEnv(int num_envs, int grid_width, int grid_height, int ticks_per_step = 1);
+
+    int NumEnvs() const { return static_cast<int>(_games.size()); }
+    int WordsPerRow() const { return _wordsPerRow; }
+    int PlaneWords() const { return _planeWords; }
+    int ObservationWords() const { return _planeWords * ENV_NUM_PLANES; }   // per env
+
+    // start every game over, the seed decides every game's layout
+    // observations holds NumEnvs() * ObservationWords() words
+    void Reset(uint64_t seed, uint64_t *observations);
+
+    // apply one action per env and advance. A game that ends reports done = 1 and is started over right away,
+    // so its observation is the first one of the next episode.
+    void Step(const int *actions, float *rewards, uint8_t *dones, uint64_t *observations);
+
+ private:
+    void ResetEnv(int env);
+    void ApplyAction(Game &game, int action) const;
+
+    int _gridWidth;
+    int _gridHeight;
+    int _ticksPerStep;
+    int _wordsPerRow;
+    int _planeWords;
+    uint64_t _seed{0};
+
+    std::vector<std::unique_ptr<Game>> _games;
+    std::vector<int> _scores;         // score at the last step, the reward is the change
+    std::vector<uint64_t> _episodes;  // episodes started per env, mixed into each new game's seed
+};
@@ -0,0 +1,58 @@
+#include "spatial_index.h"
+#include "dirty_cells.h"
+
+SpatialIndex::SpatialIndex(int width, int height) :
+    _occupied(width, height),
+    _cells(static_cast<std::size_t>(width) * height, nullptr)
+{
+    for(BitBoard &mask : _typeMasks) {
+        mask.Resize(width, height);
+    }
+}
+
+void SpatialIndex::Insert(int x, int y, GameElement *element)
+{
+    if(!_occupied.InBounds(x, y)) return;
+
+    // only one element is drawn per cell, the latest one wins
+    GameElement *&cell = _cells[y * _occupied.Width() + x];
+    if(cell != nullptr && cell != element) {
+        SetTypeBit(cell, x, y, false);
+    }
+    cell = element;
+    _occupied.Set(x, y);
+    SetTypeBit(element, x, y, true);
+    if(_dirty) _dirty->Mark(x, y);
+}
+
+void SpatialIndex::Remove(int x, int y, GameElement *element)
+{
+    if(!_occupied.InBounds(x, y)) return;
+
+    // don't clear the cell if another element has since taken it over
+    GameElement *&cell = _cells[y * _occupied.Width() + x];
+    if(cell == element) {
+        cell = nullptr;
+        _occupied.Reset(x, y);
+        SetTypeBit(element, x, y, false);
+        if(_dirty) _dirty->Mark(x, y);
+    }
+}
+
+void SpatialIndex::SetTypeBit(GameElement *element, int x, int y, bool set)
+{
+    int type = element->GetType();
+    if(type < 0 || type >= GameElement::NUM_ELEMENT_TYPES) return;
+
+    if(set) {
+        _typeMasks[type].Set(x, y);
+    } else {
+        _typeMasks[type].Reset(x, y);
+    }
+}
+
+GameElement* SpatialIndex::At(int x, int y) const
+{
+    if(!_occupied.InBounds(x, y)) return nullptr;
+    return _cells[y * _occupied.Width() + x];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+    file: spatial_index.h - contains class SpatialIndex, a cell -> GameElement lookup for every visible element
+    on the board. The occupancy bits let callers find the elements inside a rectangle by scanning words
+    instead of walking every element in the game, and a mask per element type says what kind is where.
+*/
+
+#include <vector>
+#include "bitboard.h"
+#include "game_element.h"
+
+class DirtyCells;
+
+class SpatialIndex {
+ public:
+    SpatialIndex(int width, int height);
+
+    void Insert(int x, int y, GameElement *element);
+    void Remove(int x, int y, GameElement *element);
+
+    // cells that gain or lose an element are marked here for the incremental renderer
+    void SetDirtyCells(DirtyCells *dirty) { _dirty = dirty; }
+
+    GameElement* At(int x, int y) const;
+    const BitBoard& Occupied() const { return _occupied; }
+
+    // the cells holding a visible power-up of the given type (food isn't tracked here, walls aren't elements)
+    const BitBoard& TypeMask(GameElement::ElementType type) const { return _typeMasks[type]; }
+
+ private:
+    void SetTypeBit(GameElement *element, int x, int y, bool set);
+
+    BitBoard _occupied;
+    BitBoard _typeMasks[GameElement::NUM_ELEMENT_TYPES];
+    std::vector<GameElement*> _cells;
+    DirtyCells *_dirty{nullptr};
+};
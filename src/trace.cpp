@@ -0,0 +1,211 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "alloc_tracker.h"
+
+namespace {
+    struct Event {
+        int64_t ns;             // on the steady clock, since the program started
+        const char *name;
+        int32_t value;
+        char phase;             // 'B', 'E' or 'i' as in the trace-event format
+    };
+
+    // an event in the ring. Its fields are atomics so Dump can read a slot while its thread is overwriting
+    // it: each is stored with release and loaded with acquire, so a Dump that reads any field of a new event
+    // also sees the count that says the slot was in use, and drops what it read from there.
+    struct Slot {
+        std::atomic<int64_t> ns{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int32_t> value{0};
+        std::atomic<char> phase{0};
+
+        void Store(const Event &event)
+        {
+            ns.store(event.ns, std::memory_order_release);
+            name.store(event.name, std::memory_order_release);
+            value.store(event.value, std::memory_order_release);
+            phase.store(event.phase, std::memory_order_release);
+        }
+
+        Event Load() const
+        {
+            return {ns.load(std::memory_order_acquire), name.load(std::memory_order_acquire),
+                    value.load(std::memory_order_acquire), phase.load(std::memory_order_acquire)};
+        }
+    };
+
+    // the events of one thread at a time. Only the thread holding it writes, and each event is published
+    // by bumping the count, so Dump can read it from another thread without stopping the writer. The count
+    // works as a seqlock: while it reads n, slot n % TRACE_BUFFER_EVENTS may be half written.
+    struct Buffer {
+        std::vector<Slot> events = std::vector<Slot>(TRACE_BUFFER_EVENTS);
+        std::atomic<uint64_t> written{0};
+        std::atomic<const char*> threadName{nullptr};
+        int tid{0};
+    };
+
+    // held to take or give back a buffer and to dump, never to record
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::vector<Buffer*> freeBuffers;
+    std::string outputPath = TRACE_DEFAULT_FILE;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<int64_t> startNs{0};
+
+    int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // a thread takes a buffer with its first event and gives it back when it exits, so threads that come
+    // and go share a few buffers, and a row each in the viewer
+    struct ThreadSlot {
+        Buffer *buffer{nullptr};
+        const char *name{nullptr};
+
+        ~ThreadSlot()
+        {
+            if(!buffer) return;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            freeBuffers.push_back(buffer);
+        }
+    };
+    thread_local ThreadSlot slot;
+
+    Buffer* ThreadBuffer()
+    {
+        if(slot.buffer) return slot.buffer;
+
+        // the tracer's own allocation, once per thread, not the game's
+        AllocScope scope(AllocTag::kOther);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if(freeBuffers.empty()) {
+            buffers.emplace_back(new Buffer);
+            buffers.back()->tid = static_cast<int>(buffers.size());
+            freeBuffers.reserve(buffers.size());
+            freeBuffers.push_back(buffers.back().get());
+        }
+        slot.buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        if(slot.name) slot.buffer->threadName.store(slot.name, std::memory_order_relaxed);
+        return slot.buffer;
+    }
+
+    void Record(const char *name, char phase, int value)
+    {
+        Buffer *buffer = ThreadBuffer();
+        const uint64_t n = buffer->written.load(std::memory_order_relaxed);
+        buffer->events[n % TRACE_BUFFER_EVENTS].Store({Now(), name, value, phase});
+        buffer->written.store(n + 1, std::memory_order_release);
+    }
+}
+
+namespace Trace {
+
+void Start()
+{
+    startNs.store(Now(), std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+}
+
+void Stop()
+{
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+void Toggle()
+{
+    if(Enabled()) {
+        Stop();
+        Dump();
+    } else {
+        Start();
+        std::cout << "Tracing, press F12 again to write the trace" << std::endl;
+    }
+}
+
+void SetOutput(const char *path)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    outputPath = path;
+}
+
+bool Dump()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::FILE *file = std::fopen(outputPath.c_str(), "w");
+    if(!file) {
+        std::cerr << "Couldn't write the trace to " << outputPath << std::endl;
+        return false;
+    }
+
+    const int64_t start = startNs.load(std::memory_order_relaxed);
+    std::vector<Event> events;
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"SnakeGame\"}}");
+    for(const std::unique_ptr<Buffer> &buffer : buffers) {
+        if(const char *name = buffer->threadName.load(std::memory_order_relaxed)) {
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                         buffer->tid, name);
+        }
+
+        // copy the ring, then drop whatever its thread may have overwritten while it was being copied: every
+        // event it has finished since, and the one it may be writing now
+        const uint64_t end = buffer->written.load(std::memory_order_acquire);
+        const uint64_t begin = end > TRACE_BUFFER_EVENTS ? end - TRACE_BUFFER_EVENTS : 0;
+        events.clear();
+        for(uint64_t i = begin; i < end; ++i) {
+            events.push_back(buffer->events[i % TRACE_BUFFER_EVENTS].Load());
+        }
+        const uint64_t after = buffer->written.load(std::memory_order_acquire);
+        const uint64_t valid = after + 1 > TRACE_BUFFER_EVENTS ? after + 1 - TRACE_BUFFER_EVENTS : 0;
+
+        for(uint64_t i = std::max(begin, valid); i < end; ++i) {
+            const Event &event = events[i - begin];
+            if(event.ns < start) continue;
+            const double us = static_cast<double>(event.ns - start) / 1000.0;
+            if(event.phase == 'i') {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%d}}",
+                             event.name, buffer->tid, us, event.value);
+            } else {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+                             event.name, event.phase, buffer->tid, us);
+            }
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    const bool ok = std::fclose(file) == 0;
+    std::cout << "Trace written to " << outputPath << ", open it in ui.perfetto.dev or chrome://tracing" << std::endl;
+    return ok;
+}
+
+void NameThread(const char *name)
+{
+    slot.name = name;
+    if(slot.buffer) slot.buffer->threadName.store(name, std::memory_order_relaxed);
+}
+
+void Begin(const char *name)
+{
+    Record(name, 'B', 0);
+}
+
+void End(const char *name)
+{
+    Record(name, 'E', 0);
+}
+
+void Instant(const char *name, int value)
+{
+    Record(name, 'i', value);
+}
+
+}
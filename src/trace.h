@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+    file: trace.h - a timeline of what each thread was doing, written out as Chrome trace-event JSON that
+    Perfetto (ui.perfetto.dev) and chrome://tracing open. It is always compiled in and off until Start(),
+    so a build that stutters in the field can be traced without rebuilding: run with --trace, or press F12
+    once to start recording and again to write the file. While off, a span or event costs one relaxed load
+    and a branch. While on, each thread appends to a ring buffer of its own with no locks, and once the ring
+    is full the oldest events are overwritten. Names have to be string literals, only the pointer is kept.
+*/
+
+#include <atomic>
+#include <cstdint>
+
+#define TRACE_BUFFER_EVENTS 16384            // per thread, a couple of minutes of frames and ticks
+#define TRACE_DEFAULT_FILE "snake_trace.json"
+
+namespace Trace {
+    inline std::atomic<bool> enabled{false};
+
+    inline bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // record from now on, or stop. Dump only writes what was recorded since the last Start.
+    void Start();
+    void Stop();
+
+    // start recording, or stop and dump what was recorded
+    void Toggle();
+
+    // where Dump writes, TRACE_DEFAULT_FILE until set
+    void SetOutput(const char *path);
+
+    // write the recorded events of every thread, safe to call while the other threads keep recording. An
+    // event a thread overwrites while its ring is being copied is left out.
+    bool Dump();
+
+    // the name this thread's row gets in the viewer
+    void NameThread(const char *name);
+
+    void Begin(const char *name);
+    void End(const char *name);
+    void Instant(const char *name, int value = 0);
+}
+
+// a span from here to the end of the scope. It only ends what it began, so turning tracing on or off in
+// the middle of it never leaves a span open.
+class TraceSpan {
+ public:
+    explicit TraceSpan(const char *name) : _name(Trace::Enabled() ? name : nullptr)
+    {
+        if(_name) Trace::Begin(_name);
+    }
+    ~TraceSpan()
+    {
+        if(_name) Trace::End(_name);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+    const char *_name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_INSTANT(...) do { if(Trace::Enabled()) { Trace::Instant(__VA_ARGS__); } } while(0)
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include "wall_layer.h"
+#include "dirty_cells.h"
+#include "color_defines.h"
+
+// the state byte of a cell, a wall fading in counts up from WALL_STATE_FADE one step at a time
+#define WALL_STATE_NONE 0
+#define WALL_STATE_HIDDEN 1
+#define WALL_STATE_FADE 2
+#define WALL_STATE_SOLID 255
+
+static_assert(WALL_STATE_FADE + WALL_FADE_STEPS <= WALL_STATE_SOLID, "the fade steps must fit in the state byte");
+
+// move a channel one unit per tick from the background towards the wall's color, as elements fade in
+static Uint8 FadeChannel(Uint8 from, Uint8 to, int ticks)
+{
+    if(from < to) return static_cast<Uint8>(from + std::min(ticks, to - from));
+    return static_cast<Uint8>(from - std::min(ticks, from - to));
+}
+
+WallLayer::WallLayer(int width, int height) :
+    _shown(width, height),
+    _listed(width, height),
+    _hidden(width, height),
+    _hiddenInRow(height, 0),
+    _state(static_cast<std::size_t>(width) * height, WALL_STATE_NONE)
+{
+    for(int step = 0; step < WALL_FADE_STEPS; ++step) {
+        int ticks = step * WALL_FADE_TICKS;
+        _fadeColors[step] = {FadeChannel(screenBackgroundColor.red(), wallColor.red(), ticks),
+                             FadeChannel(screenBackgroundColor.green(), wallColor.green(), ticks),
+                             FadeChannel(screenBackgroundColor.blue(), wallColor.blue(), ticks),
+                             screenBackgroundColor.alpha()};
+    }
+}
+
+void WallLayer::Add(int x, int y)
+{
+    if(!_shown.InBounds(x, y)) return;
+
+    uint8_t &state = _state[Index(x, y)];
+    if(state != WALL_STATE_NONE) return;
+
+    state = WALL_STATE_HIDDEN;
+    AddHidden(x, y);
+    ++_count;
+}
+
+void WallLayer::AddHidden(int x, int y)
+{
+    _hidden.Set(x, y);
+    ++_hiddenInRow[y];
+    ++_hiddenCount;
+}
+
+void WallLayer::AddSolid(int x, int y)
+{
+    if(!_shown.InBounds(x, y)) return;
+
+    uint8_t &state = _state[Index(x, y)];
+    if(state != WALL_STATE_NONE) return;
+
+    // not marked, the board is built before the first frame and that repaints everything
+    state = WALL_STATE_SOLID;
+    _shown.Set(x, y);
+    ++_count;
+}
+
+void WallLayer::Clear()
+{
+    _shown.Clear();
+    _listed.Clear();
+    _hidden.Clear();
+    std::fill(_hiddenInRow.begin(), _hiddenInRow.end(), 0);
+    std::fill(_state.begin(), _state.end(), WALL_STATE_NONE);
+    _fading.clear();
+    _ticks = 0;
+    _count = 0;
+    _hiddenCount = 0;
+}
+
+void WallLayer::Reserve()
+{
+    _fading.reserve(std::min(_count, WALL_FADING_RESERVE));
+}
+
+bool WallLayer::TakeRandomHidden(Xoshiro256 &random, SDL_Point &cell)
+{
+    if(_hiddenCount == 0) return false;
+
+    // the n-th hidden wall counting along the rows: find its row, then its word, then its bit
+    uint32_t n = random.Below(static_cast<uint32_t>(_hiddenCount));
+    int y = 0;
+    while(n >= static_cast<uint32_t>(_hiddenInRow[y])) {
+        n -= _hiddenInRow[y];
+        ++y;
+    }
+    const uint64_t *row = _hidden.Row(y);
+    int w = 0;
+    while(n >= static_cast<uint32_t>(__builtin_popcountll(row[w]))) {
+        n -= __builtin_popcountll(row[w]);
+        ++w;
+    }
+    uint64_t bits = row[w];
+    for(; n > 0; --n) bits &= bits - 1;
+
+    cell = {(w << 6) + __builtin_ctzll(bits), y};
+    _hidden.Reset(cell.x, cell.y);
+    --_hiddenInRow[y];
+    --_hiddenCount;
+    return true;
+}
+
+void WallLayer::Show(int x, int y)
+{
+    int32_t index = Index(x, y);
+    _state[index] = WALL_STATE_FADE;
+    _shown.Set(x, y);
+    if(!_listed.Test(x, y)) {
+        _listed.Set(x, y);
+        _fading.push_back(index);
+    }
+    Mark(x, y);
+}
+
+void WallLayer::PutBackHidden(int x, int y)
+{
+    AddHidden(x, y);
+}
+
+void WallLayer::Update()
+{
+    // every fading wall takes its next step together, once every WALL_FADE_TICKS ticks
+    if(++_ticks < WALL_FADE_TICKS) return;
+    _ticks = 0;
+
+    for(std::size_t i = 0; i < _fading.size();) {
+        int32_t index = _fading[i];
+        uint8_t &state = _state[index];
+        int x = index % _shown.Width();
+        int y = index / _shown.Width();
+
+        if(state >= WALL_STATE_FADE && state < WALL_STATE_SOLID) {
+            state = (state + 1 < WALL_STATE_FADE + WALL_FADE_STEPS) ? state + 1 : WALL_STATE_SOLID;
+            Mark(x, y);
+        }
+
+        if(state == WALL_STATE_SOLID || state == WALL_STATE_HIDDEN) {
+            // done (or blown up), swap it out of the list
+            _listed.Reset(x, y);
+            _fading[i] = _fading.back();
+            _fading.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void WallLayer::HideRange(int y, int x0, int x1)
+{
+    if(y < 0 || y >= _shown.Height()) return;
+
+    _shown.ForEachSetInRow(y, x0, x1, [&](int x) {
+        _state[Index(x, y)] = WALL_STATE_HIDDEN;
+        AddHidden(x, y);
+        Mark(x, y);
+    });
+    _shown.ResetRange(y, x0, x1);
+}
+
+void WallLayer::Relist()
+{
+    // the order of the fading list doesn't matter, every wall on it steps together, and the hidden set has
+    // none, so a game wound back picks the same walls to put back as it did the first time
+    _listed.Clear();
+    _hidden.Clear();
+    std::fill(_hiddenInRow.begin(), _hiddenInRow.end(), 0);
+    _fading.clear();
+    _count = 0;
+    _hiddenCount = 0;
+    for(int32_t index = 0; index < static_cast<int32_t>(_state.size()); ++index) {
+        const uint8_t state = _state[index];
+        if(state == WALL_STATE_NONE) continue;
+        ++_count;
+        if(state == WALL_STATE_HIDDEN) {
+            AddHidden(index % _shown.Width(), index / _shown.Width());
+        } else if(state >= WALL_STATE_FADE && state < WALL_STATE_SOLID) {
+            _listed.Set(index % _shown.Width(), index / _shown.Width());
+            _fading.push_back(index);
+        }
+    }
+}
+
+bool WallLayer::Solid(int x, int y) const
+{
+    return _shown.InBounds(x, y) && _state[Index(x, y)] == WALL_STATE_SOLID;
+}
+
+SDL_Color WallLayer::CellColor(int x, int y) const
+{
+    uint8_t state = _state[Index(x, y)];
+    if(state == WALL_STATE_SOLID) return _fadeColors[WALL_FADE_STEPS - 1];
+    if(state >= WALL_STATE_FADE) return _fadeColors[state - WALL_STATE_FADE];
+    return screenBackgroundColor.toSDLColor();
+}
+
+void WallLayer::Mark(int x, int y)
+{
+    if(_dirty) _dirty->Mark(x, y);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+    file: wall_layer.h - contains class WallLayer, every wall on the board kept as bits and bytes instead of
+    one GameElement per cell. A bitplane says which cells have a wall showing, a byte per cell says whether
+    that wall is hidden, fading in (and how far along) or solid, and a second bitplane with a count per row
+    holds the hidden walls, so one can be picked uniformly at random to rematerialize. Only the walls fading
+    in are listed, and there are never more of them than a few hundred ticks of placing walls. The board
+    costs a byte and three bits a cell however many walls it holds, about 23 MB for a 4096x4096 maze.
+*/
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "bitboard.h"
+#include "game_element.h"
+#include "random.h"
+
+#define WALL_FADE_TICKS 4                                                // ticks per fade step
+#define WALL_FADE_STEPS (DEFAULT_APPEARANCE_TIMER / WALL_FADE_TICKS)     // steps before a fading wall turns solid
+
+// room on the fading list for the walls a game can start fading while the first of them fades in: eating
+// food puts up to two walls back, and food is eaten at most once a tick
+#define WALL_FADING_RESERVE (2 * (DEFAULT_APPEARANCE_TIMER + WALL_FADE_TICKS))
+
+class DirtyCells;
+class Rewind;
+
+class WallLayer {
+ public:
+    WallLayer(int width, int height);
+
+    // walls that show, hide or change color are marked here for the incremental renderer
+    void SetDirtyCells(DirtyCells *dirty) { _dirty = dirty; }
+
+    // put a hidden wall in the cell, it doesn't show until it is picked by TakeRandomHidden and shown
+    void Add(int x, int y);
+
+    // put a wall in the cell that is solid straight away, for generated layouts built before the first frame
+    void AddSolid(int x, int y);
+
+    // take a uniformly chosen wall out of the hidden set, so it can be looked at before it's shown. Returns
+    // false if every wall is already showing. Counts its way through the rows, O(height + width / 64).
+    bool TakeRandomHidden(Xoshiro256 &random, SDL_Point &cell);
+
+    // show a wall taken out of the hidden set, it fades in and turns solid WALL_FADE_STEPS steps later, or
+    // put it back in the set
+    void Show(int x, int y);
+    void PutBackHidden(int x, int y);
+
+    // take every wall away for a new game, keeping the memory. Nothing is marked, a new game repaints it all.
+    void Clear();
+
+    // make room on the fading list, once the board is built, so placing walls never grows it during play
+    void Reserve();
+
+    // advance the fading walls by one tick
+    void Update();
+
+    // hide the walls showing in row y where x0 <= x < x1, they go back into the hidden set
+    void HideRange(int y, int x0, int x1);
+
+    // a wall is showing in the cell (fading in or solid), only solid walls kill the snake
+    bool Shown(int x, int y) const { return _shown.InBounds(x, y) && _shown.Test(x, y); }
+    bool Solid(int x, int y) const;
+
+    // the color of the wall showing in the cell
+    SDL_Color CellColor(int x, int y) const;
+
+    // one bit per cell with a wall showing
+    const BitBoard& ShownBits() const { return _shown; }
+
+    int HiddenCount() const { return _hiddenCount; }
+    int WallCount() const { return _count; }
+
+ private:
+    friend class Rewind;    // copies the bits and bytes out, and back in when winding back
+
+    int Index(int x, int y) const { return y * _shown.Width() + x; }
+    void Mark(int x, int y);
+    void AddHidden(int x, int y);
+
+    // rebuild the hidden set and the fading list and count every wall again from the state bytes, once
+    // they've been put back
+    void Relist();
+
+    BitBoard _shown;
+    BitBoard _listed;                   // cells on the fading list, so a wall hidden and shown again isn't listed twice
+    BitBoard _hidden;                   // hidden walls that can be picked, the state byte says hidden for all of them
+    std::vector<int32_t> _hiddenInRow;  // how many bits of each row of _hidden are set
+    std::vector<uint8_t> _state;        // per cell: no wall, hidden, a fade step or solid
+    std::vector<int32_t> _fading;       // cells of the walls fading in
+    SDL_Color _fadeColors[WALL_FADE_STEPS];
+    int _ticks{0};
+    int _count{0};                      // walls in any state
+    int _hiddenCount{0};
+    DirtyCells *_dirty{nullptr};
+};
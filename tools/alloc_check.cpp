@@ -0,0 +1,186 @@
+/*
+    file: alloc_check.cpp - plays a seeded game on every board layout and fails if a tick allocates once the
+    game has warmed up, the same rule ALLOC_ASSERT_STEADY_STATE holds the game to. Built with TRACK_ALLOCATIONS.
+
+    The snake is steered along the distance field to the food. Halfway through it goes and picks up a bomb,
+    uses it and keeps playing at the game's pace until the fuse burns down, and at the end the game is wound
+    back, so the paths a game only takes now and then are counted too. When the snake dies a new round is
+    started outside the counted ticks, generating a layout allocates.
+
+    usage: SnakeAllocCheck [grid_size] [ticks] [seed]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "game.h"
+#include "debug_log.h"
+
+#define CHECK_TICKS_PER_SECOND 60.0
+#define CHECK_BLAST_RADIUS 4        // wide enough to blow away some of the walls on every layout
+#define CHECK_BOMB_ATTEMPTS 8
+#define CHECK_PICKUP_TICKS 2000
+
+static uint64_t UpdateAllocs() {
+  return AllocTracker::Snapshot().count[static_cast<int>(AllocTag::kUpdate)];
+}
+
+class AllocCheck {
+ public:
+  AllocCheck(int grid, uint64_t seed, BoardLayout layout) : _game(grid, grid, seed, layout) {
+    _game.EnableRewind(30.0, CHECK_TICKS_PER_SECOND);
+    _game.SetBombBlast(CHECK_BLAST_RADIUS, BlastShape::kSquare);
+  }
+
+  // update allocations over ticks of play after the warmup, with a bomb and a rewind in it
+  uint64_t Run(int ticks) {
+    for (int i = 0; i < ALLOC_WARMUP_FRAMES; ++i) Tick(Food(), true);
+
+    const uint64_t before = UpdateAllocs();
+    for (int i = 0; i < ticks / 2; ++i) Tick(Food(), true);
+    _exploded = UseBomb();
+    for (int i = 0; i < ticks / 2; ++i) Tick(Food(), true);
+
+    _game._input.Push(GameEventType::kInputRewind, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE, REWIND_STEP_SECONDS);
+    Tick(Food(), true);
+    return UpdateAllocs() - before;
+  }
+
+  bool Exploded() const { return _exploded; }
+  int Restarts() const { return _restarts; }
+  int Score() const { return _game.GetScore(); }
+
+ private:
+  SDL_Point Food() const { return _game.food.GetLocation(); }
+
+  // one tick as the simulation thread runs it, after the turn a player would have made
+  void Tick(SDL_Point target, bool restart) {
+    if (restart && !_game.snake.alive) {
+      AllocScope scope(AllocTag::kOther);
+      _game.Restart();
+      ++_restarts;
+    }
+    Steer(target);
+
+    AllocScope scope(AllocTag::kUpdate);
+    _game.Update();
+    _game.PublishSnapshot();
+  }
+
+  // turn onto a shortest path to the target, found by walking the distances back from it to the head
+  void Steer(SDL_Point target) {
+    struct Step { int dx, dy; Snake::Direction direction; };
+    static const Step steps[] = {{0, -1, Snake::Direction::kUp}, {0, 1, Snake::Direction::kDown},
+                                 {-1, 0, Snake::Direction::kLeft}, {1, 0, Snake::Direction::kRight}};
+
+    const DistanceField &field = _game.HeadDistances();
+    const int w = field.Width();
+    const int h = field.Height();
+    if (target.x < 0 || target.y < 0 || field.At(target.x, target.y) < 1) return;
+
+    SDL_Point cell = target;
+    for (int d = field.At(target.x, target.y); d > 1; --d) {
+      for (const Step &step : steps) {
+        SDL_Point next{(cell.x + step.dx + w) % w, (cell.y + step.dy + h) % h};
+        if (field.At(next.x, next.y) == d - 1) {
+          cell = next;
+          break;
+        }
+      }
+    }
+
+    const int head_x = _game.snake.HeadX();
+    const int head_y = _game.snake.HeadY();
+    for (const Step &step : steps) {
+      if ((head_x + step.dx + w) % w == cell.x && (head_y + step.dy + h) % h == cell.y) {
+        _game._input.Push(GameEventType::kInputTurn, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE,
+                          static_cast<int>(step.direction));
+        return;
+      }
+    }
+  }
+
+  // put a bomb down where the head can get to it, the way PlaceNextElement does
+  GameElement* PlaceBomb() {
+    AllocScope scope(AllocTag::kUpdate);
+    GameElement *bomb = _game._pool.Acquire(GameElement::BOMB);
+    SDL_Point cell = _game.GetUnoccupiedLocation();
+    if (!bomb || cell.x < 0) return nullptr;
+
+    bomb->SetLocation(cell.x, cell.y);
+    bomb->SetVisibility(true);
+    _game.TrackAppearing(bomb);
+    _game.board_bits.Set(cell.x, cell.y);
+    return bomb;
+  }
+
+  // pick up a bomb, use it and play on until it goes off. A restart takes the bomb back, so try again.
+  bool UseBomb() {
+    for (int attempt = 0; attempt < CHECK_BOMB_ATTEMPTS; ++attempt) {
+      GameElement *bomb = PlaceBomb();
+      if (!bomb) {
+        Tick(Food(), true);
+        continue;
+      }
+      for (int i = 0; i < CHECK_PICKUP_TICKS && _game.snake.alive && !_game.snake.HasBomb(); ++i) {
+        Tick(bomb->GetLocation(), false);
+      }
+      if (!_game.snake.HasBomb()) {
+        Tick(Food(), true);
+        continue;
+      }
+
+      _game._input.Push(GameEventType::kInputUseItem, {0, 0}, nullptr, GameElement::BOMB);
+      Tick(Food(), false);
+
+      // the fuse burns on the wall clock, a dead snake just waits for it
+      const auto period = std::chrono::duration<double>(1.0 / CHECK_TICKS_PER_SECOND);
+      while (!_game._litBombs.empty()) {
+        std::this_thread::sleep_for(period);
+        Tick(Food(), false);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  Game _game;
+  int _restarts{0};
+  bool _exploded{false};
+};
+
+int main(int argc, char **argv) {
+  int grid_size = argc > 1 ? std::atoi(argv[1]) : 64;
+  int ticks = argc > 2 ? std::atoi(argv[2]) : 3000;
+  uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+  if (grid_size < 16 || ticks < 2) {
+    std::cerr << "grid_size must be at least 16 and ticks at least 2" << std::endl;
+    return 1;
+  }
+  if (!AllocTracker::Enabled()) {
+    std::cerr << "built without TRACK_ALLOCATIONS, there is nothing to count" << std::endl;
+    return 1;
+  }
+
+  DebugLog::SetEnabled(false);
+
+  const BoardLayout layouts[] = {BoardLayout::kPerimeter, BoardLayout::kMaze, BoardLayout::kCave, BoardLayout::kRooms};
+  bool ok = true;
+
+  std::cout << grid_size << "x" << grid_size << ", " << ticks << " ticks after " << ALLOC_WARMUP_FRAMES
+            << " to warm up, seed " << seed << std::endl;
+  std::cout << "layout     score  restarts  bomb      update allocs" << std::endl;
+  for (BoardLayout layout : layouts) {
+    AllocCheck check(grid_size, seed, layout);
+    uint64_t allocs = check.Run(ticks);
+    ok = ok && allocs == 0 && check.Exploded();
+
+    std::cout << std::left << std::setw(9) << LayoutName(layout) << std::right
+              << std::setw(7) << check.Score() << std::setw(10) << check.Restarts()
+              << "  " << std::left << std::setw(8) << (check.Exploded() ? "exploded" : "unused") << std::right
+              << std::setw(15) << allocs << std::endl;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*
+    file: board_bench.cpp - times the board kernels specialized for each common board size against the
+    generic kernels on the same boards: the distance BFS from the middle of an open board and of each
+    generated layout. Fails if the two ever give different distances.
+
+    usage: SnakeBoardBench [milliseconds_per_test] [seed]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "board_kernels.h"
+#include "board_layout.h"
+#include "debug_log.h"
+
+// microseconds per call of fn, run for about the given time
+template <typename Fn>
+static double TimeIt(int milliseconds, Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  long calls = 0;
+  auto start = Clock::now();
+  auto end = start + std::chrono::milliseconds(milliseconds);
+  Clock::time_point now;
+  do {
+    fn();
+    ++calls;
+    now = Clock::now();
+  } while (now < end);
+  return std::chrono::duration<double, std::micro>(now - start).count() / calls;
+}
+
+int main(int argc, char **argv) {
+  int milliseconds = argc > 1 ? std::atoi(argv[1]) : 200;
+  uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+  // keep the generator's chatter out of the table
+  DebugLog::SetEnabled(false);
+
+  int count = 0;
+  const BoardKernels *specialized = SpecializedBoardKernels(count);
+  const BoardKernels &generic = GenericBoardKernels();
+  const BoardLayout layouts[] = {BoardLayout::kPerimeter, BoardLayout::kMaze, BoardLayout::kCave, BoardLayout::kRooms};
+
+  int mismatches = 0;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "board      layout     bfs us (fixed / generic)  speedup" << std::endl;
+  for (int k = 0; k < count; ++k) {
+    const BoardKernels &fixed = specialized[k];
+    const SDL_Point start{fixed.width / 2, fixed.height / 2};
+    const std::size_t cells = static_cast<std::size_t>(fixed.width) * fixed.height;
+    std::vector<int32_t> fixed_dist(cells);
+    std::vector<int32_t> generic_dist(cells);
+    std::vector<int32_t> queue(cells);
+
+    for (BoardLayout layout : layouts) {
+      // the perimeter layout stands in for an open board, nothing blocked at all
+      BitBoard blocked(fixed.width, fixed.height);
+      if (layout != BoardLayout::kPerimeter) GenerateLayout(layout, seed, start, blocked);
+      const int32_t source = start.y * fixed.width + start.x;
+
+      double fixed_us = TimeIt(milliseconds, [&]() { fixed.distances(blocked, source, fixed_dist.data(), queue.data()); });
+      double generic_us = TimeIt(milliseconds, [&]() { generic.distances(blocked, source, generic_dist.data(), queue.data()); });
+      if (fixed_dist != generic_dist) ++mismatches;
+
+      std::cout << std::left << std::setw(11) << fixed.name << std::setw(11) << (layout == BoardLayout::kPerimeter ? "open" : LayoutName(layout))
+                << std::right << std::setw(10) << fixed_us << " / " << std::setw(10) << generic_us << "  " << std::setw(6)
+                << std::setprecision(2) << generic_us / fixed_us << "x" << std::setprecision(1) << std::endl;
+    }
+  }
+  if (mismatches) {
+    std::cout << mismatches << " boards gave different distances" << std::endl;
+    return 1;
+  }
+  return 0;
+}
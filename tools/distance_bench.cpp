@@ -0,0 +1,144 @@
+/*
+    file: distance_bench.cpp - keeps a DistanceField up to date on a generated board while walls show and hide
+    at random cells and the snake moves, and times each refresh against working the whole field out again
+    with a BFS. Fails if a refresh ever differs from the BFS.
+
+    usage: SnakeDistanceBench [grid_size] [changes] [seed]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "board_layout.h"
+#include "debug_log.h"
+#include "distance_field.h"
+#include "dirty_cells.h"
+#include "snake.h"
+
+struct Timing {
+  double refreshMs{0.0};
+  double bfsMs{0.0};
+  int count{0};
+};
+
+static double Since(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv) {
+  int grid_size = argc > 1 ? std::atoi(argv[1]) : 1024;
+  int changes = argc > 2 ? std::atoi(argv[2]) : 200;
+  uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 1;
+  if (grid_size < 8 || changes < 1) {
+    std::cerr << "grid_size must be at least 8 and changes at least 1" << std::endl;
+    return 1;
+  }
+
+  // keep the debug chatter of the code under test out of the timings
+  DebugLog::SetEnabled(false);
+
+  const BoardLayout layouts[] = {BoardLayout::kPerimeter, BoardLayout::kMaze, BoardLayout::kCave, BoardLayout::kRooms};
+  const SDL_Point start{grid_size / 2, grid_size / 2};
+  bool ok = true;
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << grid_size << "x" << grid_size << ", " << changes << " changes of each kind, seed " << seed << std::endl;
+  std::cout << "layout     change       refresh ms   bfs ms  speedup  recomputed" << std::endl;
+  for (BoardLayout layout : layouts) {
+    BitBoard walls(grid_size, grid_size);
+    GenerateLayout(layout, seed, start, walls);
+    if (layout == BoardLayout::kPerimeter) {
+      // the game puts these in itself, around the edge
+      for (int i = 0; i < grid_size; ++i) {
+        walls.Set(i, 0);
+        walls.Set(i, grid_size - 1);
+        walls.Set(0, i);
+        walls.Set(grid_size - 1, i);
+      }
+    }
+
+    DirtyCells dirty(grid_size, grid_size);
+    Snake snake(grid_size, grid_size);
+    snake.SetDirtyCells(&dirty);
+
+    // the field under test follows the dirty list, the other one is worked out from scratch every time
+    DistanceField field(walls, snake);
+    DistanceField bfs(walls, snake);
+    field.Refresh();
+    dirty.Clear();
+
+    std::mt19937 engine(seed);
+    std::uniform_int_distribution<int> random_cell(0, grid_size - 1);
+    Timing timings[3];
+    const char *names[3] = {"wall shown", "wall hidden", "head moved"};
+    int mismatches = 0;
+
+    auto measure = [&](Timing &timing) {
+      field.Sync(dirty);
+      dirty.Clear();
+      int recomputes = field.Recomputes();
+      auto begin = std::chrono::steady_clock::now();
+      field.Refresh();
+      timing.refreshMs += Since(begin);
+      timing.count += field.Recomputes() - recomputes;
+
+      begin = std::chrono::steady_clock::now();
+      bfs.Recompute();
+      timing.bfsMs += Since(begin);
+      if (std::memcmp(field.Data(), bfs.Data(), sizeof(int32_t) * grid_size * grid_size) != 0) ++mismatches;
+    };
+
+    for (int i = 0; i < changes; ++i) {
+      // a wall shows at a random free cell and later hides again
+      int x, y;
+      do {
+        x = random_cell(engine);
+        y = random_cell(engine);
+      } while (walls.Test(x, y) || snake.SnakeCell(x, y));
+      walls.Set(x, y);
+      dirty.Mark(x, y);
+      measure(timings[0]);
+      walls.Reset(x, y);
+      dirty.Mark(x, y);
+
+      // and one that was already there hides, then shows again
+      do {
+        x = random_cell(engine);
+        y = random_cell(engine);
+      } while (!walls.Test(x, y));
+      walls.Reset(x, y);
+      dirty.Mark(x, y);
+      measure(timings[1]);
+      walls.Set(x, y);
+      dirty.Mark(x, y);
+      field.Sync(dirty);
+      dirty.Clear();
+      field.Refresh();
+    }
+
+    // the head moves a cell at a time, growing as it goes
+    snake.AddSpeed(FIXED_ONE - snake.GetSpeed());
+    for (int i = 0; i < changes; ++i) {
+      if (i % 4 == 0) snake.GrowBody();
+      if (i % 16 == 8) snake.direction = (snake.direction == Snake::Direction::kUp) ? Snake::Direction::kLeft
+                                                                                     : Snake::Direction::kUp;
+      snake.Update();
+      measure(timings[2]);
+    }
+
+    for (int k = 0; k < 3; ++k) {
+      const Timing &t = timings[k];
+      std::cout << std::left << std::setw(11) << LayoutName(layout) << std::setw(12) << names[k] << std::right
+                << std::setw(12) << t.refreshMs / changes
+                << std::setw(9) << t.bfsMs / changes
+                << std::setw(8) << std::setprecision(1) << (t.refreshMs > 0.0 ? t.bfsMs / t.refreshMs : 0.0) << "x"
+                << std::setprecision(3) << std::setw(12) << t.count << std::endl;
+    }
+    if (mismatches) std::cout << "  " << mismatches << " refreshes differed from the BFS" << std::endl;
+    ok = ok && mismatches == 0;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+    file: element_stress.cpp - lights many bombs at once and hammers their packed state from other threads,
+    meant to be run under ThreadSanitizer (BUILD_ELEMENT_STRESS builds it with -fsanitize=thread).
+
+    Every bomb's fuse recolors it on the fuse thread. Meanwhile the main thread, standing in for the
+    simulation, keeps moving each bomb between two cells and flipping its availability, and a reader
+    thread, standing in for the snapshot code, checks every state it loads: the color has to be one the
+    bomb can have and the location one of its two cells, never half of each. Once every bomb has exploded
+    each one's final state has to hold both the fuse's last color and the main thread's last move, so no
+    update was lost to a concurrent one.
+
+    usage: SnakeElementStress [num_bombs]
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "game_element.h"
+#include "spatial_index.h"
+#include "event_queue.h"
+#include "debug_log.h"
+
+#define STRESS_BOARD_SIZE 64
+
+static bool IsBombColor(const Color &c) {
+  const Color colors[] = {bombColor, bombLit1, bombLit2, bombLit3, bombLit4, bombLit5, bombLit6, bombLit7, bombLit8};
+  for (const Color &color : colors) {
+    if (c == color && c.alpha() == color.alpha()) return true;
+  }
+  return false;
+}
+
+// bomb i moves between these two cells, a torn location would be a mix of them
+static SDL_Point CellA(int i) { return {(2 * i) % (STRESS_BOARD_SIZE - 1), (2 * i) / (STRESS_BOARD_SIZE - 1)}; }
+static SDL_Point CellB(int i) { SDL_Point a = CellA(i); return {a.x + 1, a.y + 1}; }
+
+static bool Same(SDL_Point a, SDL_Point b) { return a.x == b.x && a.y == b.y; }
+
+int main(int argc, char **argv) {
+  int num_bombs = argc > 1 ? std::atoi(argv[1]) : 256;
+  if (num_bombs < 1 || CellB(num_bombs - 1).y >= STRESS_BOARD_SIZE) {
+    std::cerr << "num_bombs must be at least 1, and few enough to fit a " << STRESS_BOARD_SIZE << "x" << STRESS_BOARD_SIZE << " board" << std::endl;
+    return 1;
+  }
+
+  // a line per fuse step from every bomb would serialize the threads on cout
+  DebugLog::SetEnabled(false);
+
+  EventQueue events;
+  SpatialIndex index(STRESS_BOARD_SIZE, STRESS_BOARD_SIZE);
+  std::vector<std::unique_ptr<Bomb>> bombs;
+  for (int i = 0; i < num_bombs; ++i) {
+    bombs.emplace_back(new Bomb(CellA(i)));
+    bombs.back()->SetEventQueue(&events);
+    bombs.back()->AttachIndex(&index);
+  }
+
+  for (auto &bomb : bombs) bomb->UseItem();
+
+  std::atomic<bool> burning{true};
+  std::atomic<long> reads{0};
+  std::atomic<long> badReads{0};
+  std::thread reader([&]() {
+    while (burning.load(std::memory_order_acquire)) {
+      for (int i = 0; i < num_bombs; ++i) {
+        GameElement::State state = bombs[i]->GetState();
+        bool bad = !IsBombColor(state.color) ||
+                   !(Same(state.location, CellA(i)) || Same(state.location, CellB(i)));
+        if (bad) badReads.fetch_add(1, std::memory_order_relaxed);
+      }
+      reads.fetch_add(num_bombs, std::memory_order_relaxed);
+    }
+  });
+
+  // move and flip every bomb until they have all gone off
+  int exploded = 0;
+  long moves = 0;
+  std::vector<bool> atB(num_bombs, false);
+  std::vector<bool> available(num_bombs, true);
+  while (exploded < num_bombs) {
+    for (int i = 0; i < num_bombs; ++i) {
+      atB[i] = !atB[i];
+      SDL_Point cell = atB[i] ? CellB(i) : CellA(i);
+      bombs[i]->SetLocation(cell.x, cell.y);
+      available[i] = !available[i];
+      if (available[i]) {
+        bombs[i]->SetAvailable();
+      } else {
+        bombs[i]->SetUnavailable();
+      }
+    }
+    moves += num_bombs;
+    events.Drain([&](const GameEvent &event) {
+      if (event.type == GameEventType::kBombExploded) ++exploded;
+    });
+    std::this_thread::yield();
+  }
+  burning.store(false, std::memory_order_release);
+  reader.join();
+
+  int lost = 0;
+  for (int i = 0; i < num_bombs; ++i) {
+    GameElement::State state = bombs[i]->GetState();
+    SDL_Point cell = atB[i] ? CellB(i) : CellA(i);
+    if (!(state.color == bombColor) || !Same(state.location, cell) || state.available != available[i]) ++lost;
+  }
+
+  std::cout << num_bombs << " bombs, " << moves << " moves, " << reads.load() << " reads, " << badReads.load()
+            << " inconsistent reads, " << lost << " bombs with a lost update" << std::endl;
+  return (badReads.load() == 0 && lost == 0) ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+/*
+    file: env_bench.cpp - steps a SnakeEnv batch with random actions and reports env-steps per second.
+
+    usage: SnakeEnvBench [num_envs] [steps] [grid_size] [ticks_per_step]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "random.h"
+#include "snake_env.h"
+
+int main(int argc, char **argv) {
+  int num_envs = argc > 1 ? std::atoi(argv[1]) : 64;
+  int steps = argc > 2 ? std::atoi(argv[2]) : 20000;
+  int grid = argc > 3 ? std::atoi(argv[3]) : 32;
+  int ticks_per_step = argc > 4 ? std::atoi(argv[4]) : 1;
+
+  SnakeEnv env(num_envs, grid, grid, ticks_per_step);
+
+  std::vector<uint64_t> observations(static_cast<std::size_t>(num_envs) * env.ObservationWords());
+  std::vector<int> actions(num_envs, kActionNone);
+  std::vector<float> rewards(num_envs);
+  std::vector<uint8_t> dones(num_envs);
+
+  env.Reset(1, observations.data());
+
+  Xoshiro256 bots = Xoshiro256::Stream(1, RandomStream::kBots);
+  uint64_t episodes = 0;
+  double total_reward = 0.0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int s = 0; s < steps; ++s) {
+    for (int &action : actions) {
+      // turn now and then
+      action = (bots.Below(16) == 0) ? static_cast<int>(bots.Below(ENV_NUM_ACTIONS)) : kActionNone;
+    }
+    env.Step(actions.data(), rewards.data(), dones.data(), observations.data());
+    for (int i = 0; i < num_envs; ++i) {
+      episodes += dones[i];
+      total_reward += rewards[i];
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  double env_steps = static_cast<double>(num_envs) * steps;
+  std::cout << num_envs << " envs x " << steps << " steps on a " << grid << "x" << grid << " board: "
+            << (env_steps / seconds) << " env-steps/sec, " << episodes << " episodes, mean reward per step "
+            << (total_reward / env_steps) << "\n";
+  return 0;
+}
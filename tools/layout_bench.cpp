@@ -0,0 +1,70 @@
+/*
+    file: layout_bench.cpp - generates every board layout at one size, on one thread and then on every core,
+    and times the generation, the connect pass and a separate flood fill that checks every open cell can be
+    reached from the snake's start. Fails if a layout has an unreachable cell, or if the two runs differ.
+
+    usage: SnakeLayoutBench [grid_size] [seed]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "board_layout.h"
+#include "flood_fill.h"
+
+static long CountBits(const BitBoard &bits) {
+  long count = 0;
+  for (std::size_t w = 0; w < bits.WordCount(); ++w) count += __builtin_popcountll(bits.Data()[w]);
+  return count;
+}
+
+int main(int argc, char **argv) {
+  int grid_size = argc > 1 ? std::atoi(argv[1]) : 4096;
+  uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1;
+  if (grid_size < 8) {
+    std::cerr << "grid_size must be at least 8" << std::endl;
+    return 1;
+  }
+
+  const BoardLayout layouts[] = {BoardLayout::kMaze, BoardLayout::kCave, BoardLayout::kRooms};
+  const SDL_Point start{grid_size / 2, grid_size / 2};
+  bool ok = true;
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << grid_size << "x" << grid_size << ", seed " << seed << std::endl;
+  std::cout << "layout     walls  regions  generate ms (1 thread / threads)  connect ms  tunnels  check ms  reachable"
+            << std::endl;
+  for (BoardLayout layout : layouts) {
+    BitBoard single(grid_size, grid_size);
+    LayoutStats one = GenerateLayout(layout, seed, start, single, 1);
+    BitBoard walls(grid_size, grid_size);
+    LayoutStats many = GenerateLayout(layout, seed, start, walls);
+    bool same = std::memcmp(single.Data(), walls.Data(), walls.WordCount() * sizeof(uint64_t)) == 0;
+
+    // fill from the start again, from scratch, and every open cell has to be in it
+    BitBoard open;
+    InvertBoard(walls, open);
+    BitBoard reached(grid_size, grid_size);
+    reached.Set(start.x, start.y);
+    auto begin = std::chrono::steady_clock::now();
+    FloodFill(open, reached, true);
+    double checkMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    long openCells = CountBits(open);
+    long reachedCells = CountBits(reached);
+    bool connected = reachedCells == openCells;
+
+    std::cout << std::left << std::setw(9) << LayoutName(layout) << std::right
+              << std::setw(6) << 100.0 * CountBits(walls) / (static_cast<double>(grid_size) * grid_size) << "%"
+              << std::setw(9) << many.regions
+              << std::setw(14) << one.generateMs << " / " << many.generateMs << " (" << many.threads << ")"
+              << std::setw(14) << many.connectMs
+              << std::setw(9) << many.tunnels
+              << std::setw(10) << checkMs
+              << "  " << reachedCells << " of " << openCells
+              << (same ? "" : "  (differs between thread counts)") << std::endl;
+    ok = ok && connected && same;
+  }
+  return ok ? 0 : 1;
+}
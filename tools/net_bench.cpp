@@ -0,0 +1,88 @@
+/*
+    file: net_bench.cpp - runs a NetServer and a growing number of bot clients over loopback in one process
+    and reports the server's tick time (and how much of it is stepping the game) and the bandwidth per client
+    for each player count. The bots all play on the server's one board, so the default board is big enough
+    for them to spread out the way players would; on a small one every snake is near every other and each
+    client gets all of them.
+
+    usage: SnakeNetBench [seconds_per_round] [grid_size] [ticks_per_second] [max_clients]
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "net_client.h"
+#include "net_server.h"
+#include "debug_log.h"
+
+int main(int argc, char **argv) {
+  int seconds = argc > 1 ? std::atoi(argv[1]) : 3;
+  int grid = argc > 2 ? std::atoi(argv[2]) : 256;
+  double ticks_per_second = argc > 3 ? std::atof(argv[3]) : 60.0;
+  int max_clients = argc > 4 ? std::atoi(argv[4]) : NET_MAX_CLIENTS;
+
+  std::cout << "clients  tick us  max us  update us  us/client  down B/s/client  up B/s/client  full  mispredicted" << std::endl;
+  for (int count = 1; count <= max_clients; count *= 2) {
+    NetServer server(grid, grid, ticks_per_second);
+    if (!server.Open(0)) return 1;
+    std::atomic<bool> running{true};
+    std::thread server_thread([&]() { server.Run(running, false); });
+
+    std::vector<std::unique_ptr<NetClient>> clients;
+    for (int i = 0; i < count; ++i) {
+      clients.emplace_back(new NetClient());
+      if (!clients.back()->Connect("127.0.0.1", server.Port())) return 1;
+    }
+    DebugLog::SetEnabled(false);
+
+    // warm up so every client has a baseline, then measure
+    FramePacer pacer(ticks_per_second, PacingMode::kSleepSpin);
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    auto run_for = [&](double duration) {
+      auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(duration);
+      while (std::chrono::steady_clock::now() < end) {
+        for (auto &client : clients) {
+          rng ^= rng << 13;
+          rng ^= rng >> 7;
+          rng ^= rng << 17;
+          if ((rng & 31) == 0) {
+            client->Input().Push(GameEventType::kInputTurn, {0, 0}, nullptr, GameElement::UNKNOWN_TYPE,
+                                 static_cast<int>((rng >> 8) & 3));
+          }
+          client->Tick();
+        }
+        pacer.Wait();
+      }
+    };
+    run_for(0.5);
+    server.TakeStats();
+    for (auto &client : clients) client->TakeStats();
+
+    run_for(seconds);
+    NetServerStats stats = server.TakeStats();
+    uint64_t received = 0;
+    uint64_t sent = 0;
+    uint64_t predictions = 0;
+    uint64_t mispredictions = 0;
+    for (auto &client : clients) {
+      NetClientStats c = client->TakeStats();
+      received += c.bytesReceived;
+      sent += c.bytesSent;
+      predictions += c.predictions;
+      mispredictions += c.mispredictions;
+    }
+
+    clients.clear();
+    running = false;
+    server_thread.join();
+
+    double per_client_seconds = static_cast<double>(count) * seconds;
+    std::cout << count << "  " << stats.meanTickUs << "  " << stats.maxTickUs << "  " << stats.meanUpdateUs << "  " << (stats.meanTickUs / count) << "  "
+              << (received / per_client_seconds) << "  " << (sent / per_client_seconds) << "  " << stats.fullSnapshots << "  "
+              << (predictions > 0 ? 100.0 * mispredictions / predictions : 0.0) << "%" << std::endl;
+  }
+  return 0;
+}
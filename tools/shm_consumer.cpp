@@ -0,0 +1,115 @@
+/*
+    file: shm_consumer.cpp - follows a running game through its shared memory export (build with SHM_EXPORT)
+    and reports once a second how many ticks it read, missed and had to re-copy, along with the game's state.
+
+    usage: SnakeShmConsumer [seconds] [--board]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "shm_reader.h"
+
+#define CONSUMER_POLL_US 200        // sleep between polls once caught up
+#define CONSUMER_IDLE_SECONDS 3     // stop when the game hasn't written a tick for this long
+
+// the board as text, head @, body o, food *, walls #, power-ups by their first letter
+static void PrintBoard(const ShmFrame &frame, int width, int height) {
+  for (int y = 0; y < height; ++y) {
+    std::string row(width, '.');
+    for (int x = 0; x < width; ++x) {
+      if (frame.Test(kPlaneHead, x, y)) row[x] = '@';
+      else if (frame.Test(kPlaneBody, x, y)) row[x] = 'o';
+      else if (frame.Test(kPlaneFood, x, y)) row[x] = '*';
+      else if (frame.Test(kPlaneWall, x, y)) row[x] = '#';
+      else if (frame.Test(kPlanePotion, x, y)) row[x] = 'P';
+      else if (frame.Test(kPlaneBomb, x, y)) row[x] = 'B';
+      else if (frame.Test(kPlaneShrinkPill, x, y)) row[x] = 'S';
+      else if (frame.Test(kPlaneSlowPill, x, y)) row[x] = 'L';
+    }
+    std::cout << row << "\n";
+  }
+}
+
+int main(int argc, char **argv) {
+  int seconds = 0;
+  bool board = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--board") == 0) board = true;
+    else seconds = std::atoi(argv[i]);
+  }
+
+  ShmReader reader;
+  std::cout << "Waiting for " << SHM_EXPORT_NAME << "..." << std::endl;
+  while (!reader.Open()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  }
+  const ShmHeader &header = reader.Header();
+  std::cout << "Reading a " << header.gridWidth << "x" << header.gridHeight << " board, " << header.ringSlots
+            << " slots of " << header.slotBytes << " bytes" << std::endl;
+
+  ShmFrame frame;
+  reader.InitFrame(frame);
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  Clock::time_point report_timestamp = start;
+  Clock::time_point last_tick_time = start;
+  uint64_t next = reader.LatestTick();
+  if (next == 0) next = 1;
+  uint64_t read = 0;
+  uint64_t missed = 0;
+  uint64_t total_read = 0;
+  uint64_t total_missed = 0;
+
+  while (true) {
+    uint64_t latest = reader.LatestTick();
+    Clock::time_point now = Clock::now();
+
+    // everything older than the ring is gone, skip straight to the oldest tick still there
+    if (latest >= next + static_cast<uint64_t>(header.ringSlots)) {
+      uint64_t oldest = latest - header.ringSlots + 1;
+      missed += oldest - next;
+      next = oldest;
+    }
+
+    bool progressed = false;
+    while (next <= latest) {
+      ShmReader::ReadResult result = reader.Read(next, frame);
+      if (result == ShmReader::ReadResult::kNotReady) break;
+      if (result == ShmReader::ReadResult::kOk) ++read;
+      else ++missed;
+      ++next;
+      progressed = true;
+    }
+    if (progressed) {
+      last_tick_time = now;
+    } else if (now - last_tick_time > std::chrono::seconds(CONSUMER_IDLE_SECONDS)) {
+      std::cout << "No new ticks for " << CONSUMER_IDLE_SECONDS << " seconds, stopping." << std::endl;
+      break;
+    }
+
+    if (now - report_timestamp >= std::chrono::seconds(1)) {
+      const ShmTickInfo &info = frame.info;
+      std::cout << "tick " << info.tick << "  score " << info.score << "  size " << info.size
+                << (info.alive ? "" : " (dead)") << "  x" << info.multiplier << "  game fps " << info.fps
+                << "  tick " << info.tickUs << " us  |  read " << read << "  missed " << missed
+                << "  torn " << reader.TornReads() << std::endl;
+      if (board) PrintBoard(frame, header.gridWidth, header.gridHeight);
+      total_read += read;
+      total_missed += missed;
+      read = 0;
+      missed = 0;
+      report_timestamp = now;
+    }
+
+    if (seconds > 0 && now - start >= std::chrono::seconds(seconds)) break;
+    if (!progressed) std::this_thread::sleep_for(std::chrono::microseconds(CONSUMER_POLL_US));
+  }
+
+  std::cout << "Read " << (total_read + read) << " ticks, missed " << (total_missed + missed) << ", "
+            << reader.TornReads() << " torn copies retried" << std::endl;
+  return 0;
+}
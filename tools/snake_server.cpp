@@ -0,0 +1,34 @@
+/*
+    file: snake_server.cpp - runs a NetServer until interrupted. Players join with SnakeGame --connect <host> [port].
+
+    usage: SnakeServer [port] [grid_size] [ticks_per_second]
+*/
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include "net_server.h"
+
+static std::atomic<bool> running{true};
+
+static void Stop(int) {
+  running = false;
+}
+
+int main(int argc, char **argv) {
+  int port = argc > 1 ? std::atoi(argv[1]) : NET_DEFAULT_PORT;
+  int grid = argc > 2 ? std::atoi(argv[2]) : 32;
+  double ticks_per_second = argc > 3 ? std::atof(argv[3]) : 60.0;
+
+  NetServer server(grid, grid, ticks_per_second);
+  if (!server.Open(static_cast<uint16_t>(port))) {
+    return 1;
+  }
+
+  std::signal(SIGINT, Stop);
+  std::signal(SIGTERM, Stop);
+  server.Run(running, true);
+  std::cout << "Server stopped." << std::endl;
+  return 0;
+}